@@ -0,0 +1,167 @@
+/*
+ * arena.c Is the source code for the arena allocator of mish. See the header
+ * file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "arena.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdalign.h>
+#include <errno.h>
+
+/* Defines */
+#define ARENA_ALIGN alignof(max_align_t)
+
+/*A chunk which the memory is taken from.*/
+struct chunk{
+	struct chunk *next;
+	size_t size;
+	size_t used;
+	alignas(max_align_t) char data[];
+};
+
+/*The arena type.*/
+struct arena{
+	struct chunk *chunks;	//The newest chunk first.
+	size_t chunk_size;
+};
+
+/*Function prototypes.*/
+static struct chunk *new_chunk(size_t size);
+
+
+/**
+ * arena_new() - Creates a new arena.
+ *
+ * @param chunk_size The size of each chunk. Larger allocations get a chunk
+ * of their own.
+ * @return A pointer to the new arena.
+ */
+arena *arena_new(size_t chunk_size){
+	arena *a = malloc(sizeof(*a));
+	if(a == NULL){
+		perror("arena.c");
+		exit(errno);
+	}
+	a->chunks = NULL;
+	a->chunk_size = chunk_size;
+	return a;
+}
+
+/**
+ * arena_alloc() - Allocates memory from the arena. The memory is aligned for
+ * any type and is not zeroed.
+ *
+ * @param a The arena.
+ * @param size The number of bytes.
+ * @return A pointer to the memory.
+ */
+void *arena_alloc(arena *a, size_t size){
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+	struct chunk *c = a->chunks;
+	if(c == NULL || c->size - c->used < size){
+		if(size > a->chunk_size){
+			//Put the large chunk behind the current one, which is not full.
+			c = new_chunk(size);
+			if(a->chunks != NULL){
+				c->next = a->chunks->next;
+				a->chunks->next = c;
+			}
+			else{
+				a->chunks = c;
+			}
+		}
+		else{
+			c = new_chunk(a->chunk_size);
+			c->next = a->chunks;
+			a->chunks = c;
+		}
+	}
+
+	void *mem = c->data + c->used;
+	c->used += size;
+	return mem;
+}
+
+/**
+ * arena_strdup() - Copies a string into the arena.
+ *
+ * @param a The arena.
+ * @param str The string to copy.
+ * @return The copy.
+ */
+char *arena_strdup(arena *a, const char *str){
+	size_t len = strlen(str) + 1;
+	char *copy = arena_alloc(a, len);
+	memcpy(copy, str, len);
+	return copy;
+}
+
+/**
+ * arena_reset() - Gives back all memory allocated from the arena, but keeps
+ * the first chunk for reuse.
+ *
+ * @param a The arena.
+ */
+void arena_reset(arena *a){
+	if(a->chunks == NULL){
+		return;
+	}
+
+	//Keep the oldest chunk, which has the normal size.
+	struct chunk *c = a->chunks;
+	while(c->next != NULL){
+		struct chunk *next = c->next;
+		free(c);
+		c = next;
+	}
+	if(c->size != a->chunk_size){
+		free(c);
+		c = NULL;
+	}
+	else{
+		c->used = 0;
+	}
+	a->chunks = c;
+}
+
+/**
+ * arena_kill() - Frees the arena and all memory allocated from it.
+ *
+ * @param a The arena.
+ */
+void arena_kill(arena *a){
+	struct chunk *c = a->chunks;
+	while(c != NULL){
+		struct chunk *next = c->next;
+		free(c);
+		c = next;
+	}
+	free(a);
+}
+
+/**
+ * new_chunk() - Allocates an empty chunk.
+ *
+ * @param size The number of bytes in the chunk.
+ * @return The new chunk.
+ */
+static struct chunk *new_chunk(size_t size){
+	struct chunk *c = malloc(sizeof(*c) + size);
+	if(c == NULL){
+		perror("arena.c");
+		exit(errno);
+	}
+	c->next = NULL;
+	c->size = size;
+	c->used = 0;
+	return c;
+}
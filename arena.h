@@ -0,0 +1,61 @@
+/*
+ * arena.h Is the header file for the arena allocator of mish. Memory is taken
+ * from large chunks by moving a pointer and is only given back all at once,
+ * which suits data like a parsed block of commands which lives exactly as
+ * long as the block.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+
+typedef struct arena arena;
+
+/**
+ * arena_new() - Creates a new arena.
+ *
+ * @param chunk_size The size of each chunk. Larger allocations get a chunk
+ * of their own.
+ * @return A pointer to the new arena.
+ */
+arena *arena_new(size_t chunk_size);
+
+/**
+ * arena_alloc() - Allocates memory from the arena. The memory is aligned for
+ * any type and is not zeroed.
+ *
+ * @param a The arena.
+ * @param size The number of bytes.
+ * @return A pointer to the memory.
+ */
+void *arena_alloc(arena *a, size_t size);
+
+/**
+ * arena_strdup() - Copies a string into the arena.
+ *
+ * @param a The arena.
+ * @param str The string to copy.
+ * @return The copy.
+ */
+char *arena_strdup(arena *a, const char *str);
+
+/**
+ * arena_reset() - Gives back all memory allocated from the arena, but keeps
+ * the first chunk for reuse.
+ *
+ * @param a The arena.
+ */
+void arena_reset(arena *a);
+
+/**
+ * arena_kill() - Frees the arena and all memory allocated from it.
+ *
+ * @param a The arena.
+ */
+void arena_kill(arena *a);
+
+#endif /* ARENA_H_ */
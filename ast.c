@@ -0,0 +1,547 @@
+/*
+ * ast.c Is the source code for the compound commands of mish. See the header
+ * file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "ast.h"
+#include "arena.h"
+#include "vars.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* Defines */
+#define BLOCK_ARENA_CHUNK 4096
+#define BLOCK_FIRST_COMMANDS 16
+
+/*The block type.*/
+struct ast_block{
+	arena *memory;		//The copied commands and the nodes.
+	command *commands;
+	int number_of_commands;
+	int size;
+	int depth;		//The number of open compound commands.
+	int position;		//The next command to build a node from.
+	int error;
+};
+
+/*Function prototypes.*/
+static int is_keyword_position(command *commands, int index);
+static int depth_change(command *cmd);
+static void copy_command(ast_block *b, command *to, const command *from);
+static ast_node *new_node(ast_block *b, int kind);
+static ast_node *build_list(ast_block *b, const char *const *stops);
+static ast_node *build_commands(ast_block *b);
+static ast_node *build_if(ast_block *b);
+static ast_node *build_while(ast_block *b);
+static ast_node *build_for(ast_block *b);
+static ast_node *build_group(ast_block *b, int kind, const char *keyword, \
+		const char *const *stops);
+static const char *current_word(ast_block *b);
+static int consume_keyword(ast_block *b, const char *keyword);
+static int consume_closing(ast_block *b, const char *keyword);
+static void syntax_error(ast_block *b, const char *word);
+
+/*The keywords, and the keywords which end the lists of each part.*/
+static const char *const keywords[] = {"if", "then", "elif", "else", "fi", \
+		"while", "for", "do", "done", "{", "}", "(", ")", NULL};
+static const char *const then_stops[] = {"then", NULL};
+static const char *const if_body_stops[] = {"elif", "else", "fi", NULL};
+static const char *const else_stops[] = {"fi", NULL};
+static const char *const do_stops[] = {"do", NULL};
+static const char *const done_stops[] = {"done", NULL};
+static const char *const brace_stops[] = {"}", NULL};
+static const char *const paren_stops[] = {")", NULL};
+
+
+/**
+ * ast_has_keyword() - Checks if a parsed line starts a compound command or
+ * has a keyword anywhere, so it has to be run as a block.
+ *
+ * @param commands The parsed commands of the line.
+ * @param number_of_commands The number of commands.
+ * @return 1 if the line has a keyword, else 0.
+ */
+int ast_has_keyword(command *commands, int number_of_commands){
+	for(int i = 0; i < number_of_commands; i++){
+		if(is_keyword_position(commands, i) && \
+				ast_is_keyword(commands[i].argv[0])){
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * ast_is_keyword() - Checks if a word is a keyword. A word with quotes is not.
+ *
+ * @param word The word.
+ * @return 1 if the word is a keyword, else 0.
+ */
+int ast_is_keyword(const char *word){
+	for(int i = 0; keywords[i] != NULL; i++){
+		if(strcmp(word, keywords[i]) == 0){
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * ast_block_new() - Creates an empty block.
+ *
+ * @return The new block.
+ */
+ast_block *ast_block_new(void){
+	ast_block *b = calloc(1, sizeof(*b));
+	if(b == NULL){
+		perror("ast.c");
+		exit(errno);
+	}
+	b->memory = arena_new(BLOCK_ARENA_CHUNK);
+	return b;
+}
+
+/**
+ * ast_block_add() - Copies the parsed commands of a line into the block.
+ *
+ * @param b The block.
+ * @param commands The parsed commands of the line.
+ * @param number_of_commands The number of commands.
+ * @return The number of compound commands which are still open, 0 if the
+ * block is complete or -1 on a syntax error.
+ */
+int ast_block_add(ast_block *b, command *commands, int number_of_commands){
+	if(b->number_of_commands + number_of_commands > b->size){
+		int size = b->size > 0 ? b->size : BLOCK_FIRST_COMMANDS;
+		while(size < b->number_of_commands + number_of_commands){
+			size *= 2;
+		}
+		command *grown = realloc(b->commands, size * sizeof(command));
+		if(grown == NULL){
+			perror("ast.c");
+			exit(errno);
+		}
+		b->commands = grown;
+		b->size = size;
+	}
+
+	for(int i = 0; i < number_of_commands; i++){
+		if(is_keyword_position(commands, i)){
+			b->depth += depth_change(&commands[i]);
+			if(b->depth < 0){
+				syntax_error(b, commands[i].argv[0]);
+				return -1;
+			}
+		}
+		copy_command(b, &b->commands[b->number_of_commands++], &commands[i]);
+	}
+	return b->depth;
+}
+
+/**
+ * ast_block_build() - Builds the tree of a complete block. The tree lives as
+ * long as the block.
+ *
+ * @param b The block.
+ * @return The first node of the tree or NULL on a syntax error.
+ */
+ast_node *ast_block_build(ast_block *b){
+	b->position = 0;
+	b->error = 0;
+
+	ast_node *first = build_list(b, NULL);
+	if(b->error){
+		return NULL;
+	}
+	return first;
+}
+
+/**
+ * ast_block_kill() - Frees the block and its tree.
+ *
+ * @param b The block.
+ */
+void ast_block_kill(ast_block *b){
+	arena_kill(b->memory);
+	free(b->commands);
+	free(b);
+}
+
+/**
+ * is_keyword_position() - Checks if a command starts a new list, where its
+ * first word may be a keyword. That is the case at the start of a line and
+ * after ";" or "&".
+ *
+ * @param commands The commands.
+ * @param index The index of the command.
+ * @return 1 if the first word may be a keyword, else 0.
+ */
+static int is_keyword_position(command *commands, int index){
+	if(index == 0){
+		return 1;
+	}
+	int separator = commands[index-1].separator;
+	return separator == SEP_SEQ || separator == SEP_ASYNC || \
+			separator == SEP_END;
+}
+
+/**
+ * depth_change() - Counts how a command changes the number of open compound
+ * commands. The keywords "then", "else", "elif", "do", "{" and "(" may be
+ * followed by another keyword.
+ *
+ * @param cmd The command at a keyword position.
+ * @return The change of the depth.
+ */
+static int depth_change(command *cmd){
+	int change = 0;
+	for(int i = 0; i < cmd->argc && ast_is_keyword(cmd->argv[i]); i++){
+		const char *word = cmd->argv[i];
+		if(strcmp(word, "if") == 0 || strcmp(word, "while") == 0 || \
+				strcmp(word, "for") == 0){
+			return change + 1; //The rest is the condition or the words.
+		}
+		if(strcmp(word, "{") == 0 || strcmp(word, "(") == 0){
+			change++;
+		}
+		if(strcmp(word, "fi") == 0 || strcmp(word, "done") == 0 || \
+				strcmp(word, "}") == 0 || strcmp(word, ")") == 0){
+			change--;
+		}
+	}
+	return change;
+}
+
+/**
+ * copy_command() - Copies a parsed command and its words into the arena of
+ * the block.
+ *
+ * @param b The block.
+ * @param to The copy.
+ * @param from The parsed command.
+ */
+static void copy_command(ast_block *b, command *to, const command *from){
+	*to = *from;
+	to->argv = arena_alloc(b->memory, (from->argc + 1) * sizeof(char *));
+	for(int i = 0; i < from->argc; i++){
+		to->argv[i] = arena_strdup(b->memory, from->argv[i]);
+	}
+	to->argv[from->argc] = NULL;
+
+	if(from->infile != NULL){
+		to->infile = arena_strdup(b->memory, from->infile);
+	}
+	if(from->outfile != NULL){
+		to->outfile = arena_strdup(b->memory, from->outfile);
+	}
+}
+
+/**
+ * new_node() - Allocates a zeroed node in the arena of the block.
+ *
+ * @param b The block.
+ * @param kind The kind of the node.
+ * @return The node.
+ */
+static ast_node *new_node(ast_block *b, int kind){
+	ast_node *node = arena_alloc(b->memory, sizeof(*node));
+	memset(node, 0, sizeof(*node));
+	node->kind = kind;
+	return node;
+}
+
+/**
+ * build_list() - Builds the nodes of a list until one of the stop keywords
+ * or the end of the block. The stop keyword is not consumed.
+ *
+ * @param b The block.
+ * @param stops The keywords which end the list or NULL.
+ * @return The first node of the list or NULL if it is empty.
+ */
+static ast_node *build_list(ast_block *b, const char *const *stops){
+	ast_node *first = NULL;
+	ast_node **link = &first;
+
+	while(b->position < b->number_of_commands && !b->error){
+		const char *word = current_word(b);
+		int stop = 0;
+		for(int i = 0; stops != NULL && stops[i] != NULL; i++){
+			stop |= strcmp(word, stops[i]) == 0;
+		}
+		if(stop){
+			break;
+		}
+
+		ast_node *node;
+		if(strcmp(word, "if") == 0){
+			node = build_if(b);
+		}
+		else if(strcmp(word, "while") == 0){
+			node = build_while(b);
+		}
+		else if(strcmp(word, "for") == 0){
+			node = build_for(b);
+		}
+		else if(strcmp(word, "{") == 0){
+			node = build_group(b, AST_GROUP, "}", brace_stops);
+		}
+		else if(strcmp(word, "(") == 0){
+			node = build_group(b, AST_SUBSHELL, ")", paren_stops);
+		}
+		else if(ast_is_keyword(word)){
+			syntax_error(b, word);
+			node = NULL;
+		}
+		else{
+			node = build_commands(b);
+		}
+
+		if(node == NULL){
+			break;
+		}
+		*link = node;
+		link = &node->next;
+	}
+	return first;
+}
+
+/**
+ * build_commands() - Builds a node of the commands up to the next keyword.
+ *
+ * @param b The block.
+ * @return The node.
+ */
+static ast_node *build_commands(ast_block *b){
+	ast_node *node = new_node(b, AST_COMMANDS);
+	int start = b->position++;
+
+	while(b->position < b->number_of_commands && \
+			!(is_keyword_position(b->commands, b->position) && \
+			ast_is_keyword(current_word(b)))){
+		b->position++;
+	}
+
+	node->commands = &b->commands[start];
+	node->number_of_commands = b->position - start;
+	return node;
+}
+
+/**
+ * build_if() - Builds an if node, with the elif parts as if nodes in the
+ * else part.
+ *
+ * @param b The block, at the "if" or "elif".
+ * @return The node or NULL on a syntax error.
+ */
+static ast_node *build_if(ast_block *b){
+	ast_node *node = new_node(b, AST_IF);
+
+	consume_keyword(b, current_word(b));
+	node->condition = build_list(b, then_stops);
+	if(node->condition == NULL || consume_keyword(b, "then") < 0){
+		syntax_error(b, current_word(b));
+		return NULL;
+	}
+	node->body = build_list(b, if_body_stops);
+	if(node->body == NULL){
+		syntax_error(b, current_word(b));
+		return NULL;
+	}
+
+	const char *word = current_word(b);
+	if(strcmp(word, "elif") == 0){
+		node->otherwise = build_if(b); //Consumes the "fi".
+		return node->otherwise != NULL ? node : NULL;
+	}
+	if(strcmp(word, "else") == 0){
+		consume_keyword(b, "else");
+		node->otherwise = build_list(b, else_stops);
+		if(node->otherwise == NULL){
+			syntax_error(b, current_word(b));
+			return NULL;
+		}
+	}
+	if(consume_closing(b, "fi") < 0){
+		return NULL;
+	}
+	return node;
+}
+
+/**
+ * build_while() - Builds a while node.
+ *
+ * @param b The block, at the "while".
+ * @return The node or NULL on a syntax error.
+ */
+static ast_node *build_while(ast_block *b){
+	ast_node *node = new_node(b, AST_WHILE);
+
+	consume_keyword(b, "while");
+	node->condition = build_list(b, do_stops);
+	if(node->condition == NULL || consume_keyword(b, "do") < 0){
+		syntax_error(b, current_word(b));
+		return NULL;
+	}
+	node->body = build_list(b, done_stops);
+	if(node->body == NULL){
+		syntax_error(b, current_word(b));
+		return NULL;
+	}
+	if(consume_closing(b, "done") < 0){
+		return NULL;
+	}
+	return node;
+}
+
+/**
+ * build_for() - Builds a for node. The name and the words must be in the
+ * same command as the "for".
+ *
+ * @param b The block, at the "for".
+ * @return The node or NULL on a syntax error.
+ */
+static ast_node *build_for(ast_block *b){
+	ast_node *node = new_node(b, AST_FOR);
+	command *cmd = &b->commands[b->position];
+
+	if(cmd->argc < 3 || !vars_is_name(cmd->argv[1]) || \
+			strcmp(cmd->argv[2], "in") != 0 || cmd->infile != NULL || \
+			cmd->outfile != NULL || (cmd->separator != SEP_SEQ && \
+			cmd->separator != SEP_END)){
+		fprintf(stderr, "Usage: for name in words; do list; done\n");
+		b->error = 1;
+		return NULL;
+	}
+	node->name = cmd->argv[1];
+	node->words = cmd->argv + 3;
+	node->number_of_words = cmd->argc - 3;
+	b->position++;
+
+	if(consume_keyword(b, "do") < 0){
+		syntax_error(b, current_word(b));
+		return NULL;
+	}
+	node->body = build_list(b, done_stops);
+	if(node->body == NULL){
+		syntax_error(b, current_word(b));
+		return NULL;
+	}
+	if(consume_closing(b, "done") < 0){
+		return NULL;
+	}
+	return node;
+}
+
+/**
+ * build_group() - Builds a group node. The closing word must stand alone,
+ * but it may have redirections.
+ *
+ * @param b The block, at the "{" or "(".
+ * @param kind AST_GROUP or AST_SUBSHELL.
+ * @param keyword The closing word, "}" or ")".
+ * @param stops The list of the closing word.
+ * @return The node or NULL on a syntax error.
+ */
+static ast_node *build_group(ast_block *b, int kind, const char *keyword, \
+		const char *const *stops){
+	ast_node *node = new_node(b, kind);
+
+	consume_keyword(b, current_word(b));
+	node->body = build_list(b, stops);
+	if(node->body == NULL){
+		syntax_error(b, current_word(b));
+		return NULL;
+	}
+
+	command *cmd = &b->commands[b->position];
+	if(strcmp(current_word(b), keyword) != 0 || cmd->argc != 1 || \
+			(cmd->separator != SEP_SEQ && cmd->separator != SEP_END)){
+		syntax_error(b, current_word(b));
+		return NULL;
+	}
+	node->closing = cmd;
+	b->position++;
+	return node;
+}
+
+/**
+ * current_word() - Gets the first word of the current command.
+ *
+ * @param b The block.
+ * @return The word or "" at the end of the block.
+ */
+static const char *current_word(ast_block *b){
+	if(b->position >= b->number_of_commands){
+		return "";
+	}
+	return b->commands[b->position].argv[0];
+}
+
+/**
+ * consume_keyword() - Removes a keyword from the start of the current
+ * command. The command is consumed when nothing is left of it.
+ *
+ * @param b The block.
+ * @param keyword The expected keyword.
+ * @return 0 on success or -1 if the command does not start with it.
+ */
+static int consume_keyword(ast_block *b, const char *keyword){
+	if(strcmp(current_word(b), keyword) != 0){
+		return -1;
+	}
+
+	command *cmd = &b->commands[b->position];
+	cmd->argv++;
+	cmd->argc--;
+	if(cmd->argc == 0){
+		if(cmd->infile != NULL || cmd->outfile != NULL || \
+				(cmd->separator != SEP_SEQ && cmd->separator != SEP_END)){
+			syntax_error(b, keyword);
+			return -1;
+		}
+		b->position++;
+	}
+	return 0;
+}
+
+/**
+ * consume_closing() - Consumes "fi" or "done", which must stand alone.
+ *
+ * @param b The block.
+ * @param keyword The expected keyword.
+ * @return 0 on success or -1 on a syntax error.
+ */
+static int consume_closing(ast_block *b, const char *keyword){
+	if(strcmp(current_word(b), keyword) != 0 || \
+			b->commands[b->position].argc != 1){
+		syntax_error(b, current_word(b));
+		return -1;
+	}
+	return consume_keyword(b, keyword);
+}
+
+/**
+ * syntax_error() - Reports a syntax error once per build.
+ *
+ * @param b The block.
+ * @param word The word the error is near, "" at the end of the block.
+ */
+static void syntax_error(ast_block *b, const char *word){
+	if(!b->error){
+		if(*word == '\0'){
+			fprintf(stderr, "Syntax error: unexpected end of block\n");
+		}
+		else{
+			fprintf(stderr, "Syntax error near %s\n", word);
+		}
+	}
+	b->error = 1;
+}
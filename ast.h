@@ -0,0 +1,118 @@
+/*
+ * ast.h Is the header file for the compound commands of mish:
+ *
+ *   if list; then list; [elif list; then list;] ... [else list;] fi
+ *   while list; do list; done
+ *   for name in words; do list; done
+ *   { list; } [< file] [> file]
+ *   ( list ) [< file] [> file]
+ *
+ * A compound command may span several lines. The parsed lines are added to a
+ * block until every compound command in it is closed, and the block is then
+ * built into a tree of nodes. The tree holds copies of the parsed commands,
+ * so a loop body is parsed once and run any number of times.
+ *
+ * A keyword is only recognised as the first word of a pipeline. "then",
+ * "else", "elif", "do", "{" and "(" may be followed by a command on the same
+ * line, "fi", "done", "}" and ")" must stand alone, but "}" and ")" may have
+ * redirections, which are applied to the whole group. A quoted or escaped
+ * keyword, like "fi" or \}, is an ordinary word. The words keep their quotes,
+ * see PARSE_KEEP_QUOTES in parser.h, so it never equals the keyword.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef AST_H_
+#define AST_H_
+
+#include "parser.h"
+
+/*The kinds of nodes.*/
+#define AST_COMMANDS	0	//A command line without compound commands.
+#define AST_IF		1
+#define AST_WHILE	2
+#define AST_FOR		3
+#define AST_GROUP	4	//{ list; }
+#define AST_SUBSHELL	5	//( list )
+
+/*A node of the tree. The nodes of a list are linked through next.*/
+typedef struct ast_node{
+	int kind;
+	struct ast_node *next;
+
+	//AST_COMMANDS: The commands, with their separators, run as one line.
+	command *commands;
+	int number_of_commands;
+
+	//AST_IF and AST_WHILE: The condition and the body. The else part of an
+	//if is in otherwise, an elif is an if node there.
+	struct ast_node *condition;
+	struct ast_node *body;
+	struct ast_node *otherwise;
+
+	//AST_FOR: The variable and the words it is set to, the body is in body.
+	char *name;
+	char **words;
+	int number_of_words;
+
+	//AST_GROUP and AST_SUBSHELL: The closing "}" or ")", which holds the
+	//redirections of the group. The list is in body.
+	command *closing;
+}ast_node;
+
+typedef struct ast_block ast_block;
+
+/**
+ * ast_has_keyword() - Checks if a parsed line starts a compound command or
+ * has a keyword anywhere, so it has to be run as a block.
+ *
+ * @param commands The parsed commands of the line.
+ * @param number_of_commands The number of commands.
+ * @return 1 if the line has a keyword, else 0.
+ */
+int ast_has_keyword(command *commands, int number_of_commands);
+
+/**
+ * ast_is_keyword() - Checks if a word is a keyword. A word with quotes is not.
+ *
+ * @param word The word.
+ * @return 1 if the word is a keyword, else 0.
+ */
+int ast_is_keyword(const char *word);
+
+/**
+ * ast_block_new() - Creates an empty block.
+ *
+ * @return The new block.
+ */
+ast_block *ast_block_new(void);
+
+/**
+ * ast_block_add() - Copies the parsed commands of a line into the block.
+ *
+ * @param b The block.
+ * @param commands The parsed commands of the line.
+ * @param number_of_commands The number of commands.
+ * @return The number of compound commands which are still open, 0 if the
+ * block is complete or -1 on a syntax error.
+ */
+int ast_block_add(ast_block *b, command *commands, int number_of_commands);
+
+/**
+ * ast_block_build() - Builds the tree of a complete block. The tree lives as
+ * long as the block.
+ *
+ * @param b The block.
+ * @return The first node of the tree or NULL on a syntax error.
+ */
+ast_node *ast_block_build(ast_block *b);
+
+/**
+ * ast_block_kill() - Frees the block and its tree.
+ *
+ * @param b The block.
+ */
+void ast_block_kill(ast_block *b);
+
+#endif /* AST_H_ */
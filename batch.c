@@ -0,0 +1,290 @@
+/*
+ * batch.c Is the source code for the batch stage of mish. See the header file
+ * for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "batch.h"
+#include "execute.h"
+#include "arena.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/* Defines */
+#define BATCH_ARENA_CHUNK (1024 * 1024)
+#define BATCH_FAILED 123
+#define BATCH_NOT_FOUND 127
+
+/*The runs of a batch stage and the items of the next run.*/
+typedef struct batch_state{
+	const char *path;	//The file of the command.
+	char **argv;	//The words and the items of the next run.
+	int fixed;	//The number of words before the items.
+	int used;	//The number of words in argv.
+	int size;	//The room for words in argv.
+	long limit;	//The bytes of items which fit in one exec.
+	long room;	//The bytes of items left for the next run.
+	long max_item;	//The longest item the kernel takes.
+	int max_items;	//The most items of a run, 0 for no limit.
+	int jobs;
+	int running;
+	int status;
+	arena *items;	//The items of the next run.
+}batch_state;
+
+extern char **environ;
+
+/*Function prototypes.*/
+static int parse_number(const char *text, int *number);
+static long argument_bytes(char **words, int number_of_words);
+static void add_item(batch_state *state, const char *item, size_t len);
+static void start_run(batch_state *state);
+static void wait_for_run(batch_state *state);
+
+
+/**
+ * batch_main() - Runs the batch stage on stdin.
+ *
+ * @param argc The number of words, starting with "batch".
+ * @param argv The words.
+ * @return The exit status of the stage.
+ */
+int batch_main(int argc, char **argv){
+	batch_state state;
+	memset(&state, 0, sizeof(state));
+	state.jobs = 1;
+	int delimiter = '\n';
+
+	int opt;
+	optind = 0;
+	while((opt = getopt(argc, argv, "+P:n:0")) != -1){
+		switch(opt){
+		case 'P':
+			if(parse_number(optarg, &state.jobs) < 0 || \
+					state.jobs > BATCH_MAX_JOBS){
+				fprintf(stderr, "batch: bad number of jobs: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'n':
+			if(parse_number(optarg, &state.max_items) < 0){
+				fprintf(stderr, "batch: bad number of items: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case '0':
+			delimiter = '\0';
+			break;
+		default:
+			fprintf(stderr, "Usage: batch [-P JOBS] [-n MAX] [-0] command "
+					"[word]...\n");
+			return 1;
+		}
+	}
+	if(optind >= argc){
+		fprintf(stderr, "Usage: batch [-P JOBS] [-n MAX] [-0] command "
+				"[word]...\n");
+		return 1;
+	}
+
+	//The command is looked up once instead of by every exec.
+	char path[PATH_MAX];
+	state.path = argv[optind];
+	if(strchr(argv[optind], '/') == NULL){
+		if(find_command(argv[optind], path, sizeof(path)) < 0){
+			fprintf(stderr, "batch: %s: command not found\n", argv[optind]);
+			return BATCH_NOT_FOUND;
+		}
+		state.path = path;
+	}
+
+	state.fixed = argc - optind;
+	state.limit = sysconf(_SC_ARG_MAX) - BATCH_ARG_HEADROOM - \
+			argument_bytes(environ, -1) - \
+			argument_bytes(argv + optind, state.fixed);
+	if(state.limit <= 0){
+		fprintf(stderr, "batch: no room for arguments\n");
+		return 1;
+	}
+	//Linux takes no single string longer than 32 pages.
+	state.max_item = 32 * sysconf(_SC_PAGESIZE);
+	state.room = state.limit;
+
+	state.size = state.fixed + 64;
+	state.argv = malloc(state.size * sizeof(char *));
+	if(state.argv == NULL){
+		perror("batch.c");
+		exit(errno);
+	}
+	memcpy(state.argv, argv + optind, state.fixed * sizeof(char *));
+	state.used = state.fixed;
+	state.items = arena_new(BATCH_ARENA_CHUNK);
+
+	char *line = NULL;
+	size_t line_size = 0;
+	ssize_t len;
+	while((len = getdelim(&line, &line_size, delimiter, stdin)) >= 0){
+		if(len > 0 && line[len-1] == delimiter){
+			len--;
+		}
+		if(len > 0){
+			add_item(&state, line, len);
+		}
+	}
+	if(state.used > state.fixed){
+		start_run(&state);
+	}
+	while(state.running > 0){
+		wait_for_run(&state);
+	}
+
+	free(line);
+	free(state.argv);
+	arena_kill(state.items);
+	return state.status;
+}
+
+/**
+ * parse_number() - Parses a number of at least 1.
+ *
+ * @param text The text.
+ * @param number Set to the number.
+ * @return 0 on success or -1 if the text is not such a number.
+ */
+static int parse_number(const char *text, int *number){
+	char *end;
+	errno = 0;
+	long value = strtol(text, &end, 10);
+	if(errno != 0 || end == text || *end != '\0' || value < 1 || \
+			value > INT_MAX){
+		return -1;
+	}
+	*number = value;
+	return 0;
+}
+
+/**
+ * argument_bytes() - Counts the bytes which some strings take in the
+ * arguments of an exec, the strings and the pointers to them.
+ *
+ * @param words The strings.
+ * @param number_of_words The number of strings, or -1 if the array ends with
+ * NULL.
+ * @return The number of bytes.
+ */
+static long argument_bytes(char **words, int number_of_words){
+	long bytes = 0;
+	for(int i = 0; number_of_words < 0 ? words[i] != NULL : \
+			i < number_of_words; i++){
+		bytes += strlen(words[i]) + 1 + sizeof(char *);
+	}
+	//The NULL which ends the array.
+	return bytes + sizeof(char *);
+}
+
+/**
+ * add_item() - Adds an item to the next run. The next run is started first
+ * if the item does not fit in it.
+ *
+ * @param state The state of the stage.
+ * @param item The item, which does not need to end with a NUL.
+ * @param len The length of the item.
+ */
+static void add_item(batch_state *state, const char *item, size_t len){
+	long bytes = len + 1 + sizeof(char *);
+	if(bytes > state->limit || (long)len + 1 > state->max_item){
+		fprintf(stderr, "batch: item too long: %.32s...\n", item);
+		state->status = BATCH_FAILED;
+		return;
+	}
+
+	int items = state->used - state->fixed;
+	if(bytes > state->room || \
+			(state->max_items > 0 && items == state->max_items)){
+		start_run(state);
+	}
+
+	//Room for the item and the NULL which ends argv.
+	if(state->used + 2 > state->size){
+		state->size *= 2;
+		state->argv = realloc(state->argv, state->size * sizeof(char *));
+		if(state->argv == NULL){
+			perror("batch.c");
+			exit(errno);
+		}
+	}
+	char *copy = arena_alloc(state->items, len + 1);
+	memcpy(copy, item, len);
+	copy[len] = '\0';
+	state->argv[state->used++] = copy;
+	state->room -= bytes;
+}
+
+/**
+ * start_run() - Forks a child which executes the command with the items of
+ * the next run, after waiting for a run to finish if JOBS are running. The
+ * items are then given back, the child has its own copy.
+ *
+ * @param state The state of the stage.
+ */
+static void start_run(batch_state *state){
+	while(state->running >= state->jobs){
+		wait_for_run(state);
+	}
+
+	state->argv[state->used] = NULL;
+	pid_t pid = fork();
+	if(pid < 0){
+		perror("batch");
+		state->status = BATCH_FAILED;
+	}
+	else if(pid == 0){
+		int null_fd = open("/dev/null", O_RDONLY);
+		if(null_fd >= 0){
+			dup2(null_fd, STDIN_FILENO);
+			close(null_fd);
+		}
+		execv(state->path, state->argv);
+		perror(state->argv[0]);
+		_exit(BATCH_NOT_FOUND);
+	}
+	else{
+		state->running++;
+	}
+
+	arena_reset(state->items);
+	state->used = state->fixed;
+	state->room = state->limit;
+}
+
+/**
+ * wait_for_run() - Waits for a run to finish and keeps its failure.
+ *
+ * @param state The state of the stage.
+ */
+static void wait_for_run(batch_state *state){
+	int wait_status;
+	if(wait(&wait_status) < 0){
+		if(errno != EINTR){
+			state->running = 0;
+		}
+		return;
+	}
+	state->running--;
+	if(!WIFEXITED(wait_status) || WEXITSTATUS(wait_status) != 0){
+		state->status = BATCH_FAILED;
+	}
+}
@@ -0,0 +1,45 @@
+/*
+ * batch.h Is the header file for the batch stage of mish, which runs a
+ * command with the items read from its stdin as arguments, like xargs:
+ *
+ *   batch [-P JOBS] [-n MAX] [-0] command [word]...
+ *
+ * The items are the lines of stdin, or the strings ended by NUL bytes with
+ * -0. Empty items are skipped. Every run of the command gets as many items
+ * as fit in the arguments of one exec, which is ARG_MAX as given by
+ * sysconf(_SC_ARG_MAX) less the size of the environment and of the words
+ * before the items, or at most MAX items with -n. The command is not run if
+ * there are no items.
+ *
+ * With -P up to JOBS runs are started at the same time. The command is looked
+ * up in PATH once, see find_command() in execute.h, and every run executes
+ * the file found. The runs get /dev/null as stdin.
+ *
+ * The stage runs in the forked child of the pipeline instead of an external
+ * command. Its exit status is 0 if every run exited with 0, 123 if a run did
+ * not or an item was too long for an exec, and 127 if the command was not
+ * found.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef BATCH_H_
+#define BATCH_H_
+
+/*Room kept free in the arguments of an exec, for the file name and slack.*/
+#define BATCH_ARG_HEADROOM 4096
+
+/*The most runs which may be started at the same time.*/
+#define BATCH_MAX_JOBS 1024
+
+/**
+ * batch_main() - Runs the batch stage on stdin.
+ *
+ * @param argc The number of words, starting with "batch".
+ * @param argv The words.
+ * @return The exit status of the stage.
+ */
+int batch_main(int argc, char **argv);
+
+#endif /* BATCH_H_ */
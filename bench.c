@@ -0,0 +1,303 @@
+/*
+ * bench.c Is the source code for the bench prefix of mish. See the header
+ * file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "bench.h"
+#include "stats.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+
+/* Defines */
+#define BENCH_USAGE "Usage: bench [-n RUNS] [-w WARMUP] [-o FILE] pipeline\n"
+#define NSEC_PER_USEC 1000L
+#define NSEC_PER_SEC 1000000000L
+
+/*The summary of one measurement over all runs.*/
+typedef struct bench_summary{
+	uint64_t min;
+	uint64_t median;
+	uint64_t p95;
+	uint64_t max;
+	double mean;
+	double stddev;
+}bench_summary;
+
+/*Writes a value of a measurement, STATS_TIME_TEXT_LEN long.*/
+typedef void (*bench_format)(char *text, uint64_t value);
+
+/*Function prototypes.*/
+static int parse_count(const char *text, int min, int *count);
+static void summarize(uint64_t *values, int number_of_values, \
+		bench_summary *summary);
+static int compare_values(const void *a, const void *b);
+static void print_summary(const char *name, uint64_t *values, \
+		int number_of_values, bench_format format);
+static void format_rss(char *text, uint64_t kilobytes);
+static uint64_t timeval_nsec(const struct timeval *tv);
+static int write_csv(const char *path, const bench_sample *samples, \
+		int number_of_samples);
+
+
+/**
+ * bench_parse() - Parses the options of the bench prefix.
+ *
+ * @param spec The benchmark to fill in.
+ * @param argc The number of words, starting with "bench".
+ * @param argv The words.
+ * @return The number of words used by the prefix, or -1 on a bad option.
+ */
+int bench_parse(bench_spec *spec, int argc, char **argv){
+	spec->runs = BENCH_DEFAULT_RUNS;
+	spec->warmup = 0;
+	spec->csv_path = NULL;
+
+	int opt;
+	optind = 0;
+	while((opt = getopt(argc, argv, "+n:w:o:")) != -1){
+		switch(opt){
+		case 'n':
+			if(parse_count(optarg, 1, &spec->runs) < 0){
+				fprintf(stderr, "bench: bad number of runs: %s\n", optarg);
+				return -1;
+			}
+			break;
+		case 'w':
+			if(parse_count(optarg, 0, &spec->warmup) < 0){
+				fprintf(stderr, "bench: bad number of warmup runs: %s\n", \
+						optarg);
+				return -1;
+			}
+			break;
+		case 'o':
+			spec->csv_path = optarg;
+			break;
+		default:
+			fprintf(stderr, BENCH_USAGE);
+			return -1;
+		}
+	}
+
+	if(optind >= argc){
+		fprintf(stderr, BENCH_USAGE);
+		return -1;
+	}
+	return optind;
+}
+
+/**
+ * bench_report() - Prints the summary of the measured runs to stderr and
+ * writes the samples to the CSV file if one was asked for.
+ *
+ * @param spec The benchmark.
+ * @param samples The samples of the measured runs.
+ * @param number_of_samples The number of samples.
+ * @param name The command of the first stage of the pipeline.
+ * @return 0 on success or -1 if the CSV file could not be written.
+ */
+int bench_report(const bench_spec *spec, const bench_sample *samples, \
+		int number_of_samples, const char *name){
+	uint64_t *values = malloc(number_of_samples * sizeof(*values));
+	if(values == NULL){
+		perror("bench.c");
+		exit(errno);
+	}
+
+	int failed = 0;
+	for(int i = 0; i < number_of_samples; i++){
+		if(samples[i].status != 0){
+			failed++;
+		}
+	}
+	fprintf(stderr, "bench: %s, %d runs after %d warmup, %d failed\n", name, \
+			number_of_samples, spec->warmup, failed);
+	fprintf(stderr, "%-10s%10s%10s%10s%10s%10s%10s\n", "", "min", "median", \
+			"p95", "max", "mean", "stddev");
+
+	for(int i = 0; i < number_of_samples; i++){
+		values[i] = samples[i].wall;
+	}
+	print_summary("wall", values, number_of_samples, stats_format_time);
+	for(int i = 0; i < number_of_samples; i++){
+		values[i] = timeval_nsec(&samples[i].usage.ru_utime);
+	}
+	print_summary("user", values, number_of_samples, stats_format_time);
+	for(int i = 0; i < number_of_samples; i++){
+		values[i] = timeval_nsec(&samples[i].usage.ru_stime);
+	}
+	print_summary("system", values, number_of_samples, stats_format_time);
+	for(int i = 0; i < number_of_samples; i++){
+		values[i] = samples[i].usage.ru_maxrss;
+	}
+	print_summary("max rss", values, number_of_samples, format_rss);
+	free(values);
+
+	if(spec->csv_path != NULL && \
+			write_csv(spec->csv_path, samples, number_of_samples) < 0){
+		perror(spec->csv_path);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * parse_count() - Parses a whole number of runs.
+ *
+ * @param text The text to parse.
+ * @param min The smallest number which is allowed.
+ * @param count The parsed number.
+ * @return 0 on success or -1 on a bad number.
+ */
+static int parse_count(const char *text, int min, int *count){
+	char *end;
+	errno = 0;
+	long value = strtol(text, &end, 10);
+	if(errno != 0 || end == text || *end != '\0' || value < min || \
+			value > BENCH_MAX_RUNS){
+		return -1;
+	}
+	*count = (int)value;
+	return 0;
+}
+
+/**
+ * summarize() - Sorts the values of a measurement and sums them up. The
+ * percentiles are taken by nearest rank and the standard deviation is the
+ * one of a sample.
+ *
+ * @param values The values, sorted in place.
+ * @param number_of_values The number of values, at least 1.
+ * @param summary The summary to fill in.
+ */
+static void summarize(uint64_t *values, int number_of_values, \
+		bench_summary *summary){
+	int n = number_of_values;
+	qsort(values, n, sizeof(*values), compare_values);
+
+	summary->min = values[0];
+	summary->max = values[n-1];
+	summary->median = n % 2 == 1 ? values[n/2] : \
+			values[n/2-1] + (values[n/2] - values[n/2-1]) / 2;
+	summary->p95 = values[(n * 95 + 99) / 100 - 1];
+
+	double sum = 0;
+	for(int i = 0; i < n; i++){
+		sum += values[i];
+	}
+	summary->mean = sum / n;
+
+	double squares = 0;
+	for(int i = 0; i < n && n > 1; i++){
+		double diff = values[i] - summary->mean;
+		squares += diff * diff;
+	}
+	summary->stddev = n > 1 ? sqrt(squares / (n - 1)) : 0;
+}
+
+/**
+ * compare_values() - Compares two values for qsort().
+ *
+ * @param a The first value.
+ * @param b The second value.
+ * @return Less than, equal to or greater than 0 as a is to b.
+ */
+static int compare_values(const void *a, const void *b){
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * print_summary() - Prints one line of the summary table.
+ *
+ * @param name The name of the measurement.
+ * @param values The values of the runs, sorted in place.
+ * @param number_of_values The number of values.
+ * @param format How a value is written.
+ */
+static void print_summary(const char *name, uint64_t *values, \
+		int number_of_values, bench_format format){
+	bench_summary summary;
+	char text[6][STATS_TIME_TEXT_LEN];
+
+	summarize(values, number_of_values, &summary);
+	format(text[0], summary.min);
+	format(text[1], summary.median);
+	format(text[2], summary.p95);
+	format(text[3], summary.max);
+	format(text[4], (uint64_t)(summary.mean + 0.5));
+	format(text[5], (uint64_t)(summary.stddev + 0.5));
+	fprintf(stderr, "%-10s%10s%10s%10s%10s%10s%10s\n", name, text[0], \
+			text[1], text[2], text[3], text[4], text[5]);
+}
+
+/**
+ * format_rss() - Writes a resident set size with a unit which keeps it short.
+ *
+ * @param text The buffer, STATS_TIME_TEXT_LEN long.
+ * @param kilobytes The size in kilobytes, like ru_maxrss.
+ */
+static void format_rss(char *text, uint64_t kilobytes){
+	if(kilobytes < 1024){
+		snprintf(text, STATS_TIME_TEXT_LEN, "%luKB", (unsigned long)kilobytes);
+	}
+	else if(kilobytes < 1024 * 1024){
+		snprintf(text, STATS_TIME_TEXT_LEN, "%.1fMB", kilobytes / 1024.0);
+	}
+	else{
+		snprintf(text, STATS_TIME_TEXT_LEN, "%.2fGB", \
+				kilobytes / (1024.0 * 1024.0));
+	}
+}
+
+/**
+ * timeval_nsec() - Converts a time from rusage to nanoseconds.
+ *
+ * @param tv The time.
+ * @return The time in nanoseconds.
+ */
+static uint64_t timeval_nsec(const struct timeval *tv){
+	return (uint64_t)tv->tv_sec * NSEC_PER_SEC + tv->tv_usec * NSEC_PER_USEC;
+}
+
+/**
+ * write_csv() - Writes the samples as CSV with a header line. The times are
+ * in nanoseconds and the rss in kilobytes.
+ *
+ * @param path The file to write, it is replaced if it exists.
+ * @param samples The samples.
+ * @param number_of_samples The number of samples.
+ * @return 0 on success or -1 on failure.
+ */
+static int write_csv(const char *path, const bench_sample *samples, \
+		int number_of_samples){
+	FILE *file = fopen(path, "w");
+	if(file == NULL){
+		return -1;
+	}
+
+	fprintf(file, "run,wall_ns,user_ns,system_ns,max_rss_kb,status\n");
+	for(int i = 0; i < number_of_samples; i++){
+		fprintf(file, "%d,%llu,%llu,%llu,%ld,%d\n", i + 1, \
+				(unsigned long long)samples[i].wall, \
+				(unsigned long long)timeval_nsec(&samples[i].usage.ru_utime), \
+				(unsigned long long)timeval_nsec(&samples[i].usage.ru_stime), \
+				samples[i].usage.ru_maxrss, samples[i].status);
+	}
+
+	if(ferror(file)){
+		fclose(file);
+		return -1;
+	}
+	return fclose(file);
+}
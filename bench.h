@@ -0,0 +1,68 @@
+/*
+ * bench.h Is the header file for the bench prefix of mish:
+ *
+ *   bench [-n RUNS] [-w WARMUP] [-o FILE] pipeline
+ *
+ * The pipeline is run WARMUP times without being measured and then RUNS times,
+ * one run after another. Every run is forked and executed like any other
+ * pipeline of the shell, so no extra process or shell is measured with it.
+ * For every run the wall time on the monotonic clock is kept together with
+ * the user and system time and the largest resident set of its children,
+ * which wait4() gives when they are reaped.
+ *
+ * When the runs are done, the min, median, p95, max, mean and standard
+ * deviation are printed to stderr. With -o the samples are also written to
+ * FILE as CSV, one line per measured run. The defaults are 10 runs and no
+ * warmup. The runs stop early if one of them is stopped or interrupted, and
+ * bench waits for its runs also when it is followed by "&".
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+#include <sys/resource.h>
+
+#define BENCH_DEFAULT_RUNS 10
+#define BENCH_MAX_RUNS 1000000
+
+typedef struct bench_spec{
+	int runs;
+	int warmup;
+	const char *csv_path;	//Where the samples are written, or NULL.
+}bench_spec;
+
+/*The measurements of one run.*/
+typedef struct bench_sample{
+	uint64_t wall;		//Nanoseconds from the start to the last reaped child.
+	struct rusage usage;	//The summed times and largest rss of the children.
+	int status;		//The exit status of the run.
+}bench_sample;
+
+/**
+ * bench_parse() - Parses the options of the bench prefix.
+ *
+ * @param spec The benchmark to fill in.
+ * @param argc The number of words, starting with "bench".
+ * @param argv The words.
+ * @return The number of words used by the prefix, or -1 on a bad option.
+ */
+int bench_parse(bench_spec *spec, int argc, char **argv);
+
+/**
+ * bench_report() - Prints the summary of the measured runs to stderr and
+ * writes the samples to the CSV file if one was asked for.
+ *
+ * @param spec The benchmark.
+ * @param samples The samples of the measured runs.
+ * @param number_of_samples The number of samples.
+ * @param name The command of the first stage of the pipeline.
+ * @return 0 on success or -1 if the CSV file could not be written.
+ */
+int bench_report(const bench_spec *spec, const bench_sample *samples, \
+		int number_of_samples, const char *name);
+
+#endif /* BENCH_H_ */
@@ -0,0 +1,340 @@
+/*
+ * buffer.c Is the source code for the buffer stage of mish. See the header
+ * file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "buffer.h"
+#include "ring.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/*The state which the reader and the writer share.*/
+typedef struct buffer_state{
+	ring ring;
+	int in_fd;
+	int out_fd;
+	size_t high;		//Fill to drain to after the ring was full.
+	size_t low;		//Fill to wait for after the ring was empty.
+	atomic_int input_done;	//The reader has stopped.
+	atomic_int output_failed;	//The writer has stopped early.
+	atomic_int sleepers;	//Threads waiting on changed.
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	int status;
+}buffer_state;
+
+/*Function prototypes.*/
+static int parse_size(const char *text, size_t *size);
+static int parse_percent(const char *text, int *percent);
+static void *reader_thread(void *arg);
+static void *writer_thread(void *arg);
+static int reader_may_run(buffer_state *state, int throttled);
+static int writer_may_run(buffer_state *state, size_t needed);
+static void wait_for_change(buffer_state *state, int is_reader, \
+		int throttled, size_t needed);
+static void notify(buffer_state *state);
+
+
+/**
+ * buffer_main() - Runs the buffer stage from stdin to stdout.
+ *
+ * @param argc The number of words, starting with "buffer".
+ * @param argv The words.
+ * @return The exit status of the stage.
+ */
+int buffer_main(int argc, char **argv){
+	size_t size = BUFFER_DEFAULT_SIZE;
+	int high = 100;
+	int low = 0;
+
+	int opt;
+	optind = 0;
+	while((opt = getopt(argc, argv, "+m:H:L:")) != -1){
+		switch(opt){
+		case 'm':
+			if(parse_size(optarg, &size) < 0){
+				fprintf(stderr, "buffer: bad size: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'H':
+			if(parse_percent(optarg, &high) < 0){
+				fprintf(stderr, "buffer: bad high watermark: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'L':
+			if(parse_percent(optarg, &low) < 0){
+				fprintf(stderr, "buffer: bad low watermark: %s\n", optarg);
+				return 1;
+			}
+			break;
+		default:
+			fprintf(stderr, "Usage: buffer [-m SIZE] [-H PERCENT] "
+					"[-L PERCENT]\n");
+			return 1;
+		}
+	}
+	if(optind != argc){
+		fprintf(stderr, "Usage: buffer [-m SIZE] [-H PERCENT] [-L PERCENT]\n");
+		return 1;
+	}
+
+	buffer_state state;
+	memset(&state, 0, sizeof(state));
+	if(ring_init(&state.ring, size) < 0){
+		return 1;
+	}
+	state.in_fd = STDIN_FILENO;
+	state.out_fd = STDOUT_FILENO;
+	state.high = state.ring.size / 100 * high;
+	state.low = state.ring.size / 100 * low;
+	pthread_mutex_init(&state.lock, NULL);
+	pthread_cond_init(&state.changed, NULL);
+
+	pthread_t reader, writer;
+	if(pthread_create(&reader, NULL, reader_thread, &state) != 0){
+		fprintf(stderr, "buffer: could not start the reader\n");
+		return 1;
+	}
+	if(pthread_create(&writer, NULL, writer_thread, &state) != 0){
+		fprintf(stderr, "buffer: could not start the writer\n");
+		atomic_store(&state.output_failed, 1);
+		notify(&state);
+		pthread_join(reader, NULL);
+		return 1;
+	}
+	pthread_join(reader, NULL);
+	pthread_join(writer, NULL);
+
+	pthread_cond_destroy(&state.changed);
+	pthread_mutex_destroy(&state.lock);
+	ring_destroy(&state.ring);
+	return state.status;
+}
+
+/**
+ * parse_size() - Parses a size like "4096", "64k", "16M" or "1G".
+ *
+ * @param text The text to parse.
+ * @param size The parsed size.
+ * @return 0 on success or -1 on a bad size.
+ */
+static int parse_size(const char *text, size_t *size){
+	char *unit;
+	errno = 0;
+	unsigned long long value = strtoull(text, &unit, 10);
+	if(errno != 0 || unit == text || value == 0){
+		return -1;
+	}
+
+	int shift = 0;
+	if(*unit == 'k' || *unit == 'K'){
+		shift = 10;
+	}
+	else if(*unit == 'm' || *unit == 'M'){
+		shift = 20;
+	}
+	else if(*unit == 'g' || *unit == 'G'){
+		shift = 30;
+	}
+	else if(*unit != '\0'){
+		return -1;
+	}
+	if(shift > 0 && unit[1] != '\0'){
+		return -1;
+	}
+	if(value > (SIZE_MAX >> shift)){
+		return -1;
+	}
+	*size = (size_t)value << shift;
+	return 0;
+}
+
+/**
+ * parse_percent() - Parses a percentage from 0 to 100.
+ *
+ * @param text The text to parse.
+ * @param percent The parsed percentage.
+ * @return 0 on success or -1 on a bad percentage.
+ */
+static int parse_percent(const char *text, int *percent){
+	char *end;
+	long value = strtol(text, &end, 10);
+	if(end == text || (*end != '\0' && strcmp(end, "%") != 0) || \
+			value < 0 || value > 100){
+		return -1;
+	}
+	*percent = (int)value;
+	return 0;
+}
+
+/**
+ * reader_thread() - Reads the input into the ring until end of file or until
+ * the writer has stopped.
+ *
+ * @param arg The buffer_state.
+ * @return NULL.
+ */
+static void *reader_thread(void *arg){
+	buffer_state *state = arg;
+	int throttled = 0;
+
+	while(!atomic_load(&state->output_failed)){
+		if(!reader_may_run(state, throttled)){
+			wait_for_change(state, 1, throttled, 0);
+			continue;
+		}
+		throttled = 0;
+
+		size_t len;
+		char *space = ring_write_region(&state->ring, &len);
+		ssize_t n = read(state->in_fd, space, len);
+		if(n < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			perror("buffer: read");
+			state->status = 1;
+			break;
+		}
+		if(n == 0){
+			break;
+		}
+		ring_commit_write(&state->ring, n);
+		notify(state);
+
+		if(ring_fill(&state->ring) == state->ring.size && \
+				state->high < state->ring.size){
+			throttled = 1;
+		}
+	}
+
+	atomic_store(&state->input_done, 1);
+	notify(state);
+	return NULL;
+}
+
+/**
+ * writer_thread() - Writes the data in the ring to the output until the ring
+ * is empty and the input has ended.
+ *
+ * @param arg The buffer_state.
+ * @return NULL.
+ */
+static void *writer_thread(void *arg){
+	buffer_state *state = arg;
+	size_t needed = state->low > 0 ? state->low : 1;
+
+	while(1){
+		if(!writer_may_run(state, needed)){
+			wait_for_change(state, 0, 0, needed);
+			continue;
+		}
+
+		size_t len;
+		char *data = ring_read_region(&state->ring, &len);
+		if(len == 0){ //The input has ended and everything is written.
+			break;
+		}
+		ssize_t n = write(state->out_fd, data, len);
+		if(n < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			perror("buffer: write");
+			state->status = 1;
+			atomic_store(&state->output_failed, 1);
+			notify(state);
+			break;
+		}
+		ring_commit_read(&state->ring, n);
+		notify(state);
+
+		needed = 1;
+		if(ring_fill(&state->ring) == 0 && state->low > 0){
+			needed = state->low;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * reader_may_run() - Checks if the reader can go on. A throttled reader waits
+ * until the ring has drained to the high watermark.
+ *
+ * @param state The buffer state.
+ * @param throttled 1 if the ring has been full.
+ * @return 1 if the reader can go on, else 0.
+ */
+static int reader_may_run(buffer_state *state, int throttled){
+	size_t fill = ring_fill(&state->ring);
+	if(atomic_load(&state->output_failed)){
+		return 1;
+	}
+	if(throttled){
+		return fill <= state->high;
+	}
+	return fill < state->ring.size;
+}
+
+/**
+ * writer_may_run() - Checks if the writer can go on, which it can when the
+ * ring has the needed fill or the input has ended.
+ *
+ * @param state The buffer state.
+ * @param needed The fill the writer waits for.
+ * @return 1 if the writer can go on, else 0.
+ */
+static int writer_may_run(buffer_state *state, size_t needed){
+	return ring_fill(&state->ring) >= needed || \
+			atomic_load(&state->input_done);
+}
+
+/**
+ * wait_for_change() - Sleeps until the thread may go on. The sleeper count
+ * is raised before the condition is checked again, and the other thread
+ * changes the ring before it reads the count, so a wakeup is never lost.
+ *
+ * @param state The buffer state.
+ * @param is_reader 1 for the reader, 0 for the writer.
+ * @param throttled If the reader is throttled.
+ * @param needed The fill the writer waits for.
+ */
+static void wait_for_change(buffer_state *state, int is_reader, \
+		int throttled, size_t needed){
+	pthread_mutex_lock(&state->lock);
+	atomic_fetch_add(&state->sleepers, 1);
+	while(is_reader ? !reader_may_run(state, throttled) : \
+			!writer_may_run(state, needed)){
+		pthread_cond_wait(&state->changed, &state->lock);
+	}
+	atomic_fetch_sub(&state->sleepers, 1);
+	pthread_mutex_unlock(&state->lock);
+}
+
+/**
+ * notify() - Wakes the other thread if it sleeps. The lock is only taken
+ * when a thread sleeps, so the data path stays free of locks.
+ *
+ * @param state The buffer state.
+ */
+static void notify(buffer_state *state){
+	if(atomic_load(&state->sleepers) > 0){
+		pthread_mutex_lock(&state->lock);
+		pthread_cond_broadcast(&state->changed);
+		pthread_mutex_unlock(&state->lock);
+	}
+}
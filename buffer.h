@@ -0,0 +1,37 @@
+/*
+ * buffer.h Is the header file for the buffer stage of mish:
+ *
+ *   buffer [-m SIZE] [-H PERCENT] [-L PERCENT]
+ *
+ * The stage copies its stdin to its stdout through a large ring buffer, so a
+ * bursty producer and a bursty consumer do not stall each other like they do
+ * on a small pipe. It runs in the forked child of the pipeline instead of an
+ * external command. A reader thread fills the ring and a writer thread
+ * empties it, see ring.h.
+ *
+ * SIZE is a number of bytes with an optional k, M or G. With -H the reader
+ * stops when the ring is full and starts again when it has drained to
+ * PERCENT. With -L the writer waits until the ring is PERCENT full before it
+ * writes, and again every time it has emptied the ring, unless the input has
+ * ended.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef BUFFER_H_
+#define BUFFER_H_
+
+/*The size of the ring if -m is not given.*/
+#define BUFFER_DEFAULT_SIZE (16 * 1024 * 1024)
+
+/**
+ * buffer_main() - Runs the buffer stage from stdin to stdout.
+ *
+ * @param argc The number of words, starting with "buffer".
+ * @param argv The words.
+ * @return The exit status of the stage.
+ */
+int buffer_main(int argc, char **argv);
+
+#endif /* BUFFER_H_ */
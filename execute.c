@@ -14,6 +14,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
 
 /* Duplicate a pipe to a standard I/O file descriptor
  * Arguments:	pip	the pipe
@@ -46,11 +48,13 @@ int dupPipe(int pip[2], int end, int destfd){
  * 			or writing
  * 		destfd	the standard I/O file descriptor which shall be
  *			redirected
+ * 		An existing file is refused only when flags has O_CREAT,
+ * 		and the opened file is closed once it is duplicated
  * Returns:	-1 on error, else destfd
  */
 int redirect(char *filename, int flags, int destfd){
-	if( access( filename, F_OK ) != -1 ) {
-	    // file exists
+	if( (flags & O_CREAT) && access( filename, F_OK ) != -1 ) {
+	    // file exists, only input may come from an existing file
 		fprintf(stderr, "File already exists!\n");
 		return -1;
 	}
@@ -64,6 +68,39 @@ int redirect(char *filename, int flags, int destfd){
     if(ret < 0){
         perror(filename);
     }
+    if(fd != destfd){
+        close(fd);
+    }
 
     return ret;
 }
+
+/* Find a command in the directories of PATH, like execvp() does
+ * Arguments:	name	the name of the command, without a '/'
+ *		path	the buffer for the path of the command
+ *		size	the size of the buffer
+ * Returns:	-1 if no executable file was found, else 0
+ */
+int find_command(const char *name, char *path, size_t size){
+    const char *search = getenv("PATH");
+    if(search == NULL){
+        search = "/bin:/usr/bin";
+    }
+
+    while(1){
+        const char *end = strchrnul(search, ':');
+        int dir_len = end - search;
+        struct stat st;
+        //An empty directory in PATH is the working directory.
+        int len = snprintf(path, size, "%.*s%s%s", dir_len, search, \
+        		dir_len > 0 ? "/" : "", name);
+        if(len > 0 && (size_t)len < size && stat(path, &st) == 0 && \
+        		S_ISREG(st.st_mode) && access(path, X_OK) == 0){
+            return 0;
+        }
+        if(*end == '\0'){
+            return -1;
+        }
+        search = end + 1;
+    }
+}
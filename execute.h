@@ -19,11 +19,22 @@
  * Modified by: Dennis Olsson
  * Date:	2007-10-18
  * What?	Added the constants READ_END and WRITE_END
+ *
+ * Modified by: Bram Coenen
+ * Date:	2026-10-18
+ * What?	Added find_command() which searches PATH like execvp()
+ *
+ * Modified by: Bram Coenen
+ * Date:	2026-10-18
+ * What?	redirect() reads from existing files and closes the file it
+ *		opened
  */
 
 #ifndef _EXECUTE_
 #define _EXECUTE_
 
+#include <stddef.h>
+
 /* Constants for adressing pipes without using numbers */
 #ifndef READ_END
 #define READ_END 0
@@ -50,8 +61,19 @@ int dupPipe(int pip[2], int end, int destfd);
  * 			or writing
  * 		destfd	the standard I/O file descriptor which shall be
  *			redirected
+ * 		An existing file is refused only when flags has O_CREAT,
+ * 		and the opened file is closed once it is duplicated
  * Returns:	-1 on error, else destfd
  */
 int redirect(char *filename, int flags, int destfd);
 
+
+/* Find a command in the directories of PATH, like execvp() does
+ * Arguments:	name	the name of the command, without a '/'
+ *		path	the buffer for the path of the command
+ *		size	the size of the buffer
+ * Returns:	-1 if no executable file was found, else 0
+ */
+int find_command(const char *name, char *path, size_t size);
+
 #endif
@@ -0,0 +1,282 @@
+/*
+ * fanout.c Is the source code for the fan-out of mish. See the header file
+ * for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "fanout.h"
+#include "execute.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Defines */
+#define FANOUT_CHUNK (1 << 20)	//Most bytes asked for in one round.
+
+/*The state of a fan-out. The chunk of a round is the data at the head of
+ *the input pipe, which is only taken from it when every output has it.*/
+typedef struct fanout{
+	int in_fd;
+	int *out_fds;
+	int open;		//The number of outputs which are not dropped.
+	int scratch[2];		//A pipe the chunk is copied through, or -1.
+	char *copy;		//The chunk in memory, if it was needed.
+	int have_copy;		//If copy holds the chunk of this round.
+}fanout;
+
+/*Function prototypes.*/
+static int copy_round(fanout *f, size_t chunk);
+static int copy_rest(fanout *f, int output, size_t chunk, size_t done);
+static int read_chunk(fanout *f, size_t chunk);
+static int move_chunk(fanout *f, size_t chunk);
+static void drop_output(fanout *f, int output);
+static int write_all(int fd, const char *buf, size_t len);
+
+
+/**
+ * fanout_copy() - Copies everything read from a pipe to several pipes until
+ * end of file or until every output is closed by its reader. The output fds
+ * are closed when they are done with.
+ *
+ * @param in_fd The read end of the pipe of the producer.
+ * @param out_fds The write ends of the pipes of the consumers.
+ * @param number_of_outputs The number of outputs.
+ * @return 0 on success or -1 on failure.
+ */
+int fanout_copy(int in_fd, int *out_fds, int number_of_outputs){
+	fanout f = {in_fd, out_fds, number_of_outputs, {-1, -1}, NULL, 0};
+	int ret = 0;
+
+	while(f.open > 0 && ret == 0){
+		ssize_t n;
+		if(f.open == 1){ //Nothing to copy, only move.
+			n = splice(in_fd, NULL, out_fds[0], NULL, FANOUT_CHUNK, \
+					SPLICE_F_MOVE);
+		}
+		else{ //The first output decides how large the chunk is.
+			n = tee(in_fd, out_fds[0], FANOUT_CHUNK, 0);
+		}
+
+		if(n == 0){
+			break;
+		}
+		else if(n < 0){
+			if(errno == EPIPE){
+				drop_output(&f, 0);
+			}
+			else if(errno != EINTR){
+				perror("fan-out");
+				ret = -1;
+			}
+		}
+		else if(f.open > 1){
+			ret = copy_round(&f, n);
+		}
+	}
+
+	while(f.open > 0){
+		drop_output(&f, 0);
+	}
+	if(f.scratch[READ_END] >= 0){
+		close(f.scratch[READ_END]);
+		close(f.scratch[WRITE_END]);
+	}
+	free(f.copy);
+	return ret;
+}
+
+/**
+ * copy_round() - Gives the chunk to the outputs after the first, which
+ * already has it, and takes it from the input. The last output gets it moved
+ * with splice(), the others get it with tee().
+ *
+ * @param f The fan-out.
+ * @param chunk The size of the chunk.
+ * @return 0 on success or -1 on failure.
+ */
+static int copy_round(fanout *f, size_t chunk){
+	f->have_copy = 0;
+
+	for(int i = 1; i < f->open - 1; i++){
+		ssize_t n;
+		do{
+			n = tee(f->in_fd, f->out_fds[i], chunk, 0);
+		}while(n < 0 && errno == EINTR);
+
+		if(n < 0 && errno == EPIPE){
+			drop_output(f, i);
+			i--; //The output moved into its place has not been served.
+		}
+		else if(n < 0){
+			perror("fan-out");
+			return -1;
+		}
+		else if((size_t)n < chunk){
+			//The output was full, tee() can not start in the middle.
+			int ret = copy_rest(f, i, chunk, n);
+			if(ret < 0){
+				return -1;
+			}
+			i -= ret;
+		}
+	}
+
+	return move_chunk(f, chunk);
+}
+
+/**
+ * copy_rest() - Writes the part of the chunk which tee() could not give an
+ * output. The chunk is read into memory through the scratch pipe once.
+ *
+ * @param f The fan-out.
+ * @param output The index of the output.
+ * @param chunk The size of the chunk.
+ * @param done How much of the chunk the output has.
+ * @return 0 on success, 1 if the output was dropped or -1 on failure.
+ */
+static int copy_rest(fanout *f, int output, size_t chunk, size_t done){
+	if(!f->have_copy && read_chunk(f, chunk) < 0){
+		return -1;
+	}
+
+	if(write_all(f->out_fds[output], f->copy + done, chunk - done) < 0){
+		if(errno != EPIPE){
+			perror("fan-out");
+			return -1;
+		}
+		drop_output(f, output);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * read_chunk() - Reads the chunk into memory without taking it from the
+ * input. It is copied with tee() to the empty scratch pipe, which has as many
+ * slots as the input, so all of it fits, and read from there.
+ *
+ * @param f The fan-out.
+ * @param chunk The size of the chunk.
+ * @return 0 on success or -1 on failure.
+ */
+static int read_chunk(fanout *f, size_t chunk){
+	if(f->copy == NULL){
+		int size = fcntl(f->in_fd, F_GETPIPE_SZ);
+		if(size < 0 || pipe2(f->scratch, O_CLOEXEC) < 0 || \
+				fcntl(f->scratch[WRITE_END], F_SETPIPE_SZ, size) < 0){
+			perror("fan-out");
+			return -1;
+		}
+		f->copy = malloc(size);
+		if(f->copy == NULL){
+			perror("fanout.c");
+			exit(errno);
+		}
+	}
+
+	ssize_t n;
+	do{
+		n = tee(f->in_fd, f->scratch[WRITE_END], chunk, 0);
+	}while(n < 0 && errno == EINTR);
+	if(n != (ssize_t)chunk){
+		perror("fan-out");
+		return -1;
+	}
+
+	for(size_t got = 0; got < chunk; ){
+		n = read(f->scratch[READ_END], f->copy + got, chunk - got);
+		if(n <= 0){
+			if(n < 0 && errno == EINTR){
+				continue;
+			}
+			perror("fan-out");
+			return -1;
+		}
+		got += n;
+	}
+	f->have_copy = 1;
+	return 0;
+}
+
+/**
+ * move_chunk() - Moves the chunk from the input to the last output. If the
+ * last output is dropped, the rest of the chunk is read and thrown away.
+ *
+ * @param f The fan-out.
+ * @param chunk The size of the chunk.
+ * @return 0 on success or -1 on failure.
+ */
+static int move_chunk(fanout *f, size_t chunk){
+	while(chunk > 0 && f->open > 1){
+		ssize_t n = splice(f->in_fd, NULL, f->out_fds[f->open-1], NULL, \
+				chunk, SPLICE_F_MOVE);
+		if(n > 0){
+			chunk -= n;
+		}
+		else if(n < 0 && errno == EPIPE){
+			drop_output(f, f->open-1);
+		}
+		else if(n < 0 && errno != EINTR){
+			perror("fan-out");
+			return -1;
+		}
+	}
+
+	//Only the first output was left, it already has the chunk.
+	while(chunk > 0){
+		char discard[4096];
+		ssize_t n = read(f->in_fd, discard, \
+				chunk < sizeof(discard) ? chunk : sizeof(discard));
+		if(n <= 0){
+			if(n < 0 && errno == EINTR){
+				continue;
+			}
+			perror("fan-out");
+			return -1;
+		}
+		chunk -= n;
+	}
+	return 0;
+}
+
+/**
+ * drop_output() - Closes an output and moves the last output into its place.
+ *
+ * @param f The fan-out.
+ * @param output The index of the output.
+ */
+static void drop_output(fanout *f, int output){
+	close(f->out_fds[output]);
+	f->out_fds[output] = f->out_fds[f->open-1];
+	f->open--;
+}
+
+/**
+ * write_all() - Writes the whole buffer to a file descriptor.
+ *
+ * @param fd The file descriptor to write to.
+ * @param buf The data.
+ * @param len The length of the data.
+ * @return 0 on success or -1 on failure.
+ */
+static int write_all(int fd, const char *buf, size_t len){
+	while(len > 0){
+		ssize_t n = write(fd, buf, len);
+		if(n < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
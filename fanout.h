@@ -0,0 +1,35 @@
+/*
+ * fanout.h Is the header file for the fan-out of mish. With "|+" the output
+ * of one producer is given to several consumers:
+ *
+ *   producer |+ consumer |+ consumer ...
+ *
+ * Every consumer may be a pipeline of its own, "|" binds harder than "|+".
+ * The producer writes to one pipe and a helper process copies what is in it
+ * to one pipe per consumer. The copy is made with tee(), which only adds
+ * references to the pages of the pipe, and the last consumer gets the data
+ * moved to it with splice(), so the data is never copied to user space.
+ *
+ * A consumer which exits early is dropped and the others go on. A slow
+ * consumer holds back the others once its pipe is full.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef FANOUT_H_
+#define FANOUT_H_
+
+/**
+ * fanout_copy() - Copies everything read from a pipe to several pipes until
+ * end of file or until every output is closed by its reader. The output fds
+ * are closed when they are done with.
+ *
+ * @param in_fd The read end of the pipe of the producer.
+ * @param out_fds The write ends of the pipes of the consumers.
+ * @param number_of_outputs The number of outputs.
+ * @return 0 on success or -1 on failure.
+ */
+int fanout_copy(int in_fd, int *out_fds, int number_of_outputs);
+
+#endif /* FANOUT_H_ */
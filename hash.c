@@ -0,0 +1,74 @@
+/*
+ * hash.c Is the source code for the non-cryptographic hash used by mish. See
+ * the header file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "hash.h"
+
+/*Include default libraries */
+#include <string.h>
+
+/* Defines */
+#define HASH_MULTIPLIER 0x9e3779b97f4a7c15ULL
+
+/*Function prototypes.*/
+static uint64_t mix(uint64_t h);
+
+
+/**
+ * hash_bytes() - Hashes a block of data.
+ *
+ * @param data The data to hash.
+ * @param len The length of the data.
+ * @param seed A seed, for example the hash of earlier data to chain hashes.
+ * @return The 64 bit hash.
+ */
+uint64_t hash_bytes(const void *data, size_t len, uint64_t seed){
+	const unsigned char *bytes = data;
+	uint64_t h = seed ^ (len * HASH_MULTIPLIER);
+
+	while(len >= sizeof(uint64_t)){
+		uint64_t word;
+		memcpy(&word, bytes, sizeof(word));
+		h = (h ^ mix(word)) * HASH_MULTIPLIER;
+		bytes += sizeof(word);
+		len -= sizeof(word);
+	}
+
+	uint64_t tail = 0;
+	memcpy(&tail, bytes, len);
+	h = (h ^ mix(tail)) * HASH_MULTIPLIER;
+
+	return mix(h);
+}
+
+/**
+ * hash_string() - Hashes a string without its terminating null byte.
+ *
+ * @param str The string to hash.
+ * @param seed A seed, for example the hash of earlier data to chain hashes.
+ * @return The 64 bit hash.
+ */
+uint64_t hash_string(const char *str, uint64_t seed){
+	return hash_bytes(str, strlen(str), seed);
+}
+
+/**
+ * mix() - Spreads the bits of a word over the whole word (the finalizer of
+ * MurmurHash3).
+ *
+ * @param h The word.
+ * @return The mixed word.
+ */
+static uint64_t mix(uint64_t h){
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
@@ -0,0 +1,38 @@
+/*
+ * hash.h Is the header file for the non-cryptographic hash used by mish to
+ * key its caches. The data is hashed eight bytes at a time, so large inputs
+ * like whole scripts are hashed at close to memory speed.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*The seed to use when there is no reason to use another one.*/
+#define HASH_SEED 0x6d697368ULL
+
+/**
+ * hash_bytes() - Hashes a block of data.
+ *
+ * @param data The data to hash.
+ * @param len The length of the data.
+ * @param seed A seed, for example the hash of earlier data to chain hashes.
+ * @return The 64 bit hash.
+ */
+uint64_t hash_bytes(const void *data, size_t len, uint64_t seed);
+
+/**
+ * hash_string() - Hashes a string without its terminating null byte.
+ *
+ * @param str The string to hash.
+ * @param seed A seed, for example the hash of earlier data to chain hashes.
+ * @return The 64 bit hash.
+ */
+uint64_t hash_string(const char *str, uint64_t seed);
+
+#endif /* HASH_H_ */
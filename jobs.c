@@ -0,0 +1,410 @@
+/*
+ * jobs.c Is the source code for the bookkeeping of the shell's children. See
+ * the header file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "jobs.h"
+#include "stats.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+/* Defines */
+#define CHILD_POOL_SLAB 64	//Children per slab in the child pool
+#define JOB_POOL_SLAB 16	//Jobs per slab in the job pool
+
+/*Global variables declared in the header. */
+ilist current_shell_children = ILIST_INIT(current_shell_children);
+ilist current_shell_jobs = ILIST_INIT(current_shell_jobs);
+
+/*The pools the children and jobs are allocated from, created when needed.*/
+static list_pool *shell_child_pool = NULL;
+static list_pool *shell_job_pool = NULL;
+
+/*Function prototypes.*/
+static void read_exec_status(shell_child *child);
+
+/*The id of the next job which is started.*/
+static int next_job_id = 1;
+
+
+/**
+ * job_new() - Creates a new job without children.
+ *
+ * @return The new job.
+ */
+shell_job *job_new(void){
+	if(shell_job_pool == NULL){
+		shell_job_pool = list_pool_new(sizeof(shell_job), JOB_POOL_SLAB);
+	}
+
+	shell_job *job = list_pool_alloc(shell_job_pool);
+	job->id = next_job_id++;
+	job->started = stats_now();
+	ilist_append(&job->link, &current_shell_jobs);
+	return job;
+}
+
+/**
+ * job_add_child() - Adds a forked child to a job. The child has no exec
+ * status pipe until the caller sets exec_fd and forked in it.
+ *
+ * @param job The job.
+ * @param pid The pid of the child.
+ * @param stage The index of the child in the pipeline.
+ * @param last_stage 1 if the child is the last stage of the pipeline.
+ * @param name The command the child runs.
+ * @return The child.
+ */
+shell_child *job_add_child(shell_job *job, pid_t pid, int stage, int last_stage, \
+		const char *name){
+	if(shell_child_pool == NULL){
+		shell_child_pool = list_pool_new(sizeof(shell_child), CHILD_POOL_SLAB);
+	}
+
+	shell_child *child = list_pool_alloc(shell_child_pool);
+	child->pid = pid;
+	child->job = job;
+	child->job_id = job->id;
+	child->stage = stage;
+	child->last_stage = last_stage;
+	child->exec_fd = -1;
+	strncpy(child->name, name, CHILD_NAME_LEN - 1);
+	ilist_append(&child->link, &current_shell_children);
+	if(job->running == 0 && job->name[0] == '\0'){
+		strncpy(job->name, name, CHILD_NAME_LEN - 1);
+	}
+	job->running++;
+	return child;
+}
+
+/**
+ * job_child_changed() - Records a change of state of a child. A child which
+ * has exited is removed, and if it is the last stage of its job, the exit
+ * status is stored in the job. A stopped child stores 128 plus the signal.
+ *
+ * @param pid The pid of the child.
+ * @param wait_status The status given by wait.
+ * @param usage The resource usage given by wait4() for an exited child, or
+ * NULL if it is not known.
+ * @return 0 on success or -1 if the child is unknown.
+ */
+int job_child_changed(pid_t pid, int wait_status, const struct rusage *usage){
+	list_link *current_link = ilist_first(&current_shell_children);
+
+	while(current_link != NULL){
+		shell_child *child = ilist_entry(current_link, shell_child, link);
+		if(pid == child->pid){
+			shell_job *job = child->job;
+			if(WIFSTOPPED(wait_status)){
+				if(!child->stopped){
+					child->stopped = 1;
+					job->stopped++;
+				}
+				job->status = 128 + WSTOPSIG(wait_status);
+				return 0;
+			}
+			if(WIFCONTINUED(wait_status)){
+				if(child->stopped){
+					child->stopped = 0;
+					job->stopped--;
+				}
+				return 0;
+			}
+
+			if(child->last_stage){
+				job->status = exit_status(wait_status);
+			}
+			if(child->stopped){
+				job->stopped--;
+			}
+			if(usage != NULL){
+				timeradd(&job->usage.ru_utime, &usage->ru_utime, \
+						&job->usage.ru_utime);
+				timeradd(&job->usage.ru_stime, &usage->ru_stime, \
+						&job->usage.ru_stime);
+				if(usage->ru_maxrss > job->usage.ru_maxrss){
+					job->usage.ru_maxrss = usage->ru_maxrss;
+				}
+			}
+			job->running--;
+			read_exec_status(child);
+			ilist_remove(current_link);
+			list_pool_free(child, shell_child_pool);
+
+			stats_count(STATS_REAPED, 1);
+			if(job->running == 0){
+				stats_time(STATS_PIPELINE_TIME, stats_now() - job->started);
+			}
+			return 0;
+		}
+		current_link = ilist_next(current_link, &current_shell_children);
+	}
+	return -1;
+}
+
+/**
+ * job_is_done() - Checks if all children of a job have been reaped.
+ *
+ * @param job The job.
+ * @return 1 if the job is done, else 0.
+ */
+int job_is_done(shell_job *job){
+	return job->running == 0;
+}
+
+/**
+ * job_is_stopped() - Checks if all children of a job which are not reaped
+ * are stopped.
+ *
+ * @param job The job.
+ * @return 1 if the job is stopped, else 0.
+ */
+int job_is_stopped(shell_job *job){
+	return job->running > 0 && job->running == job->stopped;
+}
+
+/**
+ * job_find() - Finds a job which is not done.
+ *
+ * @param id The id of the job, or 0 for the newest job.
+ * @return The job or NULL if there is none.
+ */
+shell_job *job_find(int id){
+	shell_job *found = NULL;
+	list_link *current_link = ilist_first(&current_shell_jobs);
+	while(current_link != NULL){
+		shell_job *job = ilist_entry(current_link, shell_job, link);
+		if(!job_is_done(job) && (id == 0 || job->id == id)){
+			found = job;
+		}
+		current_link = ilist_next(current_link, &current_shell_jobs);
+	}
+	return found;
+}
+
+/**
+ * job_continue() - Sends SIGCONT to a job and marks its children as running.
+ *
+ * @param job The job.
+ * @return 0 on success or -1 on failure.
+ */
+int job_continue(shell_job *job){
+	list_link *current_link = ilist_first(&current_shell_children);
+	while(current_link != NULL){
+		shell_child *child = ilist_entry(current_link, shell_child, link);
+		if(child->job == job){
+			if(job->pgid == 0 && kill(child->pid, SIGCONT) < 0 && \
+					errno != ESRCH){
+				perror("Continue");
+				return -1;
+			}
+			child->stopped = 0;
+		}
+		current_link = ilist_next(current_link, &current_shell_children);
+	}
+	job->stopped = 0;
+
+	if(job->pgid > 0 && killpg(job->pgid, SIGCONT) < 0 && errno != ESRCH){
+		perror("Continue");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * job_signal() - Sends a signal to a job which is not done. A job with a
+ * process group gets it with one killpg(), else every child gets it.
+ *
+ * @param job The job.
+ * @param signo The signal.
+ */
+void job_signal(shell_job *job, int signo){
+	if(job_is_done(job)){
+		return;
+	}
+	if(job->pgid > 0){
+		if(killpg(job->pgid, signo) < 0 && errno != ESRCH){
+			perror("Signal job");
+		}
+		return;
+	}
+
+	list_link *current_link = ilist_first(&current_shell_children);
+	while(current_link != NULL){
+		shell_child *child = ilist_entry(current_link, shell_child, link);
+		if(child->job == job && kill(child->pid, signo) < 0 && \
+				errno != ESRCH){
+			perror("Signal child");
+		}
+		current_link = ilist_next(current_link, &current_shell_children);
+	}
+}
+
+/**
+ * job_remove() - Removes a done job.
+ *
+ * @param job The job.
+ */
+void job_remove(shell_job *job){
+	ilist_remove(&job->link);
+	list_pool_free(job, shell_job_pool);
+}
+
+/**
+ * jobs_reset() - Removes all done jobs and, if the shell has no children
+ * left, gives all entries back to the pools at once.
+ */
+void jobs_reset(void){
+	list_link *current_link = ilist_first(&current_shell_jobs);
+	while(current_link != NULL){
+		shell_job *job = ilist_entry(current_link, shell_job, link);
+		current_link = ilist_next(current_link, &current_shell_jobs);
+		if(job_is_done(job)){
+			job_remove(job);
+		}
+	}
+
+	if(ilist_is_empty(&current_shell_children) && \
+			ilist_is_empty(&current_shell_jobs)){
+		if(shell_child_pool != NULL){
+			list_pool_reset(shell_child_pool);
+		}
+		if(shell_job_pool != NULL){
+			list_pool_reset(shell_job_pool);
+		}
+	}
+}
+
+/**
+ * jobs_have_running_children() - Checks if any child is neither reaped nor
+ * stopped.
+ *
+ * @return 1 if a child is running, else 0.
+ */
+int jobs_have_running_children(void){
+	list_link *current_link = ilist_first(&current_shell_jobs);
+	while(current_link != NULL){
+		shell_job *job = ilist_entry(current_link, shell_job, link);
+		if(job->running > job->stopped){
+			return 1;
+		}
+		current_link = ilist_next(current_link, &current_shell_jobs);
+	}
+	return 0;
+}
+
+/**
+ * jobs_signal() - Sends a signal to every job which is not done. A job with
+ * a process group gets it with one killpg(), else every child gets it.
+ *
+ * @param signo The signal.
+ */
+void jobs_signal(int signo){
+	list_link *current_link = ilist_first(&current_shell_jobs);
+	while(current_link != NULL){
+		job_signal(ilist_entry(current_link, shell_job, link), signo);
+		current_link = ilist_next(current_link, &current_shell_jobs);
+	}
+}
+
+/**
+ * jobs_hangup() - Sends SIGHUP and SIGCONT to the stopped jobs, so they do
+ * not stay stopped when the shell exits.
+ */
+void jobs_hangup(void){
+	list_link *current_link = ilist_first(&current_shell_jobs);
+	while(current_link != NULL){
+		shell_job *job = ilist_entry(current_link, shell_job, link);
+		if(job->pgid > 0 && job_is_stopped(job)){
+			killpg(job->pgid, SIGHUP);
+			killpg(job->pgid, SIGCONT);
+		}
+		current_link = ilist_next(current_link, &current_shell_jobs);
+	}
+}
+
+/**
+ * jobs_forget() - Forgets all children and jobs without waiting for them.
+ * Used in a forked child, where they are not children anymore.
+ */
+void jobs_forget(void){
+	list_link *current_link = ilist_first(&current_shell_children);
+	while(current_link != NULL){
+		shell_child *child = ilist_entry(current_link, shell_child, link);
+		if(child->exec_fd >= 0){
+			close(child->exec_fd);
+		}
+		current_link = ilist_next(current_link, &current_shell_children);
+	}
+	ilist_init(&current_shell_children);
+	ilist_init(&current_shell_jobs);
+	if(shell_child_pool != NULL){
+		list_pool_kill(shell_child_pool);
+		shell_child_pool = NULL;
+	}
+	if(shell_job_pool != NULL){
+		list_pool_kill(shell_job_pool);
+		shell_job_pool = NULL;
+	}
+}
+
+/**
+ * exit_status() - Converts a status given by wait to a shell exit status,
+ * 128 plus the signal number for a killed process.
+ *
+ * @param wait_status The status given by wait.
+ * @return The exit status.
+ */
+int exit_status(int wait_status){
+	if(WIFEXITED(wait_status)){
+		return WEXITSTATUS(wait_status);
+	}
+	if(WIFSIGNALED(wait_status)){
+		return 128 + WTERMSIG(wait_status);
+	}
+	return 1;
+}
+
+/**
+ * read_exec_status() - Reads and closes the exec status pipe of a reaped
+ * child, see the header. The pipe is non-blocking and the child is gone, so
+ * everything it wrote is there. A child which was killed before its exec has
+ * written nothing and is not counted.
+ *
+ * @param child The reaped child.
+ */
+static void read_exec_status(shell_child *child){
+	unsigned char status[sizeof(uint64_t) + 1];
+	size_t got = 0;
+	ssize_t n;
+
+	if(child->exec_fd < 0){
+		return;
+	}
+	while(got < sizeof(status) && ((n = read(child->exec_fd, status + got, \
+			sizeof(status) - got)) > 0 || (n < 0 && errno == EINTR))){
+		got += n > 0 ? (size_t)n : 0;
+	}
+	close(child->exec_fd);
+	child->exec_fd = -1;
+
+	if(got == sizeof(uint64_t)){
+		uint64_t exec_time;
+		memcpy(&exec_time, status, sizeof(exec_time));
+		stats_time(STATS_SPAWN_TIME, exec_time - child->forked);
+	}
+	else if(got == 1 || got == sizeof(status)){
+		stats_count(STATS_EXEC_FAILURES, 1);
+	}
+}
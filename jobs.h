@@ -0,0 +1,196 @@
+/*
+ * jobs.h Is the header file for the bookkeeping of the shell's children. Every
+ * started pipeline is a job, and every forked process of a pipeline is a child
+ * which belongs to the job. When the last stage of a job is reaped, its exit
+ * status becomes the status of the job.
+ *
+ * The children and jobs are allocated from pools which are reset when the
+ * shell has no children left.
+ *
+ * With job control every job is a process group, so a signal is sent to the
+ * whole pipeline with one killpg(). A job whose children have all stopped is
+ * kept until it is continued.
+ *
+ * A child which executes a command may have an exec status pipe, which the
+ * shell never waits on. Right before the exec the child writes the time of
+ * the exec to it, and a byte after that if it could not execute the command.
+ * When the child is reaped, the pipe is read for the spawn time and the exec
+ * failures of the stats, see stats.h.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef JOBS_H_
+#define JOBS_H_
+
+#include "list.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+
+/*The longest name of a child which is remembered.*/
+#define CHILD_NAME_LEN 32
+
+/*A pipeline started by the shell.*/
+typedef struct shell_job{
+	list_link link;
+	int id;
+	pid_t pgid;	//The process group, 0 if the job has none.
+	int running;	//The number of children which are not reaped.
+	int stopped;	//The number of those children which are stopped.
+	int status;	//The exit status of the last stage.
+	uint64_t started;	//When the job was created, see stats_now().
+	struct rusage usage;	//The summed times and largest rss of reaped children.
+	char name[CHILD_NAME_LEN];	//The command of the first stage.
+}shell_job;
+
+/*A child process of the shell, linked into the current_shell_children list.*/
+typedef struct shell_child{
+	list_link link;
+	pid_t pid;
+	shell_job *job;			//The pipeline the child belongs to.
+	int job_id;			//The id of the pipeline.
+	int stage;			//The index of the child in the pipeline.
+	int last_stage;			//If the child is the last stage.
+	int stopped;			//If the child is stopped.
+	int exec_fd;			//The exec status pipe, or -1.
+	uint64_t forked;		//When the child was forked, see stats_now().
+	char name[CHILD_NAME_LEN];	//The command the child runs.
+}shell_child;
+
+/*Global variable for the list where the childrens pids should be saved.*/
+extern ilist current_shell_children;
+
+/*Global variable for the list of jobs which have not been removed.*/
+extern ilist current_shell_jobs;
+
+/**
+ * job_new() - Creates a new job without children.
+ *
+ * @return The new job.
+ */
+shell_job *job_new(void);
+
+/**
+ * job_add_child() - Adds a forked child to a job. The child has no exec
+ * status pipe until the caller sets exec_fd and forked in it.
+ *
+ * @param job The job.
+ * @param pid The pid of the child.
+ * @param stage The index of the child in the pipeline.
+ * @param last_stage 1 if the child is the last stage of the pipeline.
+ * @param name The command the child runs.
+ * @return The child.
+ */
+shell_child *job_add_child(shell_job *job, pid_t pid, int stage, int last_stage, \
+		const char *name);
+
+/**
+ * job_child_changed() - Records a change of state of a child. A child which
+ * has exited is removed, and if it is the last stage of its job, the exit
+ * status is stored in the job. A stopped child stores 128 plus the signal.
+ *
+ * @param pid The pid of the child.
+ * @param wait_status The status given by wait.
+ * @param usage The resource usage given by wait4() for an exited child, or
+ * NULL if it is not known.
+ * @return 0 on success or -1 if the child is unknown.
+ */
+int job_child_changed(pid_t pid, int wait_status, const struct rusage *usage);
+
+/**
+ * job_is_done() - Checks if all children of a job have been reaped.
+ *
+ * @param job The job.
+ * @return 1 if the job is done, else 0.
+ */
+int job_is_done(shell_job *job);
+
+/**
+ * job_is_stopped() - Checks if all children of a job which are not reaped
+ * are stopped.
+ *
+ * @param job The job.
+ * @return 1 if the job is stopped, else 0.
+ */
+int job_is_stopped(shell_job *job);
+
+/**
+ * job_find() - Finds a job which is not done.
+ *
+ * @param id The id of the job, or 0 for the newest job.
+ * @return The job or NULL if there is none.
+ */
+shell_job *job_find(int id);
+
+/**
+ * job_continue() - Sends SIGCONT to a job and marks its children as running.
+ *
+ * @param job The job.
+ * @return 0 on success or -1 on failure.
+ */
+int job_continue(shell_job *job);
+
+/**
+ * job_signal() - Sends a signal to a job which is not done. A job with a
+ * process group gets it with one killpg(), else every child gets it.
+ *
+ * @param job The job.
+ * @param signo The signal.
+ */
+void job_signal(shell_job *job, int signo);
+
+/**
+ * job_remove() - Removes a done job.
+ *
+ * @param job The job.
+ */
+void job_remove(shell_job *job);
+
+/**
+ * jobs_reset() - Removes all done jobs and, if the shell has no children
+ * left, gives all entries back to the pools at once.
+ */
+void jobs_reset(void);
+
+/**
+ * jobs_have_running_children() - Checks if any child is neither reaped nor
+ * stopped.
+ *
+ * @return 1 if a child is running, else 0.
+ */
+int jobs_have_running_children(void);
+
+/**
+ * jobs_signal() - Sends a signal to every job which is not done. A job with
+ * a process group gets it with one killpg(), else every child gets it.
+ *
+ * @param signo The signal.
+ */
+void jobs_signal(int signo);
+
+/**
+ * jobs_hangup() - Sends SIGHUP and SIGCONT to the stopped jobs, so they do
+ * not stay stopped when the shell exits.
+ */
+void jobs_hangup(void);
+
+/**
+ * jobs_forget() - Forgets all children and jobs without waiting for them and
+ * closes their exec status pipes. Used in a forked child, where they are not
+ * children anymore.
+ */
+void jobs_forget(void);
+
+/**
+ * exit_status() - Converts a status given by wait to a shell exit status,
+ * 128 plus the signal number for a killed process.
+ *
+ * @param wait_status The status given by wait.
+ * @return The exit status.
+ */
+int exit_status(int wait_status);
+
+#endif /* JOBS_H_ */
@@ -0,0 +1,589 @@
+/*
+ * journal.c Is the source code for the journal of a resumable script. See the
+ * header file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "journal.h"
+#include "stats.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* Defines */
+#define JOURNAL_MAGIC "mish journal"
+#define JOURNAL_LINE_LEN 64
+#define NSEC_PER_MSEC 1000000L
+#define JOURNAL_LOOPS_MIN 8	//The first size of the array of loops.
+
+/*The rounds of a for loop which are done, see journal_record_round().*/
+typedef struct journal_loop{
+	int line;	//The first line of the compound command of the loop.
+	int loop;	//The index of the loop in the compound command.
+	uint64_t words_hash;	//The hash of the words of the loop.
+	int rounds;	//The number of rounds from the first one which succeeded.
+	char **state;	//The state of the shell after the last done round.
+}journal_loop;
+
+struct journal{
+	int fd;
+	char *done;		//If each line of the script has succeeded.
+	char ***states;		//The state of the shell after each done line, or NULL.
+	int number_of_lines;
+	int done_lines;
+	journal_loop *loops;
+	int number_of_loops;
+	int loops_size;
+	int unsynced;		//The entries written since the last sync.
+	uint64_t synced;	//When the journal was last synced, see stats_now().
+};
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/*Function prototypes.*/
+static char *read_journal(int fd, size_t *len);
+static size_t read_entries(journal *j, const char *text, size_t len, \
+		uint64_t script_hash);
+static int read_state(const char *p, const char *end, char ***state);
+static int hex_value(char c);
+static void mark_line(journal *j, int line, int status, char **state);
+static void mark_round(journal *j, int line, int loop, uint64_t words_hash, \
+		int round, char **state);
+static journal_loop *find_loop(journal *j, int line, int loop);
+static int write_entry(journal *j, const char *head, char **state, \
+		char ***copy);
+static int write_all(int fd, const char *buf, size_t len);
+static void sync_journal(journal *j);
+
+
+/**
+ * journal_open() - Opens the journal of a script, reading which lines are
+ * done, or creates it.
+ *
+ * @param path The path of the journal.
+ * @param script_hash The hash of the script, see script_hash().
+ * @param number_of_lines The number of lines in the script.
+ * @return The journal or NULL on failure.
+ */
+journal *journal_open(const char *path, uint64_t script_hash, \
+		int number_of_lines){
+	int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if(fd < 0){
+		perror(path);
+		return NULL;
+	}
+
+	journal *j = malloc(sizeof(*j));
+	char *done = calloc(number_of_lines + 1, 1);
+	char ***states = calloc(number_of_lines + 1, sizeof(*states));
+	if(j == NULL || done == NULL || states == NULL){
+		perror("journal.c");
+		exit(errno);
+	}
+	j->fd = fd;
+	j->done = done;
+	j->states = states;
+	j->number_of_lines = number_of_lines;
+	j->done_lines = 0;
+	j->loops = NULL;
+	j->number_of_loops = 0;
+	j->loops_size = 0;
+	j->unsynced = 0;
+	j->synced = stats_now();
+
+	size_t len;
+	char *text = read_journal(fd, &len);
+	if(text == NULL){
+		perror(path);
+		journal_close(j);
+		return NULL;
+	}
+
+	size_t valid = len == 0 ? 0 : read_entries(j, text, len, script_hash);
+	free(text);
+	if(len > 0 && valid == 0){
+		fprintf(stderr, "%s: not a journal of this script, remove it to "
+				"start over\n", path);
+		journal_close(j);
+		return NULL;
+	}
+
+	if(len == 0){
+		char header[JOURNAL_LINE_LEN];
+		int header_len = snprintf(header, sizeof(header), "%s %016llx %d\n", \
+				JOURNAL_MAGIC, (unsigned long long)script_hash, \
+				number_of_lines);
+		if(write_all(fd, header, header_len) < 0){
+			perror(path);
+			journal_close(j);
+			return NULL;
+		}
+		j->unsynced++;
+	}
+	else if(valid < len && ftruncate(fd, valid) < 0){ //Drop a torn entry.
+		perror(path);
+		journal_close(j);
+		return NULL;
+	}
+	return j;
+}
+
+/**
+ * journal_is_done() - Checks if a line has succeeded in an earlier run.
+ *
+ * @param j The journal.
+ * @param line The index of the line.
+ * @return 1 if the line is done, else 0.
+ */
+int journal_is_done(journal *j, int line){
+	return line >= 0 && line < j->number_of_lines && j->done[line];
+}
+
+/**
+ * journal_done_lines() - Gets the number of lines which are done.
+ *
+ * @param j The journal.
+ * @return The number of lines.
+ */
+int journal_done_lines(journal *j){
+	return j->done_lines;
+}
+
+/**
+ * journal_state() - Gets the state of the shell after a line which is done.
+ *
+ * @param j The journal.
+ * @param line The index of the line.
+ * @return The state, which the journal owns, or NULL if the line is not done
+ * or did not change the shell.
+ */
+char **journal_state(journal *j, int line){
+	return journal_is_done(j, line) ? j->states[line] : NULL;
+}
+
+/**
+ * journal_done_rounds() - Gets the number of rounds of a for loop which
+ * succeeded in earlier runs, counted from the first round.
+ *
+ * @param j The journal.
+ * @param line The first line of the compound command of the loop.
+ * @param loop The index of the loop in the compound command.
+ * @param words_hash The hash of the words of the loop.
+ * @param state Set to the state of the shell after the last done round, which
+ * the journal owns, or NULL if no round is done.
+ * @return The number of rounds, 0 if the words of the loop have changed.
+ */
+int journal_done_rounds(journal *j, int line, int loop, uint64_t words_hash, \
+		char ***state){
+	journal_loop *l = find_loop(j, line, loop);
+	*state = NULL;
+	if(l == NULL || l->words_hash != words_hash || l->rounds == 0){
+		return 0;
+	}
+	*state = l->state;
+	return l->rounds;
+}
+
+/**
+ * journal_record() - Appends the exit status of a line which has run.
+ *
+ * @param j The journal.
+ * @param line The index of the line.
+ * @param status The exit status of the line.
+ * @param state The state of the shell after a line which changed it, or NULL.
+ */
+void journal_record(journal *j, int line, int status, char **state){
+	char head[JOURNAL_LINE_LEN];
+	snprintf(head, sizeof(head), "%d %d", line, status);
+	char **copy;
+	if(write_entry(j, head, state, &copy) == 0){
+		mark_line(j, line, status, copy);
+	}
+}
+
+/**
+ * journal_record_round() - Appends a round of a for loop which succeeded.
+ *
+ * @param j The journal.
+ * @param line The first line of the compound command of the loop.
+ * @param loop The index of the loop in the compound command.
+ * @param words_hash The hash of the words of the loop.
+ * @param round The index of the round.
+ * @param state The state of the shell after the round.
+ */
+void journal_record_round(journal *j, int line, int loop, \
+		uint64_t words_hash, int round, char **state){
+	char head[JOURNAL_LINE_LEN];
+	snprintf(head, sizeof(head), "%d for %d %016llx %d", line, loop, \
+			(unsigned long long)words_hash, round);
+	char **copy;
+	if(write_entry(j, head, state, &copy) == 0){
+		mark_round(j, line, loop, words_hash, round, copy);
+	}
+}
+
+/**
+ * journal_close() - Syncs the journal and closes it.
+ *
+ * @param j The journal.
+ */
+void journal_close(journal *j){
+	sync_journal(j);
+	close(j->fd);
+	for(int line = 0; line < j->number_of_lines; line++){
+		free(j->states[line]);
+	}
+	for(int i = 0; i < j->number_of_loops; i++){
+		free(j->loops[i].state);
+	}
+	free(j->loops);
+	free(j->states);
+	free(j->done);
+	free(j);
+}
+
+/**
+ * read_journal() - Reads the whole journal.
+ *
+ * @param fd The file descriptor of the journal.
+ * @param len Set to the length of the journal.
+ * @return The text of the journal, which the caller frees, or NULL on
+ * failure.
+ */
+static char *read_journal(int fd, size_t *len){
+	struct stat st;
+	if(fstat(fd, &st) < 0){
+		return NULL;
+	}
+	char *text = malloc(st.st_size + 1);
+	if(text == NULL){
+		perror("journal.c");
+		exit(errno);
+	}
+
+	size_t used = 0;
+	while(used < (size_t)st.st_size){
+		ssize_t n = pread(fd, text + used, st.st_size - used, used);
+		if(n < 0 && errno == EINTR){
+			continue;
+		}
+		else if(n < 0){
+			free(text);
+			return NULL;
+		}
+		else if(n == 0){
+			break;
+		}
+		used += n;
+	}
+	text[used] = '\0';
+	*len = used;
+	return text;
+}
+
+/**
+ * read_entries() - Checks the header of a journal and marks the lines of its
+ * entries. Reading stops at the first entry which is not whole.
+ *
+ * @param j The journal.
+ * @param text The text of the journal, null terminated.
+ * @param len The length of the text.
+ * @param script_hash The hash of the script.
+ * @return The length of the header and the whole entries, or 0 if the header
+ * is not the one of the script.
+ */
+static size_t read_entries(journal *j, const char *text, size_t len, \
+		uint64_t script_hash){
+	unsigned long long hash;
+	int number_of_lines;
+	int header_len = 0;
+	if(sscanf(text, JOURNAL_MAGIC " %llx %d\n%n", &hash, &number_of_lines, \
+			&header_len) != 2 || header_len == 0 || \
+			text[header_len-1] != '\n' || hash != script_hash || \
+			number_of_lines != j->number_of_lines){
+		return 0;
+	}
+
+	size_t valid = header_len;
+	while(valid < len){
+		const char *p = text + valid;
+		const char *end = memchr(p, '\n', len - valid);
+		int line;
+		int status;
+		int loop;
+		int round;
+		unsigned long long words_hash;
+		int round_len = 0;
+		int line_len = 0;
+		char **state;
+		if(end == NULL){
+			break;
+		}
+		if(sscanf(p, "%d for %d %llx %d%n", &line, &loop, &words_hash, \
+				&round, &round_len) == 4 && round_len <= end - p && \
+				read_state(p + round_len, end, &state) == 0){
+			mark_round(j, line, loop, words_hash, round, state);
+		}
+		else if(sscanf(p, "%d %d%n", &line, &status, &line_len) == 2 && \
+				line_len <= end - p && \
+				read_state(p + line_len, end, &state) == 0){
+			mark_line(j, line, status, state);
+		}
+		else{
+			break;
+		}
+		valid = end - text + 1;
+	}
+	return valid;
+}
+
+/**
+ * read_state() - Reads the state of the shell at the end of an entry, a " ="
+ * followed by the strings of the state in hex, each after a space.
+ *
+ * @param p The rest of the entry after its head.
+ * @param end The newline at the end of the entry.
+ * @param state Set to the state, one allocation which the caller frees, or
+ * NULL if the entry has none.
+ * @return 0 on success or -1 if the entry is not whole.
+ */
+static int read_state(const char *p, const char *end, char ***state){
+	*state = NULL;
+	if(p == end){
+		return 0;
+	}
+	if(end - p < 2 || p[0] != ' ' || p[1] != '='){
+		return -1;
+	}
+	p += 2;
+
+	size_t strings = 0;
+	for(const char *c = p; c < end; c++){
+		strings += *c == ' ';
+	}
+	//Every string takes a space and two digits per byte in the entry.
+	char **s = malloc((strings + 1) * sizeof(*s) + (end - p) / 2 + strings);
+	if(s == NULL){
+		perror("journal.c");
+		exit(errno);
+	}
+	char *out = (char *)(s + strings + 1);
+	for(size_t i = 0; i < strings; i++){
+		if(*p++ != ' '){
+			free(s);
+			return -1;
+		}
+		s[i] = out;
+		while(p < end && *p != ' '){
+			int high = hex_value(p[0]);
+			int low = p + 1 < end ? hex_value(p[1]) : -1;
+			if(high < 0 || low < 0){
+				free(s);
+				return -1;
+			}
+			*out++ = high << 4 | low;
+			p += 2;
+		}
+		*out++ = '\0';
+	}
+	s[strings] = NULL;
+	*state = s;
+	return 0;
+}
+
+/**
+ * hex_value() - Gets the value of a hex digit.
+ *
+ * @param c The digit.
+ * @return The value or -1 if c is not a lower case hex digit.
+ */
+static int hex_value(char c){
+	const char *digit = c != '\0' ? strchr(hex_digits, c) : NULL;
+	return digit != NULL ? digit - hex_digits : -1;
+}
+
+/**
+ * mark_line() - Marks a line as done if it succeeded, or as not done if it
+ * failed in a later run.
+ *
+ * @param j The journal.
+ * @param line The index of the line.
+ * @param status The exit status of the line.
+ * @param state The state of the shell after the line or NULL, which the
+ * journal takes over.
+ */
+static void mark_line(journal *j, int line, int status, char **state){
+	if(line < 0 || line >= j->number_of_lines){
+		free(state);
+		return;
+	}
+	int done = status == 0;
+	j->done_lines += done - j->done[line];
+	j->done[line] = done;
+	free(j->states[line]);
+	j->states[line] = state;
+}
+
+/**
+ * mark_round() - Marks a round of a for loop as done if all rounds before it
+ * are, so the rounds after a failed one are run again. A round of a loop
+ * whose words have changed starts the rounds over.
+ *
+ * @param j The journal.
+ * @param line The first line of the compound command of the loop.
+ * @param loop The index of the loop in the compound command.
+ * @param words_hash The hash of the words of the loop.
+ * @param round The index of the round.
+ * @param state The state of the shell after the round, which the journal
+ * takes over.
+ */
+static void mark_round(journal *j, int line, int loop, uint64_t words_hash, \
+		int round, char **state){
+	journal_loop *l = find_loop(j, line, loop);
+	if(l == NULL){
+		if(j->number_of_loops == j->loops_size){
+			int size = j->loops_size > 0 ? j->loops_size * 2 : \
+					JOURNAL_LOOPS_MIN;
+			journal_loop *loops = realloc(j->loops, size * sizeof(*loops));
+			if(loops == NULL){
+				perror("journal.c");
+				exit(errno);
+			}
+			j->loops = loops;
+			j->loops_size = size;
+		}
+		l = &j->loops[j->number_of_loops++];
+		l->line = line;
+		l->loop = loop;
+		l->words_hash = words_hash;
+		l->rounds = 0;
+		l->state = NULL;
+	}
+	if(l->words_hash != words_hash){
+		l->words_hash = words_hash;
+		l->rounds = 0;
+	}
+	if(round != l->rounds){
+		free(state);
+		return;
+	}
+	l->rounds++;
+	free(l->state);
+	l->state = state;
+}
+
+/**
+ * find_loop() - Finds the rounds of a for loop.
+ *
+ * @param j The journal.
+ * @param line The first line of the compound command of the loop.
+ * @param loop The index of the loop in the compound command.
+ * @return The rounds or NULL if no round of the loop is journaled.
+ */
+static journal_loop *find_loop(journal *j, int line, int loop){
+	for(int i = 0; i < j->number_of_loops; i++){
+		if(j->loops[i].line == line && j->loops[i].loop == loop){
+			return &j->loops[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * write_entry() - Appends an entry to the journal and syncs it when it is
+ * time, see the header.
+ *
+ * @param j The journal.
+ * @param head The entry without the state.
+ * @param state The state of the shell to put after the head, or NULL.
+ * @param copy Set to a copy of the state read back from the entry, which the
+ * caller frees, or NULL if there is no state.
+ * @return 0 on success or -1 if the entry could not be written.
+ */
+static int write_entry(journal *j, const char *head, char **state, \
+		char ***copy){
+	size_t len = strlen(head) + 3;
+	for(int i = 0; state != NULL && state[i] != NULL; i++){
+		len += 1 + 2 * strlen(state[i]);
+	}
+	char *entry = malloc(len + 1);
+	if(entry == NULL){
+		perror("journal.c");
+		exit(errno);
+	}
+
+	char *out = stpcpy(entry, head);
+	if(state != NULL){
+		out = stpcpy(out, " =");
+		for(int i = 0; state[i] != NULL; i++){
+			*out++ = ' ';
+			for(const unsigned char *c = (const unsigned char *)state[i]; \
+					*c != '\0'; c++){
+				*out++ = hex_digits[*c >> 4];
+				*out++ = hex_digits[*c & 0xf];
+			}
+		}
+	}
+	*out = '\n';
+
+	*copy = NULL;
+	if(write_all(j->fd, entry, out - entry + 1) < 0){
+		perror("Journal");
+		free(entry);
+		return -1;
+	}
+	read_state(entry + strlen(head), out, copy);
+	free(entry);
+
+	j->unsynced++;
+	if(j->unsynced >= JOURNAL_SYNC_LINES || \
+			stats_now() - j->synced >= JOURNAL_SYNC_MS * NSEC_PER_MSEC){
+		sync_journal(j);
+	}
+	return 0;
+}
+
+/**
+ * write_all() - Writes the whole buffer to a file descriptor.
+ *
+ * @param fd The file descriptor to write to.
+ * @param buf The data.
+ * @param len The length of the data.
+ * @return 0 on success or -1 on failure.
+ */
+static int write_all(int fd, const char *buf, size_t len){
+	while(len > 0){
+		ssize_t n = write(fd, buf, len);
+		if(n < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/**
+ * sync_journal() - Syncs the written entries to the disk.
+ *
+ * @param j The journal.
+ */
+static void sync_journal(journal *j){
+	if(j->unsynced > 0 && fdatasync(j->fd) < 0){
+		perror("Journal");
+	}
+	j->unsynced = 0;
+	j->synced = stats_now();
+}
@@ -0,0 +1,140 @@
+/*
+ * journal.h Is the header file for the journal of a resumable script. With
+ *
+ *   mish [-e] -r JOURNAL script
+ *
+ * the index and exit status of every line of the script which has been run
+ * are appended to JOURNAL. When the script is run again with the same
+ * journal, the lines which succeeded are skipped, so a long script goes on
+ * where it failed or crashed instead of starting over. Lines which failed are
+ * run again. With -e the script stops at the first line which fails, else it
+ * goes on with the next line.
+ *
+ * The lines of a compound command like if or while are recorded together when
+ * the whole command has run. A line which changes the shell, like "cd" or an
+ * assignment, is recorded with the state of the shell after it, the working
+ * directory, the tagout mode and the shell variables. When the line is
+ * skipped the state is put back, so the lines after it see the same shell as
+ * the first time. Jobs are not part of the state.
+ *
+ * A for loop which is not inside another loop also records every round which
+ * succeeded, with the state of the shell after it. When its compound command
+ * is run again, the rounds up to the first one which failed are skipped and
+ * the state after the last of them is put back. The loops are told apart by
+ * the first line of their compound command and the order they start in, and
+ * the rounds only count if the loop has the same words as when they ran.
+ *
+ * Every entry is written to the journal when its line has ended, so it is not
+ * lost if the shell dies. The journal is synced to the disk after
+ * JOURNAL_SYNC_LINES entries or when JOURNAL_SYNC_MS have passed since the
+ * last sync, so a crash of the machine redoes at most those lines. An entry
+ * which was cut short by a crash is dropped.
+ *
+ * The journal starts with the hash of the script, and a journal of another
+ * version of the script is refused.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <stdint.h>
+
+/*The most entries written between two syncs.*/
+#define JOURNAL_SYNC_LINES 256
+
+/*The longest time between writing an entry and syncing it.*/
+#define JOURNAL_SYNC_MS 1000
+
+typedef struct journal journal;
+
+/*The state of the shell is an array of strings ended by NULL, which the
+ *journal keeps as they are, see shell_state() in mish.c.*/
+
+/**
+ * journal_open() - Opens the journal of a script, reading which lines are
+ * done, or creates it.
+ *
+ * @param path The path of the journal.
+ * @param script_hash The hash of the script, see script_hash().
+ * @param number_of_lines The number of lines in the script.
+ * @return The journal or NULL on failure.
+ */
+journal *journal_open(const char *path, uint64_t script_hash, \
+		int number_of_lines);
+
+/**
+ * journal_is_done() - Checks if a line has succeeded in an earlier run.
+ *
+ * @param j The journal.
+ * @param line The index of the line.
+ * @return 1 if the line is done, else 0.
+ */
+int journal_is_done(journal *j, int line);
+
+/**
+ * journal_done_lines() - Gets the number of lines which are done.
+ *
+ * @param j The journal.
+ * @return The number of lines.
+ */
+int journal_done_lines(journal *j);
+
+/**
+ * journal_state() - Gets the state of the shell after a line which is done.
+ *
+ * @param j The journal.
+ * @param line The index of the line.
+ * @return The state, which the journal owns, or NULL if the line is not done
+ * or did not change the shell.
+ */
+char **journal_state(journal *j, int line);
+
+/**
+ * journal_done_rounds() - Gets the number of rounds of a for loop which
+ * succeeded in earlier runs, counted from the first round.
+ *
+ * @param j The journal.
+ * @param line The first line of the compound command of the loop.
+ * @param loop The index of the loop in the compound command.
+ * @param words_hash The hash of the words of the loop.
+ * @param state Set to the state of the shell after the last done round, which
+ * the journal owns, or NULL if no round is done.
+ * @return The number of rounds, 0 if the words of the loop have changed.
+ */
+int journal_done_rounds(journal *j, int line, int loop, uint64_t words_hash, \
+		char ***state);
+
+/**
+ * journal_record() - Appends the exit status of a line which has run.
+ *
+ * @param j The journal.
+ * @param line The index of the line.
+ * @param status The exit status of the line.
+ * @param state The state of the shell after a line which changed it, or NULL.
+ */
+void journal_record(journal *j, int line, int status, char **state);
+
+/**
+ * journal_record_round() - Appends a round of a for loop which succeeded.
+ *
+ * @param j The journal.
+ * @param line The first line of the compound command of the loop.
+ * @param loop The index of the loop in the compound command.
+ * @param words_hash The hash of the words of the loop.
+ * @param round The index of the round.
+ * @param state The state of the shell after the round.
+ */
+void journal_record_round(journal *j, int line, int loop, \
+		uint64_t words_hash, int round, char **state);
+
+/**
+ * journal_close() - Syncs the journal and closes it.
+ *
+ * @param j The journal.
+ */
+void journal_close(journal *j);
+
+#endif /* JOURNAL_H_ */
@@ -0,0 +1,438 @@
+/*
+ * launch.c Is the source code for the launch core of mish, which forks and
+ * executes the commands of a pipeline. See the header file for more
+ * information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "launch.h"
+#include "execute.h"
+#include "hash.h"
+
+/*Include default libraries */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Defines */
+#define ERROR_LEN 512	//The longest error line a child writes
+#define NSEC_PER_SEC 1000000000ULL
+
+/*Where a command was found in PATH.*/
+typedef struct path_entry{
+	uint64_t hash;	//Of the name.
+	uint64_t search;	//The hash of PATH when it was found.
+	char *name;
+	char *path;
+}path_entry;
+
+struct launch_paths{
+	int slots;
+	path_entry entries[];
+};
+
+/*Function prototypes.*/
+static const char *find_path(launch_paths *paths, const char *name, \
+		char *path, size_t size, int *hit);
+static void launch_child_process(command *cmd, const char *path, int in_fd, \
+		int out_pipe[2], int exec_fd, int stage, const launch_spec *spec);
+static int dup_stdio(int fd, int destfd);
+static int open_redirection(const char *filename, int flags, int destfd);
+static void write_exec_status(int exec_fd, const void *status, size_t len);
+static void write_error(const char *name, const char *message);
+static uint64_t monotonic_now(void);
+
+
+/**
+ * launch_spec_init() - Sets a spec to the defaults, the caller's stdio, no
+ * exec status pipes and no hooks.
+ *
+ * @param spec The spec.
+ */
+void launch_spec_init(launch_spec *spec){
+	memset(spec, 0, sizeof(*spec));
+	spec->stdin_fd = -1;
+	spec->stdout_fd = -1;
+	spec->stderr_fd = -1;
+}
+
+/**
+ * launch_pipeline() - Forks the commands of a pipeline connected by pipes.
+ * The parent does not wait for the children. If a pipe or fork fails, no more
+ * commands are started and the ones which were see end of file. The file
+ * descriptors of the spec are not closed.
+ *
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @param spec How the pipeline is connected and started.
+ * @return The number of commands started, less than number_of_commands with
+ * errno set on failure.
+ */
+int launch_pipeline(command *command_array, int number_of_commands, \
+		const launch_spec *spec){
+	int in_fd = -1;
+	int started = 0;
+
+	for(int i = 0; i < number_of_commands; i++){
+		command *cmd = &command_array[i];
+		int last = i == number_of_commands-1;
+		int out_pipe[2] = {-1, -1};
+		if(!last && pipe2(out_pipe, O_CLOEXEC) < 0){
+			break;
+		}
+
+		//Found before the fork, the child only calls execv().
+		char path[PATH_MAX];
+		const char *exec_path = NULL;
+		int path_hit = 0;
+		if(!cmd->internal){
+			exec_path = find_path(spec->paths, cmd->argv[0], path, \
+					sizeof(path), &path_hit);
+		}
+
+		int exec_pipe[2] = {-1, -1};
+		if(spec->exec_status && !cmd->internal && \
+				pipe2(exec_pipe, O_CLOEXEC | O_NONBLOCK) < 0){
+			exec_pipe[READ_END] = exec_pipe[WRITE_END] = -1;
+		}
+
+		uint64_t forked = monotonic_now();
+		pid_t pid = fork();
+		if(pid < 0){
+			int error = errno;
+			if(!last){
+				close(out_pipe[READ_END]);
+				close(out_pipe[WRITE_END]);
+			}
+			if(exec_pipe[READ_END] >= 0){
+				close(exec_pipe[READ_END]);
+				close(exec_pipe[WRITE_END]);
+			}
+			errno = error;
+			break;
+		}
+		else if(pid == 0){ //Child process
+			if(exec_pipe[READ_END] >= 0){
+				close(exec_pipe[READ_END]);
+			}
+			launch_child_process(cmd, exec_path, in_fd, out_pipe, \
+					exec_pipe[WRITE_END], i, spec);
+		}
+		started++;
+
+		if(exec_pipe[WRITE_END] >= 0){
+			close(exec_pipe[WRITE_END]);
+		}
+		if(spec->started != NULL){
+			launch_child child = {pid, cmd, i, in_fd, exec_pipe[READ_END], \
+					path_hit, forked};
+			spec->started(&child, spec->arg);
+		}
+		else if(exec_pipe[READ_END] >= 0){
+			close(exec_pipe[READ_END]);
+		}
+
+		if(in_fd >= 0){
+			close(in_fd);
+		}
+		if(!last){
+			close(out_pipe[WRITE_END]);
+		}
+		in_fd = out_pipe[READ_END];
+	}
+
+	//The commands which were started see end of file.
+	if(started < number_of_commands && in_fd >= 0){
+		int error = errno;
+		close(in_fd);
+		errno = error;
+	}
+	return started;
+}
+
+/**
+ * launch_pipeline_length() - Counts the commands of the pipeline which
+ * starts the array, the commands joined by "|" or "|+".
+ *
+ * @param command_array An array with the commands.
+ * @param number_of_commands The number of commands in the array.
+ * @return The number of commands in the pipeline.
+ */
+int launch_pipeline_length(const command *command_array, \
+		int number_of_commands){
+	int length = 1;
+	while(length < number_of_commands && \
+			(command_array[length-1].separator == SEP_PIPE || \
+			command_array[length-1].separator == SEP_FANOUT)){
+		length++;
+	}
+	return length;
+}
+
+/**
+ * launch_runs_after() - Decides if the pipeline after a separator is run. A
+ * pipeline after "&&" is only run if the status is 0 and a pipeline after
+ * "||" only if it is not. A skipped pipeline keeps the status, so
+ * "false && a || b" runs b.
+ *
+ * @param separator The separator after the last pipeline.
+ * @param status The status of the last pipeline which was run.
+ * @return 1 if the next pipeline is run, else 0.
+ */
+int launch_runs_after(int separator, int status){
+	if(separator == SEP_AND){
+		return status == 0;
+	}
+	if(separator == SEP_OR){
+		return status != 0;
+	}
+	return 1;
+}
+
+/**
+ * launch_paths_new() - Creates an empty cache of the paths of commands.
+ *
+ * @param slots The number of commands the cache holds.
+ * @return The cache or NULL if there is no memory.
+ */
+launch_paths *launch_paths_new(int slots){
+	launch_paths *paths = calloc(1, sizeof(*paths) + \
+			slots * sizeof(path_entry));
+	if(paths != NULL){
+		paths->slots = slots;
+	}
+	return paths;
+}
+
+/**
+ * find_path() - Finds the path to execute a command at, from the cache if
+ * it was found before, see the header. A command with a '/' is executed at
+ * its name.
+ *
+ * @param paths The cache or NULL.
+ * @param name The name of the command.
+ * @param path The buffer for a path which is searched for.
+ * @param size The size of the buffer.
+ * @param hit Set to 1 if the path was found in the cache.
+ * @return The path, valid until the next lookup, or NULL if the command was
+ * not found.
+ */
+static const char *find_path(launch_paths *paths, const char *name, \
+		char *path, size_t size, int *hit){
+	if(strchr(name, '/') != NULL){
+		return name;
+	}
+	if(paths == NULL){
+		return find_command(name, path, size) == 0 ? path : NULL;
+	}
+
+	const char *search_path = getenv("PATH");
+	uint64_t search = hash_string(search_path != NULL ? search_path : "", \
+			HASH_SEED);
+	uint64_t hash = hash_string(name, HASH_SEED);
+	path_entry *e = &paths->entries[hash % paths->slots];
+	if(e->name != NULL && e->hash == hash && e->search == search && \
+			strcmp(e->name, name) == 0 && access(e->path, X_OK) == 0){
+		*hit = 1;
+		return e->path;
+	}
+
+	if(find_command(name, path, size) < 0){
+		return NULL;
+	}
+	//Without memory the path is only not cached.
+	char *name_copy = strdup(name);
+	char *path_copy = strdup(path);
+	if(name_copy == NULL || path_copy == NULL){
+		free(name_copy);
+		free(path_copy);
+		return path;
+	}
+	free(e->name);
+	free(e->path);
+	e->hash = hash;
+	e->search = search;
+	e->name = name_copy;
+	e->path = path_copy;
+	return path;
+}
+
+/**
+ * launch_child_process() - Sets up the stdio and redirections of a forked
+ * stage and executes its command, or runs it with the run_internal hook. Only
+ * async-signal-safe calls are made, see the header. Never returns.
+ *
+ * @param cmd The command.
+ * @param path The path to execute the command at, or NULL if it was not
+ * found.
+ * @param in_fd The read end of the pipe from the previous stage, or -1 for
+ * the first stage.
+ * @param out_pipe The pipe to the next stage, or -1 in both ends for the last
+ * stage.
+ * @param exec_fd The write end of the exec status pipe, or -1.
+ * @param stage The index of the stage in the pipeline.
+ * @param spec How the pipeline is connected and started.
+ */
+static void launch_child_process(command *cmd, const char *path, int in_fd, \
+		int out_pipe[2], int exec_fd, int stage, const launch_spec *spec){
+	//The command should not get the signal mask of the forking thread.
+	sigset_t none;
+	sigemptyset(&none);
+	sigprocmask(SIG_SETMASK, &none, NULL);
+
+	if(out_pipe[READ_END] >= 0){
+		close(out_pipe[READ_END]);
+	}
+	if(dup_stdio(in_fd >= 0 ? in_fd : spec->stdin_fd, STDIN_FILENO) < 0 || \
+			dup_stdio(out_pipe[WRITE_END] >= 0 ? out_pipe[WRITE_END] : \
+			spec->stdout_fd, STDOUT_FILENO) < 0 || \
+			dup_stdio(spec->stderr_fd, STDERR_FILENO) < 0){
+		write_error(cmd->argv[0], strerrordesc_np(errno));
+		write_exec_status(exec_fd, "!", 1);
+		_exit(LAUNCH_EXEC_FAILED);
+	}
+	//Only the pipes are closed, the fds of the spec may be used twice.
+	if(in_fd > STDERR_FILENO){
+		close(in_fd);
+	}
+	if(out_pipe[WRITE_END] > STDERR_FILENO){
+		close(out_pipe[WRITE_END]);
+	}
+	if(spec->setup != NULL){
+		spec->setup(stage, spec->arg);
+	}
+
+	if((cmd->infile != NULL && \
+			open_redirection(cmd->infile, O_RDONLY, STDIN_FILENO) < 0) || \
+			(cmd->outfile != NULL && open_redirection(cmd->outfile, \
+			O_WRONLY | O_CREAT | O_EXCL, STDOUT_FILENO) < 0)){
+		write_exec_status(exec_fd, "!", 1);
+		_exit(1);
+	}
+
+	if(cmd->internal){
+		_exit(spec->run_internal(cmd, spec->arg));
+	}
+	if(path == NULL){
+		write_error(cmd->argv[0], strerrordesc_np(ENOENT));
+		write_exec_status(exec_fd, "!", 1);
+		_exit(LAUNCH_EXEC_FAILED);
+	}
+
+	//The time of the exec, the status pipe holds it for the parent.
+	uint64_t exec_time = monotonic_now();
+	write_exec_status(exec_fd, &exec_time, sizeof(exec_time));
+	execv(path, cmd->argv);
+	write_error(cmd->argv[0], strerrordesc_np(errno));
+	write_exec_status(exec_fd, "!", 1);
+	_exit(LAUNCH_EXEC_FAILED);
+}
+
+/**
+ * dup_stdio() - Duplicates a file descriptor to a standard I/O file
+ * descriptor. The copy is not close-on-exec like the pipes are.
+ *
+ * @param fd The file descriptor or -1 to keep destfd.
+ * @param destfd The standard I/O file descriptor.
+ * @return 0 on success or -1 on failure.
+ */
+static int dup_stdio(int fd, int destfd){
+	if(fd < 0 || fd == destfd){
+		return 0;
+	}
+	return dup2(fd, destfd) < 0 ? -1 : 0;
+}
+
+/**
+ * open_redirection() - Opens the file of a redirection on a standard I/O
+ * file descriptor. With O_EXCL a file which exists is refused.
+ *
+ * @param filename The file.
+ * @param flags The flags to open the file with.
+ * @param destfd The standard I/O file descriptor.
+ * @return 0 on success or -1 on failure, which is written to stderr.
+ */
+static int open_redirection(const char *filename, int flags, int destfd){
+	int fd = open(filename, flags, 0773);
+	if(fd < 0){
+		if(errno == EEXIST){
+			write_error(NULL, "File already exists!");
+		}
+		else{
+			write_error(filename, strerrordesc_np(errno));
+		}
+		return -1;
+	}
+	if(fd != destfd){
+		if(dup2(fd, destfd) < 0){
+			write_error(filename, strerrordesc_np(errno));
+			close(fd);
+			return -1;
+		}
+		close(fd);
+	}
+	return 0;
+}
+
+/**
+ * write_exec_status() - Writes to the exec status pipe if there is one.
+ *
+ * @param exec_fd The write end of the pipe or -1.
+ * @param status What to write.
+ * @param len The length of status.
+ */
+static void write_exec_status(int exec_fd, const void *status, size_t len){
+	if(exec_fd >= 0 && write(exec_fd, status, len) < 0){
+		write_error("Exec status pipe", strerrordesc_np(errno));
+	}
+}
+
+/**
+ * write_error() - Writes "name: message" to stderr with one write(2), so it
+ * is safe in a forked child and not mixed with other output.
+ *
+ * @param name What the message is about, or NULL.
+ * @param message The message.
+ */
+static void write_error(const char *name, const char *message){
+	char line[ERROR_LEN];
+	size_t len = 0;
+	const char *parts[] = {name, name != NULL ? ": " : NULL, message};
+
+	//Cut to leave room for the newline.
+	for(size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++){
+		if(parts[i] == NULL){
+			continue;
+		}
+		size_t part_len = strlen(parts[i]);
+		if(part_len > sizeof(line) - 1 - len){
+			part_len = sizeof(line) - 1 - len;
+		}
+		memcpy(line + len, parts[i], part_len);
+		len += part_len;
+	}
+	line[len++] = '\n';
+	if(write(STDERR_FILENO, line, len) < 0){
+		return; //Nothing more can be done in the child.
+	}
+}
+
+/**
+ * monotonic_now() - Gets the time of the monotonic clock, the same clock as
+ * stats_now(), which the library is built without.
+ *
+ * @return The time in nanoseconds.
+ */
+static uint64_t monotonic_now(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
@@ -0,0 +1,137 @@
+/*
+ * launch.h Is the header file for the launch core of mish, which forks the
+ * commands of a pipeline connected by pipes and executes them. The shell, the
+ * server and libmish all start their pipelines with it, see mish.c, serve.h
+ * and libmish.h.
+ *
+ * Between the fork and the exec the child only makes async-signal-safe calls,
+ * since the child of a program with threads has only the thread which forked
+ * it, and a lock held by another thread is never released in it. The path of
+ * a command is found in PATH by the parent before the fork, and the child
+ * runs it with execv(). The child writes its errors to stderr with write(2)
+ * and exits with LAUNCH_EXEC_FAILED if the command could not be executed, or
+ * 1 if a redirection failed. An output file which exists is not replaced. The
+ * hooks of the caller which run in the child must keep to the same calls if
+ * the program has threads.
+ *
+ * A command whose internal field is set is not executed. The child runs it
+ * with the run_internal hook after its redirections, like the stage commands
+ * of the shell. The pipes are created close-on-exec, so commands started by
+ * other threads never hold them, and the child closes the ends it does not
+ * use.
+ *
+ * A stage which executes a command may get an exec status pipe. Right before
+ * the exec the child writes the time of the exec to it, from the monotonic
+ * clock in nanoseconds like stats_now(), and a byte after that if it could
+ * not execute the command. The pipe is closed by the exec.
+ *
+ * The paths which commands were found at in PATH may be kept in a cache,
+ * which is used by one thread at a time. A cached path is checked with one
+ * access() before it is used, and looked up again if it is no longer
+ * executable or PATH has changed. A command installed earlier in PATH after
+ * it was cached is not seen until it falls out of the cache.
+ *
+ * The and-or lists of a line are split and decided with the same helpers in
+ * the shell, the server and libmish, see launch_pipeline_length() and
+ * launch_runs_after().
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef LAUNCH_H_
+#define LAUNCH_H_
+
+#include "parser.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Defines */
+#define LAUNCH_EXEC_FAILED 127	//The status of a command which could not be executed
+
+/*Where commands were found in PATH, see launch_paths_new().*/
+typedef struct launch_paths launch_paths;
+
+/*A stage which launch_pipeline() has forked, given to the started hook.*/
+typedef struct launch_child{
+	pid_t pid;
+	const command *cmd;	//The command of the stage.
+	int stage;	//The index of the command in the pipeline.
+	int in_fd;	//The read end of the pipe the stage reads, or -1.
+	int exec_fd;	//The read end of the exec status pipe, or -1.
+	int path_hit;	//If the path of the command was found in the cache.
+	uint64_t forked;	//When the stage was forked, like stats_now().
+}launch_child;
+
+/*How launch_pipeline() connects and starts a pipeline.*/
+typedef struct launch_spec{
+	int stdin_fd;	//Replaces stdin of the first command, -1 to keep it.
+	int stdout_fd;	//Replaces stdout of the last command, -1 to keep it.
+	int stderr_fd;	//Replaces stderr of all commands, -1 to keep it.
+	int exec_status;	//If the stages get exec status pipes.
+	launch_paths *paths;	//The cache of the paths of commands, or NULL.
+	//Run in the child after its stdio is set up, or NULL.
+	void (*setup)(int stage, void *arg);
+	//Runs an internal command in the child and returns its exit status.
+	int (*run_internal)(command *cmd, void *arg);
+	//Run in the parent after each fork, or NULL. The caller owns exec_fd.
+	void (*started)(const launch_child *child, void *arg);
+	void *arg;	//Given to the hooks.
+}launch_spec;
+
+/**
+ * launch_spec_init() - Sets a spec to the defaults, the caller's stdio, no
+ * exec status pipes and no hooks.
+ *
+ * @param spec The spec.
+ */
+void launch_spec_init(launch_spec *spec);
+
+/**
+ * launch_pipeline() - Forks the commands of a pipeline connected by pipes.
+ * The parent does not wait for the children. If a pipe or fork fails, no more
+ * commands are started and the ones which were see end of file. The file
+ * descriptors of the spec are not closed.
+ *
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @param spec How the pipeline is connected and started.
+ * @return The number of commands started, less than number_of_commands with
+ * errno set on failure.
+ */
+int launch_pipeline(command *command_array, int number_of_commands, \
+		const launch_spec *spec);
+
+/**
+ * launch_pipeline_length() - Counts the commands of the pipeline which
+ * starts the array, the commands joined by "|" or "|+".
+ *
+ * @param command_array An array with the commands.
+ * @param number_of_commands The number of commands in the array.
+ * @return The number of commands in the pipeline.
+ */
+int launch_pipeline_length(const command *command_array, \
+		int number_of_commands);
+
+/**
+ * launch_runs_after() - Decides if the pipeline after a separator is run. A
+ * pipeline after "&&" is only run if the status is 0 and a pipeline after
+ * "||" only if it is not. A skipped pipeline keeps the status, so
+ * "false && a || b" runs b.
+ *
+ * @param separator The separator after the last pipeline.
+ * @param status The status of the last pipeline which was run.
+ * @return 1 if the next pipeline is run, else 0.
+ */
+int launch_runs_after(int separator, int status);
+
+/**
+ * launch_paths_new() - Creates an empty cache of the paths of commands.
+ *
+ * @param slots The number of commands the cache holds.
+ * @return The cache or NULL if there is no memory.
+ */
+launch_paths *launch_paths_new(int slots);
+
+#endif /* LAUNCH_H_ */
@@ -0,0 +1,344 @@
+/*
+ * libmish.c Is the source code for libmish, the library which runs command
+ * lines of mish in the calling program. See the header file for more
+ * information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "libmish.h"
+#include "parser.h"
+#include "launch.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/*An and-or list which a thread runs in the background.*/
+typedef struct background_list{
+	command *command_array;
+	int number_of_commands;
+	mish_options opts;
+	pthread_t thread;
+	struct background_list *next;
+}background_list;
+
+/*The pids of a pipeline which start_pipeline() has started.*/
+typedef struct started_pids{
+	pid_t *pids;
+	int number_of_pids;
+}started_pids;
+
+/*Function prototypes.*/
+static int run_and_or_list(command *command_array, int number_of_commands, \
+		mish_options *opts);
+static int start_and_or_list(command *command_array, int number_of_commands, \
+		mish_options *opts, pid_t *pids, background_list **lists);
+static void *run_background_list(void *arg);
+static void join_background_lists(background_list *lists);
+static int start_pipeline(command *command_array, int number_of_commands, \
+		const mish_options *opts, pid_t *pids);
+static void add_started_pid(const launch_child *child, void *arg);
+static int wait_for_pids(pid_t *pids, int number_of_pids);
+static int is_blank(const char *line);
+
+
+/**
+ * mish_options_init() - Sets the options to the defaults, the caller's stdio
+ * and no statuses.
+ *
+ * @param opts The options.
+ */
+void mish_options_init(mish_options *opts){
+	memset(opts, 0, sizeof(*opts));
+	opts->stdin_fd = -1;
+	opts->stdout_fd = -1;
+	opts->stderr_fd = -1;
+}
+
+/**
+ * mish_run() - Runs a command line and waits for all of its commands. The
+ * exit status of a pipeline is the status of its last command, or 128 plus
+ * the signal which killed it. A command which could not be executed exits
+ * with 127.
+ *
+ * @param line The command line.
+ * @param opts The options or NULL for the defaults.
+ * @return The exit status of the last pipeline which was waited for, or -1
+ * with errno set if the line could not be parsed or run.
+ */
+int mish_run(const char *line, mish_options *opts){
+	mish_options defaults;
+	command command_array[MAXCOMMANDS];
+	char *words[MAXWORDS];
+	char text[PARSE_TEXT_LEN];
+	pid_t started[MAXCOMMANDS];
+	int number_started = 0;
+	background_list *lists = NULL;
+	int status = 0;
+
+	if(opts == NULL){
+		mish_options_init(&defaults);
+		opts = &defaults;
+	}
+	opts->number_of_statuses = 0;
+
+	if(strlen(line) >= MAXLINELEN){
+		errno = E2BIG;
+		return -1;
+	}
+	int number_of_commands = parse_r(line, command_array, text, words);
+	if(number_of_commands == 0){
+		if(is_blank(line)){
+			return 0;
+		}
+		errno = EINVAL; //The parser has told what is wrong.
+		return -1;
+	}
+	for(int i = 0; i < number_of_commands; i++){
+		if(command_array[i].separator == SEP_FANOUT){
+			errno = ENOTSUP;
+			return -1;
+		}
+	}
+
+	int start = 0;
+	for(int i = 0; i < number_of_commands && status >= 0; i++){
+		int separator = command_array[i].separator;
+		if(separator == SEP_ASYNC){
+			int n = start_and_or_list(command_array + start, i - start + 1, \
+					opts, started + number_started, &lists);
+			if(n < 0){
+				status = -1;
+			}
+			else{
+				number_started += n;
+				status = 0;
+			}
+		}
+		else if(separator == SEP_SEQ || separator == SEP_END){
+			status = run_and_or_list(command_array + start, i - start + 1, \
+					opts);
+		}
+		else{
+			continue;
+		}
+		start = i + 1;
+	}
+
+	//Nothing is left running when the call returns.
+	int error = errno;
+	join_background_lists(lists);
+	wait_for_pids(started, number_started);
+	errno = error;
+	return status;
+}
+
+/**
+ * run_and_or_list() - Runs the pipelines of an and-or list one after another
+ * and waits for each of them. A pipeline after "&&" is only started if the
+ * status is 0 and a pipeline after "||" only if it is not.
+ *
+ * @param command_array An array with the commands of the list.
+ * @param number_of_commands The number of commands in the array.
+ * @param opts The options, the statuses are stored in them.
+ * @return The exit status of the last pipeline which was run, or -1 if a
+ * pipeline could not be started.
+ */
+static int run_and_or_list(command *command_array, int number_of_commands, \
+		mish_options *opts){
+	pid_t pids[number_of_commands];
+	int status = 0;
+	int run = 1;
+	int start = 0;
+
+	for(int i = 0; i < number_of_commands; i++){
+		int separator = command_array[i].separator;
+		if(separator == SEP_PIPE){
+			continue;
+		}
+		if(run){
+			int n = start_pipeline(command_array + start, i - start + 1, opts, \
+					pids);
+			if(n < 0){
+				return -1;
+			}
+			status = wait_for_pids(pids, n);
+			if(opts->statuses != NULL && \
+					opts->number_of_statuses < opts->max_statuses){
+				opts->statuses[opts->number_of_statuses++] = status;
+			}
+		}
+		run = launch_runs_after(separator, status);
+		start = i + 1;
+	}
+	return status;
+}
+
+/**
+ * start_and_or_list() - Starts an and-or list without waiting for it. A
+ * single pipeline is started directly, a list with "&&" or "||" is run by a
+ * thread of its own since one pipeline must be waited for before the next.
+ * Only the launch core runs in forked children, see launch.h.
+ *
+ * @param command_array An array with the commands of the list.
+ * @param number_of_commands The number of commands in the array.
+ * @param opts The options.
+ * @param pids The array which gets the pids of the started children.
+ * @param lists The lists run by threads, which a started list is added to.
+ * @return The number of children started or -1 on failure.
+ */
+static int start_and_or_list(command *command_array, int number_of_commands, \
+		mish_options *opts, pid_t *pids, background_list **lists){
+	if(launch_pipeline_length(command_array, number_of_commands) == \
+			number_of_commands){
+		return start_pipeline(command_array, number_of_commands, opts, pids);
+	}
+
+	background_list *list = malloc(sizeof(*list));
+	if(list == NULL){
+		return -1;
+	}
+	list->command_array = command_array;
+	list->number_of_commands = number_of_commands;
+	list->opts = *opts;
+	list->opts.statuses = NULL;
+	int error = pthread_create(&list->thread, NULL, run_background_list, list);
+	if(error != 0){
+		free(list);
+		errno = error;
+		return -1;
+	}
+	list->next = *lists;
+	*lists = list;
+	return 0;
+}
+
+/**
+ * run_background_list() - Runs an and-or list in a thread started by
+ * start_and_or_list().
+ *
+ * @param arg The list.
+ * @return NULL.
+ */
+static void *run_background_list(void *arg){
+	background_list *list = arg;
+	run_and_or_list(list->command_array, list->number_of_commands, \
+			&list->opts);
+	return NULL;
+}
+
+/**
+ * join_background_lists() - Waits for the threads of the and-or lists run in
+ * the background and frees the lists.
+ *
+ * @param lists The lists.
+ */
+static void join_background_lists(background_list *lists){
+	while(lists != NULL){
+		background_list *next = lists->next;
+		pthread_join(lists->thread, NULL);
+		free(lists);
+		lists = next;
+	}
+}
+
+/**
+ * start_pipeline() - Forks the commands of a pipeline connected by pipes
+ * with the launch core. If a pipe or fork fails, the commands which were
+ * started are waited for.
+ *
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @param opts The stdio of the pipeline.
+ * @param pids The array which gets the pids of the commands.
+ * @return The number of commands started or -1 on failure.
+ */
+static int start_pipeline(command *command_array, int number_of_commands, \
+		const mish_options *opts, pid_t *pids){
+	started_pids started = {pids, 0};
+	launch_spec spec;
+
+	launch_spec_init(&spec);
+	spec.stdin_fd = opts->stdin_fd;
+	spec.stdout_fd = opts->stdout_fd;
+	spec.stderr_fd = opts->stderr_fd;
+	spec.started = add_started_pid;
+	spec.arg = &started;
+	if(launch_pipeline(command_array, number_of_commands, &spec) < \
+			number_of_commands){
+		int error = errno;
+		wait_for_pids(pids, started.number_of_pids);
+		errno = error;
+		return -1;
+	}
+	return started.number_of_pids;
+}
+
+/**
+ * add_started_pid() - Keeps the pid of a forked command, the started hook of
+ * the launch core.
+ *
+ * @param child The forked command.
+ * @param arg The pids which were started.
+ */
+static void add_started_pid(const launch_child *child, void *arg){
+	started_pids *started = arg;
+	started->pids[started->number_of_pids++] = child->pid;
+}
+
+/**
+ * wait_for_pids() - Waits for children by their pids, so children of other
+ * threads or of the program are not touched.
+ *
+ * @param pids The pids.
+ * @param number_of_pids The number of pids.
+ * @return The exit status of the last child, or -1 if it could not be waited
+ * for.
+ */
+static int wait_for_pids(pid_t *pids, int number_of_pids){
+	int status = 0;
+
+	for(int i = 0; i < number_of_pids; i++){
+		int wait_status;
+		pid_t ret;
+		do{
+			ret = waitpid(pids[i], &wait_status, 0);
+		}while(ret < 0 && errno == EINTR);
+
+		if(ret < 0){
+			status = -1;
+		}
+		else if(WIFSIGNALED(wait_status)){
+			status = 128 + WTERMSIG(wait_status);
+		}
+		else{
+			status = WEXITSTATUS(wait_status);
+		}
+	}
+	return status;
+}
+
+/**
+ * is_blank() - Checks if a line has nothing but whitespace.
+ *
+ * @param line The line.
+ * @return 1 if the line is blank, else 0.
+ */
+static int is_blank(const char *line){
+	for(; *line != '\0'; line++){
+		if(!isspace((unsigned char)*line)){
+			return 0;
+		}
+	}
+	return 1;
+}
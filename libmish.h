@@ -0,0 +1,64 @@
+/*
+ * libmish.h Is the header file for libmish, the library which lets a program
+ * run command lines of mish without starting a shell. A line is parsed by the
+ * parser of mish and its commands are forked and executed directly, so there
+ * is no /bin/sh in between like with system().
+ *
+ * A line may have pipelines separated by "|", ";", "&&", "||" and "&", and
+ * redirections with "<" and ">". Only external commands are run, there are no
+ * internal commands, variables, compound commands or fan-outs. A pipeline
+ * followed by "&" is started without waiting for it, and an and-or list with
+ * "&&" or "||" followed by "&" is run by a thread of its own. mish_run()
+ * waits for them before it returns, so no child or thread is left behind.
+ *
+ * The library keeps no global state. Every call parses into its own buffers
+ * and waits for its own children by pid, so mish_run() may be called from
+ * many threads at once. The commands are started by the launch core of mish,
+ * whose forked children only make async-signal-safe calls before the exec,
+ * see launch.h. The pipes are created close-on-exec, so children started by
+ * other threads never hold them. The program must not ignore
+ * SIGCHLD or reap children it did not start, since the children could not be
+ * waited for then.
+ *
+ * Build with "make libmish.a" or "make libmish.so" and link with -lmish
+ * -pthread.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef LIBMISH_H_
+#define LIBMISH_H_
+
+/*The options of one call of mish_run().*/
+typedef struct mish_options{
+	int stdin_fd;	//The stdin of the commands, -1 for the caller's.
+	int stdout_fd;	//The stdout of the commands, -1 for the caller's.
+	int stderr_fd;	//The stderr of the commands, -1 for the caller's.
+	int *statuses;	//Gets the status of each pipeline waited for, or NULL.
+	int max_statuses;	//The length of statuses.
+	int number_of_statuses;	//Set to the number of statuses stored.
+}mish_options;
+
+/**
+ * mish_options_init() - Sets the options to the defaults, the caller's stdio
+ * and no statuses.
+ *
+ * @param opts The options.
+ */
+void mish_options_init(mish_options *opts);
+
+/**
+ * mish_run() - Runs a command line and waits for all of its commands. The
+ * exit status of a pipeline is the status of its last command, or 128 plus
+ * the signal which killed it. A command which could not be executed exits
+ * with 127.
+ *
+ * @param line The command line.
+ * @param opts The options or NULL for the defaults.
+ * @return The exit status of the last pipeline which was waited for, or -1
+ * with errno set if the line could not be parsed or run.
+ */
+int mish_run(const char *line, mish_options *opts);
+
+#endif /* LIBMISH_H_ */
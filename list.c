@@ -3,6 +3,7 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 /*
  * A ist item which can store any given object. The list is a two directional
@@ -14,6 +15,7 @@
  *
  * Version information:
  *   2018-09-13: v1.0.
+ *   2026-10-18: v1.1. Added the intrusive list and the node pool.
  */
 
 // The list node type.
@@ -23,6 +25,26 @@ struct node{
 	void *val;
 };
 
+// A slab of objects handed out by a list_pool.
+struct slab{
+	struct slab *next;
+	max_align_t objects[];
+};
+
+// An object on the free list of a list_pool.
+struct free_object{
+	struct free_object *next;
+};
+
+// The pool type.
+struct list_pool{
+	size_t object_size;
+	size_t objects_per_slab;
+	struct slab *slabs;	//The newest slab first.
+	size_t slab_used;	//Objects carved out of the newest slab.
+	struct free_object *free;
+};
+
 /**
  * list_new() - Create a new and empty list.
  * Returns: A pointer to the new list.
@@ -241,3 +263,170 @@ void list_kill(list *l){
 	free(l->end);
 	free(l);
 }
+
+/**
+ * ilist_init() - Initializes an empty intrusive list.
+ * @l: The list which to initialize.
+ */
+void ilist_init(ilist *l){
+	l->sentinel.next = &l->sentinel;
+	l->sentinel.prev = &l->sentinel;
+}
+
+/**
+ * ilist_append() - Links the given link at the end of the list.
+ * @link: The link embedded in the object which should be appended.
+ * @l: The list which to append the link to.
+ */
+void ilist_append(list_link *link, ilist *l){
+	link->next = &l->sentinel;
+	link->prev = l->sentinel.prev;
+	l->sentinel.prev->next = link;
+	l->sentinel.prev = link;
+}
+
+/**
+ * ilist_remove() - Unlinks the given link from the list it is linked in.
+ * The object which the link is embedded in is not freed.
+ * @link: The link which to remove.
+ */
+void ilist_remove(list_link *link){
+	link->prev->next = link->next;
+	link->next->prev = link->prev;
+	link->next = NULL;
+	link->prev = NULL;
+}
+
+/**
+ * ilist_is_empty() - Checks if the given intrusive list is empty.
+ * @l: A list the check for emptiness.
+ * Returns: true if the list is empty, else false.
+ */
+bool ilist_is_empty(ilist *l){
+	return l->sentinel.next == &l->sentinel;
+}
+
+/**
+ * ilist_first() - Gets the first link of the list.
+ * @l: The list which to get the first link from.
+ * Returns: The first link or NULL if the list is empty.
+ */
+list_link *ilist_first(ilist *l){
+	if(ilist_is_empty(l)){
+		return NULL;
+	}
+	return l->sentinel.next;
+}
+
+/**
+ * ilist_next() - Gets the link after the given link.
+ * @link: The link where to get the next link of.
+ * @l: The list which the link is linked in.
+ * Returns: The next link or NULL if the given link is the last one.
+ */
+list_link *ilist_next(list_link *link, ilist *l){
+	if(link->next == &l->sentinel){
+		return NULL;
+	}
+	return link->next;
+}
+
+/**
+ * list_pool_new() - Creates a new and empty pool.
+ * @object_size: The size of each object handed out by the pool.
+ * @objects_per_slab: How many objects each slab should hold.
+ * Returns: A pointer to the new pool.
+ */
+list_pool *list_pool_new(size_t object_size, size_t objects_per_slab){
+	list_pool *p = calloc(1, sizeof(*p));
+	if(p == NULL){
+		perror("list.c");
+		exit(errno);
+	}
+
+	//Every object must be able to hold the free list pointer and be aligned.
+	if(object_size < sizeof(struct free_object)){
+		object_size = sizeof(struct free_object);
+	}
+	size_t align = sizeof(max_align_t);
+	p->object_size = (object_size + align - 1) / align * align;
+	p->objects_per_slab = objects_per_slab > 0 ? objects_per_slab : 1;
+
+	return p;
+}
+
+/**
+ * list_pool_alloc() - Gets an object from the pool. The object is zeroed.
+ * @p: The pool which to allocate from.
+ * Returns: A pointer to the object.
+ */
+void *list_pool_alloc(list_pool *p){
+	void *obj;
+
+	if(p->free != NULL){
+		obj = p->free;
+		p->free = p->free->next;
+	}
+	else{
+		if(p->slabs == NULL || p->slab_used == p->objects_per_slab){
+			struct slab *new_slab = malloc(sizeof(struct slab) + \
+					p->object_size * p->objects_per_slab);
+			if(new_slab == NULL){
+				perror("list.c");
+				exit(errno);
+			}
+			new_slab->next = p->slabs;
+			p->slabs = new_slab;
+			p->slab_used = 0;
+		}
+		obj = (char *)p->slabs->objects + p->object_size * p->slab_used;
+		p->slab_used++;
+	}
+
+	memset(obj, 0, p->object_size);
+	return obj;
+}
+
+/**
+ * list_pool_free() - Gives an object back to the pool.
+ * @obj: The object which to give back.
+ * @p: The pool which the object was allocated from.
+ */
+void list_pool_free(void *obj, list_pool *p){
+	struct free_object *freed = obj;
+	freed->next = p->free;
+	p->free = freed;
+}
+
+/**
+ * list_pool_reset() - Gives all objects back to the pool at once. All but the
+ * first slab are freed.
+ * @p: The pool which to reset.
+ */
+void list_pool_reset(list_pool *p){
+	if(p->slabs == NULL){
+		return;
+	}
+
+	//Keep the oldest slab, it is the last one in the chain.
+	while(p->slabs->next != NULL){
+		struct slab *delete_slab = p->slabs;
+		p->slabs = p->slabs->next;
+		free(delete_slab);
+	}
+	p->slab_used = 0;
+	p->free = NULL;
+}
+
+/**
+ * list_pool_kill() - Removes the pool and all objects allocated from it.
+ * @p: The pool which to remove.
+ */
+void list_pool_kill(list_pool *p){
+	while(p->slabs != NULL){
+		struct slab *delete_slab = p->slabs;
+		p->slabs = p->slabs->next;
+		free(delete_slab);
+	}
+	free(p);
+}
@@ -2,6 +2,7 @@
 #define __LIST_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 
 /*
  * A ist item which can store any given object. The list is a two directional
@@ -13,6 +14,7 @@
  *
  * Version information:
  *   2018-09-13: v1.0.
+ *   2026-10-18: v1.1. Added the intrusive list and the node pool.
  */
 
 // The list type.
@@ -128,5 +130,122 @@ list_pos list_remove_element(list_pos pos, list *l);
  */
 void list_kill(list *l);
 
+/*
+ * An intrusive variant of the list above. Instead of the list allocating a
+ * node which points to the stored object, the object itself embeds a
+ * list_link and is linked directly. This removes one allocation per element
+ * and keeps the links next to the data. The objects are typically taken from
+ * a list_pool, so that a whole list can be thrown away at once by resetting
+ * the pool.
+ */
+
+// The link which should be embedded in the objects stored in an ilist.
+typedef struct list_link{
+	struct list_link *next;
+	struct list_link *prev;
+}list_link;
+
+// The intrusive list type. The sentinel is both the header and end position.
+typedef struct ilist{
+	list_link sentinel;
+}ilist;
+
+// Initializer for a statically allocated empty intrusive list.
+#define ILIST_INIT(name) {{&(name).sentinel, &(name).sentinel}}
+
+/**
+ * ilist_entry() - Gets the object which a link is embedded in.
+ * @link: A pointer to the embedded list_link.
+ * @type: The type of the object.
+ * @member: The name of the list_link member in the object.
+ */
+#define ilist_entry(link, type, member) \
+	((type *)((char *)(link) - offsetof(type, member)))
+
+/**
+ * ilist_init() - Initializes an empty intrusive list.
+ * @l: The list which to initialize.
+ */
+void ilist_init(ilist *l);
+
+/**
+ * ilist_append() - Links the given link at the end of the list.
+ * @link: The link embedded in the object which should be appended.
+ * @l: The list which to append the link to.
+ */
+void ilist_append(list_link *link, ilist *l);
+
+/**
+ * ilist_remove() - Unlinks the given link from the list it is linked in.
+ * The object which the link is embedded in is not freed.
+ * @link: The link which to remove.
+ */
+void ilist_remove(list_link *link);
+
+/**
+ * ilist_is_empty() - Checks if the given intrusive list is empty.
+ * @l: A list the check for emptiness.
+ * Returns: true if the list is empty, else false.
+ */
+bool ilist_is_empty(ilist *l);
+
+/**
+ * ilist_first() - Gets the first link of the list.
+ * @l: The list which to get the first link from.
+ * Returns: The first link or NULL if the list is empty.
+ */
+list_link *ilist_first(ilist *l);
+
+/**
+ * ilist_next() - Gets the link after the given link.
+ * @link: The link where to get the next link of.
+ * @l: The list which the link is linked in.
+ * Returns: The next link or NULL if the given link is the last one.
+ */
+list_link *ilist_next(list_link *link, ilist *l);
+
+/*
+ * A pool of fixed size objects. The objects are carved out of large slabs, and
+ * freed objects are kept on a free list to be reused by the next allocation.
+ * All objects can be returned at once with list_pool_reset() which keeps the
+ * first slab for reuse.
+ */
+typedef struct list_pool list_pool;
+
+/**
+ * list_pool_new() - Creates a new and empty pool.
+ * @object_size: The size of each object handed out by the pool.
+ * @objects_per_slab: How many objects each slab should hold.
+ * Returns: A pointer to the new pool.
+ */
+list_pool *list_pool_new(size_t object_size, size_t objects_per_slab);
+
+/**
+ * list_pool_alloc() - Gets an object from the pool. The object is zeroed.
+ * @p: The pool which to allocate from.
+ * Returns: A pointer to the object.
+ */
+void *list_pool_alloc(list_pool *p);
+
+/**
+ * list_pool_free() - Gives an object back to the pool.
+ * @obj: The object which to give back.
+ * @p: The pool which the object was allocated from.
+ */
+void list_pool_free(void *obj, list_pool *p);
+
+/**
+ * list_pool_reset() - Gives all objects back to the pool at once. All but the
+ * first slab are freed.
+ * @p: The pool which to reset.
+ */
+void list_pool_reset(list_pool *p);
+
+/**
+ * list_pool_kill() - Removes the pool and all objects allocated from it.
+ * @p: The pool which to remove.
+ */
+void list_pool_kill(list_pool *p);
+
 
 #endif //__LIST_H_
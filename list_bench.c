@@ -0,0 +1,183 @@
+/*
+ * list_bench.c Is a small benchmark comparing the allocating list with the
+ * intrusive list backed by a list_pool. Both lists are put through the same
+ * append/remove churn as mish's child tracking: every element carries a
+ * payload (a pid), elements are appended at the end and removed from random
+ * positions.
+ *
+ * Usage: list_bench [elements] [rounds]
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#include "list.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/types.h>
+
+/* Defines */
+#define DEFAULT_ELEMENTS 10000
+#define DEFAULT_ROUNDS 100
+#define POOL_SLAB 256
+
+/*The payload used with the intrusive list.*/
+typedef struct bench_child{
+	list_link link;
+	pid_t pid;
+}bench_child;
+
+/*Function prototypes.*/
+double elapsed_ms(struct timespec *start);
+void shuffle(size_t *order, size_t n, unsigned int *seed);
+double bench_list(size_t elements, int rounds, const size_t *order);
+double bench_ilist(size_t elements, int rounds, const size_t *order);
+
+
+/**
+ * main() - Runs both benchmarks with the same removal order and prints the
+ * time per round.
+ * @return 0 on success, 1 on bad arguments.
+ */
+int main(int argc, char *argv[]){
+	size_t elements = DEFAULT_ELEMENTS;
+	int rounds = DEFAULT_ROUNDS;
+
+	if(argc > 1){
+		elements = strtoul(argv[1], NULL, 10);
+	}
+	if(argc > 2){
+		rounds = atoi(argv[2]);
+	}
+	if(elements == 0 || rounds <= 0){
+		fprintf(stderr, "Usage: %s [elements] [rounds]\n", argv[0]);
+		return 1;
+	}
+
+	size_t *order = malloc(elements * sizeof(*order));
+	if(order == NULL){
+		perror("list_bench");
+		return 1;
+	}
+	unsigned int seed = 1;
+	for(size_t i = 0; i < elements; i++){
+		order[i] = i;
+	}
+	shuffle(order, elements, &seed);
+
+	double list_ms = bench_list(elements, rounds, order);
+	double ilist_ms = bench_ilist(elements, rounds, order);
+
+	printf("elements: %zu, rounds: %d\n", elements, rounds);
+	printf("list  + malloc payload: %10.3f ms/round\n", list_ms / rounds);
+	printf("ilist + list_pool:      %10.3f ms/round\n", ilist_ms / rounds);
+	printf("speedup:                %10.2fx\n", list_ms / ilist_ms);
+
+	free(order);
+	return 0;
+}
+
+/**
+ * elapsed_ms() - Gets the milliseconds passed since the given time.
+ * @param start The time to measure from.
+ * @return The number of milliseconds.
+ */
+double elapsed_ms(struct timespec *start){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1e3 + \
+			(now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/**
+ * shuffle() - Shuffles the given array of indices.
+ * @param order The array to shuffle.
+ * @param n The number of elements in the array.
+ * @param seed The seed for rand_r().
+ */
+void shuffle(size_t *order, size_t n, unsigned int *seed){
+	for(size_t i = n - 1; i > 0; i--){
+		size_t j = rand_r(seed) % (i + 1);
+		size_t temp = order[i];
+		order[i] = order[j];
+		order[j] = temp;
+	}
+}
+
+/**
+ * bench_list() - Churns the allocating list: every append allocates the
+ * payload and a node, every removal frees both.
+ * @param elements The number of elements per round.
+ * @param rounds The number of rounds.
+ * @param order The order in which the elements are removed.
+ * @return The total time in milliseconds.
+ */
+double bench_list(size_t elements, int rounds, const size_t *order){
+	list *l = list_new();
+	list_pos *positions = malloc(elements * sizeof(*positions));
+	if(positions == NULL){
+		perror("list_bench");
+		exit(1);
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int r = 0; r < rounds; r++){
+		for(size_t i = 0; i < elements; i++){
+			pid_t *pid = malloc(sizeof(*pid));
+			*pid = (pid_t)i;
+			positions[i] = list_append(pid, l);
+		}
+		for(size_t i = 0; i < elements; i++){
+			pid_t *pid = list_get_value(positions[order[i]]);
+			list_remove_element(positions[order[i]], l);
+			free(pid);
+		}
+	}
+	double ms = elapsed_ms(&start);
+
+	free(positions);
+	list_kill(l);
+	return ms;
+}
+
+/**
+ * bench_ilist() - Churns the intrusive list: the payload and the link are
+ * one object taken from a pool.
+ * @param elements The number of elements per round.
+ * @param rounds The number of rounds.
+ * @param order The order in which the elements are removed.
+ * @return The total time in milliseconds.
+ */
+double bench_ilist(size_t elements, int rounds, const size_t *order){
+	ilist l;
+	ilist_init(&l);
+	list_pool *pool = list_pool_new(sizeof(bench_child), POOL_SLAB);
+	bench_child **children = malloc(elements * sizeof(*children));
+	if(children == NULL){
+		perror("list_bench");
+		exit(1);
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int r = 0; r < rounds; r++){
+		for(size_t i = 0; i < elements; i++){
+			children[i] = list_pool_alloc(pool);
+			children[i]->pid = (pid_t)i;
+			ilist_append(&children[i]->link, &l);
+		}
+		for(size_t i = 0; i < elements; i++){
+			ilist_remove(&children[order[i]]->link);
+			list_pool_free(children[order[i]], pool);
+		}
+		list_pool_reset(pool);
+	}
+	double ms = elapsed_ms(&start);
+
+	free(children);
+	list_pool_kill(pool);
+	return ms;
+}
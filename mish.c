@@ -12,6 +12,77 @@
  *
  * If EOF is passed to the stdin of the shell, the shell will exit.
  *
+ * If a script is given as argument, its lines are run instead of reading
+ * commands from stdin. The parsed script is cached, see scriptcache.h. With
+ * "-e" the script stops at the first line which fails, and with "-r JOURNAL"
+ * the lines which have run are journaled, so running the script again skips
+ * the lines which succeeded, see journal.h.
+ *
+ * With "-c STRING" the string is run as one command line. If it is a single
+ * external command, mish executes it in place instead of forking and waiting.
+ *
+ * Pipelines separated by "&" are run at the same time and the shell waits for
+ * all of them before reading the next line. With "tagout on" the stdout and
+ * stderr of every such pipeline is captured and written line by line, tagged
+ * with the job id and a timestamp, so the output of the jobs stays readable.
+ *
+ * Pipelines separated by ";" are run one after another. With "&&" the next
+ * pipeline is only run if the previous one succeeded and with "||" only if it
+ * failed, skipped pipelines are never started. The exit status of a pipeline
+ * is the status of its last command. An and-or list followed by "&" is run by
+ * a forked copy of the shell.
+ *
+ * Words are quoted with '...' or "..." and characters are escaped with \, so
+ * a word may hold spaces and operators, see parse() in parser.c.
+ *
+ * The compound commands if, while and for are parsed once into a tree, see
+ * ast.h, and run from the tree, so a loop body is not parsed again for every
+ * round. Shell variables are set with "name=value" and substituted in the
+ * words of a pipeline when it is run, see vars.h.
+ *
+ * A group "{ list; }" is run by the shell itself, with its redirections
+ * applied to the fds of the shell while it runs. A subshell "( list )" is
+ * only forked if its list changes the shell, with "cd", "tagout", "fg", an
+ * assignment or a for loop, else it is run like a group.
+ *
+ * A "$(line)" in a word is replaced by the output of the line, which is run
+ * by a forked copy of the shell. The output is read into one buffer by the
+ * wait loop of the shell while it waits for the copy, so other children are
+ * still reaped and a large output never fills the pipe.
+ *
+ * When the shell reads commands from a terminal, every pipeline is run in a
+ * process group of its own which is given the terminal while the shell waits
+ * for it. Ctrl-C and Ctrl-Z then reach the whole pipeline from the kernel. A
+ * stopped pipeline is continued with "fg" and listed with "jobs".
+ *
+ * The commands of a pipeline are forked and executed by the launch core,
+ * which the server and libmish share, see launch.h. Stage commands like
+ * "buffer" and "batch" are run by the forked child of the pipeline instead of
+ * executing an external command, see buffer.h and batch.h.
+ *
+ * The shell counts what it does and times the parsing, the starting of the
+ * children and the pipelines, which "stats" prints, see stats.h. Every child
+ * which executes a command has an exec status pipe, which is read when the
+ * child is reaped, see jobs.h.
+ *
+ * With "|+" the output of a pipeline is given to several pipelines at once,
+ * see fanout.h.
+ *
+ * With the "bench" prefix a pipeline is run several times and its runs are
+ * timed, see bench.h. With the "cache" prefix the output of a pipeline is
+ * replayed from a cache when it has run before, see outcache.h. With the
+ * "watch" prefix a pipeline is run again whenever a file changes, see
+ * watch.h. With the "pipeprof" prefix the pipes and stages of a pipeline are
+ * sampled while it runs to find its bottleneck, see pipeprof.h.
+ *
+ * A pipeline of builtins which print or copy their input, like
+ * "stats -j | pass", is run by threads of the shell connected by pipes in
+ * memory, see threadpipe.h, so it needs no fork, exec or pipe. "pass" copies
+ * its input to its output like cat without files.
+ *
+ * With "--serve SOCKET" mish runs command lines sent to it over a Unix
+ * socket instead, see serve.h.
+ *
  *  Created on: 29 Oct 2018
  *      Author: Bram Coenen (tfy15bcn)
  *     Version: 2
@@ -22,6 +93,25 @@
 #include "execute.h"
 #include "list.h"
 #include "sighant.h"
+#include "mux.h"
+#include "placement.h"
+#include "timeout.h"
+#include "scriptcache.h"
+#include "ast.h"
+#include "vars.h"
+#include "buffer.h"
+#include "stats.h"
+#include "fanout.h"
+#include "bench.h"
+#include "serve.h"
+#include "outcache.h"
+#include "threadpipe.h"
+#include "batch.h"
+#include "watch.h"
+#include "pipeprof.h"
+#include "journal.h"
+#include "launch.h"
+#include "hash.h"
 
 /* Standard libraries */
 #include <stdio.h>
@@ -32,23 +122,217 @@
 #include <sys/wait.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <pwd.h>
+#include <sys/epoll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <getopt.h>
 
 
 /* Defines */
 #define PRINT_PROMPT fprintf(stderr, "mish%% "); fflush(stderr);
+#define PRINT_CONTINUATION fprintf(stderr, "> "); fflush(stderr);
+#define MISH_USAGE "Usage: mish [-c string | --serve socket | " \
+		"[-e] [-r journal] script]\n"
+#define WAIT_EVENTS 16 //Events handled per round of the wait loop
+#define CAPTURE_READ_MIN 65536 //Free room for each read of a substitution
+#define SAVED_FD_MIN 10 //The lowest fd which the fds of a group are kept in
+#define PATH_CACHE_SLOTS 256 //Commands in the PATH cache
+
+/*Options for how pipe_and_fork_commands() connects a pipeline.*/
+typedef struct launch_options{
+	int stdin_fd;	//Replaces stdin of the first command, -1 to keep it.
+	int stdout_fd;	//Replaces stdout of the last command, -1 to keep it.
+	int stderr_fd;	//Replaces stderr of all commands, -1 to keep it.
+	const placement *placement;	//CPU and scheduling placement or NULL.
+	shell_job *job;	//The job the children belong to.
+	int foreground;	//If the job should be given the terminal.
+	int first_stage;	//The stage of the first command in the job.
+	int ends_job;	//If the last command is the last stage of the job.
+	profiler *profile;	//Samples the stages and pipes, or NULL.
+	int own_group;	//If the job is a process group also without job control.
+}launch_options;
+
+/*The output of a command substitution which is being read.*/
+typedef struct substitution_capture{
+	int fd;
+	char *data;
+	size_t used;
+	size_t size;
+}substitution_capture;
+
+/*The prefixes which may start a pipeline.*/
+typedef struct pipeline_prefixes{
+	int pinned;
+	placement pin;
+	int timed;
+	timeout_spec deadline;
+	int benched;
+	bench_spec bench;
+	int cached;
+	outcache_spec cache;
+	int watched;
+	watch_spec watch;
+	int profiled;
+	pipeprof_spec profile;
+}pipeline_prefixes;
+
+/*A builtin of a pipeline run by run_thread_pipeline().*/
+typedef struct thread_stage{
+	command *cmd;
+	FILE *in;	//The read end of the previous pipe, or NULL.
+	FILE *out;	//The write end of the next pipe, or stdout.
+	int status;
+	pthread_t thread;
+}thread_stage;
+
+/*The size and the next string of the state of the shell which is being
+ *built, see shell_state().*/
+typedef struct state_builder{
+	size_t strings;	//The number of strings, without the NULL.
+	size_t bytes;	//The bytes of the text of the strings.
+	char **next;
+	char *text;	//Where the text of the next string goes.
+}state_builder;
+
+/*Internal commands, run by the shell itself.*/
+static const char *internal_command_names[] = {"cd", "echo", "tagout", "fg", \
+		"jobs", "stats", "pass", NULL};
+
+/*Internal commands which may run as a thread, they print or copy.*/
+static const char *thread_command_names[] = {"echo", "jobs", "stats", "pass", \
+		NULL};
+
+/*Stage commands, run by the forked child of a pipeline stage.*/
+static const char *stage_command_names[] = {"buffer", "batch", NULL};
+
+/*If the output of the jobs should be captured and tagged.*/
+static int tagged_output = 0;
+
+/*The epoll file descriptor which the shell waits for its children on.*/
+static int wait_epoll_fd = -1;
+
+/*Where the commands were found in PATH, created when needed.*/
+static launch_paths *path_cache = NULL;
+
+/*The block of a compound command which is still being read, or NULL.*/
+static ast_block *open_block = NULL;
+
+/*The journal of the script which is run, or NULL, the first line of the
+ *compound command which is run from it and the for loops it has started.*/
+static journal *script_journal = NULL;
+static int journal_line = 0;
+static int journal_loops = 0;
+
+/*The number of loops the node which is run is in.*/
+static int loop_depth = 0;
+
+/*If the pipelines are run in process groups, and the group of the shell.*/
+static int job_control = 0;
+static pid_t shell_pgid = 0;
+
+/*The multiplexer of the line which is run, or NULL.*/
+static mux *line_mux = NULL;
+
+/*The command substitution whose output is being read, or NULL.*/
+static substitution_capture *active_capture = NULL;
+
+/*The watcher of the watch prefix which runs, and its job, or NULL.*/
+static watcher *active_watch = NULL;
+static shell_job *watched_job = NULL;
+
+/*The profiler of the pipeline being run with the pipeprof prefix, or NULL.*/
+static profiler *active_profile = NULL;
 
 /*Function prototypes.*/
+void setup_wait_loop(void);
+void setup_job_control(void);
 void main_shell_loop(void);
-void wait_for_children(void);
-void remove_child_from_list_of_current_children(pid_t complete_child);
+int run_script(const char *path, const char *journal_path, int fail_fast);
+int line_changes_shell_state(command *command_array, int number_of_commands);
+char **shell_state(void);
+void count_state_var(const char *name, const char *value, void *arg);
+void copy_state_var(const char *name, const char *value, void *arg);
+void restore_shell_state(char **state);
+int timed_parse(char *line, command *command_array);
+int run_command_string(char *line);
+int can_exec_in_place(command *command_array, int number_of_commands, \
+		pipeline_prefixes *prefixes);
+int run_parsed_line(command *command_array, int number_of_commands);
+void close_open_block(const char *source);
+int run_node(ast_node *node);
+int run_for(ast_node *node);
+int run_group(ast_node *node);
+int run_subshell(ast_node *node);
+int changes_shell_state(ast_node *node);
+int commands_change_shell_state(command *command_array, \
+		int number_of_commands);
+int redirect_group(command *closing, int *saved_in, int *saved_out);
+void restore_group(int saved_in, int saved_out);
+void exec_in_place(command *cmd, pipeline_prefixes *prefixes);
+int run_command_line(command *command_array, int number_of_commands, \
+		int exec_last);
+int run_and_or_list(command *command_array, int number_of_commands, \
+		mux *output_mux, int exec_last);
+void start_and_or_list(command *command_array, int number_of_commands, \
+		mux *output_mux);
+void start_subshell(command *command_array, int number_of_commands, \
+		mux *output_mux);
+void setup_subshell(void);
+char *run_substitution(const char *line, size_t *len);
+int read_capture(substitution_capture *capture);
+shell_job *run_pipeline(command *command_array, int number_of_commands, \
+		mux *output_mux, int foreground);
+shell_job *start_pipeline(command *command_array, int number_of_commands, \
+		mux *output_mux, int foreground);
+shell_job *launch_job(command *command_array, int number_of_commands, \
+		launch_options *options, const pipeline_prefixes *prefixes, \
+		mux *output_mux);
+int run_bench(command *command_array, int number_of_commands, \
+		launch_options *options, const pipeline_prefixes *prefixes, \
+		mux *output_mux);
+int run_cached(command *command_array, int number_of_commands, \
+		launch_options *options, const pipeline_prefixes *prefixes, \
+		mux *output_mux);
+int run_watch(command *command_array, int number_of_commands, \
+		launch_options *options, const pipeline_prefixes *prefixes, \
+		mux *output_mux);
+int run_profile(command *command_array, int number_of_commands, \
+		launch_options *options, const pipeline_prefixes *prefixes, \
+		mux *output_mux);
+shell_job *finished_job(int status);
+int open_capture(int out_pipe[2], int err_pipe[2]);
+void hand_over_capture(mux *output_mux, int out_pipe[2], int err_pipe[2], \
+		int job_id);
+int parse_prefixes(command *cmd, pipeline_prefixes *prefixes);
+int strip_prefix(command *cmd, int words);
+int wait_for_job(shell_job *job, mux *output_mux);
+void wait_for_children(mux *output_mux);
+void wait_loop(shell_job *job, mux *output_mux);
+void reap_children(void);
+int is_internal_command(const char *name);
+int is_stage_command(const char *name);
+int run_stage_command(command cmd);
 int check_for_internal_commands(command *command_array, int number_of_commands);
-void run_internal_commands(command *command_array, int number_of_commands);
-void internal_cd(char *dir);
-char *get_home_directory(void);
-void internal_echo(char **message, int words);
-void pipe_and_fork_commands(command *command_array, int number_of_commands);
-void free_and_kill_entire_list(void);
+int run_internal_commands(command *command_array, int number_of_commands);
+int is_thread_pipeline(command *command_array, int number_of_commands);
+int run_thread_pipeline(command *command_array, int number_of_commands);
+void *run_thread_stage(void *arg);
+int internal_cd(char *dir);
+const char *get_home_directory(void);
+int internal_echo(char **message, int words, FILE *out);
+int internal_tagout(char *mode);
+int internal_fg(char *id);
+int internal_jobs(FILE *out);
+int internal_pass(FILE *in, FILE *out);
+void pipe_and_fork_commands(command *command_array, int number_of_commands, \
+		const launch_options *options);
+void fork_fan_out(command *command_array, int number_of_commands, \
+		const launch_options *options);
+void setup_stage(int stage, void *arg);
+int run_stage_hook(command *cmd, void *arg);
+void add_stage_child(const launch_child *launched, void *arg);
+void start_fan_out_helper(int producer_pipe[2], int consumer_pipes[][2], \
+		int consumers, const launch_options *options, int stage);
 int execute_external_command(command cmd);
 int redirect_external_command(command cmd);
 
@@ -56,114 +340,1886 @@ int redirect_external_command(command cmd);
 
 
 /**
- * main() - The main function of the program contains an eternal loop to process
- * the commands given to the mish terminal. This loop can only be terminated
- * using the signal.
- * @return 0, but should never happen.
+ * main() - The main function of the program contains an eternal loop to process
+ * the commands given to the mish terminal. This loop can only be terminated
+ * using the signal. If a script or a command string is given, it is run
+ * instead, and with --serve mish runs as a server.
+ *
+ * Usage: mish [-c string | --serve socket | [-e] [-r journal] script]
+ * @return The exit status of the last pipeline of the script or string, or 1
+ * if it could not be run.
+ */
+int main(int argc, char *argv[]) {
+	int ret = 0;
+
+	vars_set_substitute(run_substitution);
+
+	if(argc > 1 && strcmp(argv[1], "--serve") == 0){
+		if(argc != 3){
+			fprintf(stderr, MISH_USAGE);
+			return 1;
+		}
+		return serve_main(argv[2]);
+	}
+	if(argc > 1 && strcmp(argv[1], "-c") == 0){
+		if(argc < 3){
+			fprintf(stderr, MISH_USAGE);
+			return 1;
+		}
+		//Sets up the shell itself only if the string is not exec'd.
+		return run_command_string(argv[2]);
+	}
+
+	const char *journal_path = NULL;
+	int fail_fast = 0;
+	int opt;
+	while((opt = getopt(argc, argv, "+er:")) != -1){
+		switch(opt){
+		case 'e':
+			fail_fast = 1;
+			break;
+		case 'r':
+			journal_path = optarg;
+			break;
+		default:
+			fprintf(stderr, MISH_USAGE);
+			return 1;
+		}
+	}
+	if(optind == argc && (fail_fast || journal_path != NULL)){
+		fprintf(stderr, MISH_USAGE);
+		return 1;
+	}
+
+	setup_signal_handling();
+	setup_wait_loop();
+
+	if(optind < argc){
+		ret = run_script(argv[optind], journal_path, fail_fast);
+	}
+	else{
+		setup_job_control();
+		main_shell_loop();
+	}
+
+    jobs_hangup();
+    jobs_forget(); // The lists should only hold stopped jobs
+    return ret;
+}
+
+/**
+ * setup_wait_loop() - Creates the epoll file descriptor which the shell waits
+ * on and adds the read end of the signal pipe to it.
+ */
+void setup_wait_loop(void){
+	wait_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(wait_epoll_fd < 0){
+		perror("epoll_create1");
+		exit(1);
+	}
+
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = shell_signal_pipe[READ_END];
+	if(epoll_ctl(wait_epoll_fd, EPOLL_CTL_ADD, event.data.fd, &event) < 0){
+		perror("epoll_ctl");
+		exit(1);
+	}
+}
+
+/**
+ * setup_job_control() - Turns on job control if the shell reads from a
+ * terminal. The shell waits until it is in the foreground, puts itself in its
+ * own process group and takes the terminal.
+ */
+void setup_job_control(void){
+	if(!isatty(STDIN_FILENO)){
+		return;
+	}
+
+	while(tcgetpgrp(STDIN_FILENO) != (shell_pgid = getpgrp())){
+		kill(-shell_pgid, SIGTTIN);
+	}
+	ignore_job_control_signals();
+
+	//A session leader already has its own group and may not change it.
+	if(setpgid(0, 0) < 0 && errno != EPERM){
+		perror("Job control");
+		return;
+	}
+	shell_pgid = getpgrp();
+	if(tcsetpgrp(STDIN_FILENO, shell_pgid) < 0){
+		perror("Job control");
+		return;
+	}
+	job_control = 1;
+}
+
+/**
+ * main_shell_loop() - The main loop for the shell. This function handles the
+ * given commands given to stdin. A parse is done on the input and the parsed
+ * command line is run.
+ */
+void main_shell_loop(void){
+	char input_line[MAXLINELEN+1];
+	command command_array[MAXCOMMANDS];
+
+	while(1){ //Main terminal loop, only quit due to signal.
+		if(open_block != NULL){
+			PRINT_CONTINUATION;
+		}
+		else{
+			PRINT_PROMPT;
+		}
+
+		if(fgets(input_line, MAXLINELEN, stdin) == NULL){
+			if( feof(stdin) ) {
+				break;
+			}
+			else if(errno != 0){
+				perror("Reading input");
+				continue;
+			}
+			else{
+				break;
+			}
+		}
+		int number_of_commands = timed_parse(input_line, command_array);
+
+		shell_interrupted = 0;
+		shell_interrupt_pending = 0;
+		run_parsed_line(command_array, number_of_commands);
+	}
+	close_open_block("input");
+}
+
+/**
+ * run_script() - Runs every line of a script. The lines are taken parsed from
+ * the compiled script, so they are not parsed again when it is cached.
+ *
+ * With a journal, lines which succeeded in an earlier run are skipped and
+ * every line which runs is journaled when it, or the compound command it
+ * belongs to, has ended. A line which changes the shell is journaled with
+ * the state of the shell after it, which is put back when it is skipped. The
+ * rounds of the for loops are journaled too, see run_for(). A line with a
+ * syntax error fails with status 2, so it is never journaled as done. See
+ * journal.h.
+ *
+ * @param path The path of the script.
+ * @param journal_path The path of the journal or NULL.
+ * @param fail_fast 1 to stop at the first line which fails, else 0.
+ * @return The exit status of the last line or 1 if the script or journal
+ * could not be opened.
+ */
+int run_script(const char *path, const char *journal_path, int fail_fast){
+	command command_array[MAXCOMMANDS];
+	char *words[MAXWORDS];
+	int status = 0;
+
+	script *s = script_open(path);
+	if(s == NULL){
+		return 1;
+	}
+	stats_count(script_from_cache(s) ? STATS_CACHE_HITS : STATS_PARSED, \
+			script_lines(s));
+
+	journal *j = NULL;
+	if(journal_path != NULL){
+		j = journal_open(journal_path, script_hash(s), script_lines(s));
+		if(j == NULL){
+			script_close(s);
+			return 1;
+		}
+		if(journal_done_lines(j) > 0){
+			fprintf(stderr, "%s: resuming, %d lines are done\n", path, \
+					journal_done_lines(j));
+		}
+	}
+	script_journal = j;
+
+	int first_line = 0;	//The first line of the compound command.
+	int changes_shell = 0;	//If the lines since first_line change the shell.
+	int syntax_error = 0;	//If a line since first_line could not be parsed.
+	for(int i = 0; i < script_lines(s); i++){
+		if(open_block == NULL){
+			if(j != NULL && journal_is_done(j, i)){
+				if(journal_state(j, i) != NULL){
+					restore_shell_state(journal_state(j, i));
+				}
+				status = 0;
+				continue;
+			}
+			first_line = i;
+			changes_shell = 0;
+			syntax_error = 0;
+			journal_line = i;
+			journal_loops = 0;
+		}
+		int number_of_commands = script_get_line(s, i, command_array, words);
+		if(number_of_commands < 0){
+			syntax_error = 1;
+			number_of_commands = 0;
+		}
+		changes_shell |= line_changes_shell_state(command_array, \
+				number_of_commands);
+
+		status = run_parsed_line(command_array, number_of_commands);
+		if(open_block != NULL){
+			continue;
+		}
+		if(syntax_error){
+			status = 2;
+		}
+		//A line which is done must be able to put back the shell.
+		int keeps_state = j != NULL && changes_shell && status == 0;
+		char **state = keeps_state ? shell_state() : NULL;
+		for(int line = first_line; j != NULL && (state != NULL || \
+				!keeps_state) && line <= i; line++){
+			journal_record(j, line, status, line == i ? state : NULL);
+		}
+		free(state);
+		if(fail_fast && status != 0){
+			break;
+		}
+	}
+	close_open_block("script");
+	script_journal = NULL;
+
+	if(j != NULL){
+		journal_close(j);
+	}
+	script_close(s);
+	return status;
+}
+
+/**
+ * line_changes_shell_state() - Checks if a line of a script may change the
+ * state of the shell, see changes_shell_state(), before it is built into a
+ * compound command.
+ *
+ * @param command_array An array of parsed commands.
+ * @param number_of_commands The number of commands in the array.
+ * @return 1 if the line may change the shell, else 0.
+ */
+int line_changes_shell_state(command *command_array, int number_of_commands){
+	for(int i = 0; i < number_of_commands; i++){
+		if(strcmp(command_array[i].argv[0], "for") == 0){
+			return 1; //The loop sets its variable.
+		}
+	}
+	return commands_change_shell_state(command_array, number_of_commands);
+}
+
+/**
+ * shell_state() - Gets the state of the shell which a journaled line is
+ * recorded with, see journal.h. The strings are the working directory, "on"
+ * or "off" for the tagout mode and a "name=value" for every shell variable.
+ *
+ * @return The state, one allocation which the caller frees, or NULL if the
+ * working directory is not known.
+ */
+char **shell_state(void){
+	char *cwd = getcwd(NULL, 0);
+	if(cwd == NULL){
+		perror("Journal");
+		return NULL;
+	}
+
+	const char *mode = tagged_output ? "on" : "off";
+	state_builder builder = {2, strlen(cwd) + strlen(mode) + 2, NULL, NULL};
+	vars_each(count_state_var, &builder);
+	char **state = malloc((builder.strings + 1) * sizeof(*state) + \
+			builder.bytes);
+	if(state == NULL){
+		perror("mish.c");
+		exit(errno);
+	}
+
+	builder.next = state;
+	builder.text = (char *)(state + builder.strings + 1);
+	*builder.next++ = builder.text;
+	builder.text = stpcpy(builder.text, cwd) + 1;
+	*builder.next++ = builder.text;
+	builder.text = stpcpy(builder.text, mode) + 1;
+	vars_each(copy_state_var, &builder);
+	*builder.next = NULL;
+	free(cwd);
+	return state;
+}
+
+/**
+ * count_state_var() - Counts a shell variable into the size of the state of
+ * the shell, see shell_state().
+ *
+ * @param name The name of the variable.
+ * @param value The value of the variable.
+ * @param arg The state_builder.
+ */
+void count_state_var(const char *name, const char *value, void *arg){
+	state_builder *builder = arg;
+	builder->strings++;
+	builder->bytes += strlen(name) + strlen(value) + 2;
+}
+
+/**
+ * copy_state_var() - Copies a shell variable into the state of the shell as
+ * "name=value", see shell_state().
+ *
+ * @param name The name of the variable.
+ * @param value The value of the variable.
+ * @param arg The state_builder.
+ */
+void copy_state_var(const char *name, const char *value, void *arg){
+	state_builder *builder = arg;
+	*builder->next++ = builder->text;
+	builder->text += sprintf(builder->text, "%s=%s", name, value) + 1;
+}
+
+/**
+ * restore_shell_state() - Puts back the state of the shell after a journaled
+ * line or round which is skipped, see shell_state(). Shell variables which
+ * are not in the state are kept.
+ *
+ * @param state The state.
+ */
+void restore_shell_state(char **state){
+	if(state[0] == NULL || state[1] == NULL){
+		return;
+	}
+	if(chdir(state[0]) < 0){
+		perror(state[0]);
+	}
+	tagged_output = strcmp(state[1], "on") == 0;
+
+	for(int i = 2; state[i] != NULL; i++){
+		char *equals = strchr(state[i], '=');
+		if(equals != NULL){
+			*equals = '\0';
+			vars_set(state[i], equals + 1);
+			*equals = '=';
+		}
+	}
+}
+
+/**
+ * timed_parse() - Parses a line in place and counts and times the parse. The
+ * commands point into the line and into words which are kept until the next
+ * parse, see parse_in_place(). The words keep their quotes, which are removed
+ * when they are substituted, see vars.h.
+ *
+ * @param line The line, which is changed.
+ * @param command_array The array to put the commands in.
+ * @return The number of commands, see parse().
+ */
+int timed_parse(char *line, command *command_array){
+	static char *words[MAXWORDS];
+	uint64_t start = stats_now();
+	int number_of_commands = parse_in_place(line, command_array, words, \
+			PARSE_KEEP_QUOTES);
+	stats_time(STATS_PARSE_TIME, stats_now() - start);
+	stats_count(STATS_PARSED, 1);
+	return number_of_commands;
+}
+
+/**
+ * run_command_string() - Runs the string given with -c. When the string is a
+ * single external command it is executed in place of the shell, so no fork
+ * and wait is needed and the signal handling and wait loop are never set up.
+ * Else the last pipeline is executed in place if it is reached and nothing
+ * runs in the background.
+ *
+ * @param line The command string.
+ * @return The exit status of the last pipeline, 2 on a syntax error or 1 if
+ * the string could not be run.
+ */
+int run_command_string(char *line){
+	command command_array[MAXCOMMANDS];
+
+	if(strlen(line) >= MAXLINELEN){
+		fprintf(stderr, "Line too long.\n");
+		return 1;
+	}
+	int blank = line[strspn(line, " \t\n\v\f\r")] == '\0';
+	int number_of_commands = timed_parse(line, command_array);
+	if(number_of_commands == 0 && !blank){
+		return 2;
+	}
+
+	if(ast_has_keyword(command_array, number_of_commands)){
+		setup_signal_handling();
+		setup_wait_loop();
+		int status = run_parsed_line(command_array, number_of_commands);
+		if(open_block != NULL){
+			close_open_block("string");
+			return 1;
+		}
+		return status;
+	}
+
+	pipeline_prefixes prefixes;
+	int in_place = can_exec_in_place(command_array, number_of_commands, \
+			&prefixes);
+	if(in_place != 0){
+		if(in_place > 0){
+			exec_in_place(&command_array[0], &prefixes);
+		}
+		return 1;
+	}
+
+	int exec_last = 1;
+	for(int i = 0; i < number_of_commands; i++){
+		if(command_array[i].separator == SEP_ASYNC){
+			exec_last = 0;
+		}
+	}
+
+	setup_signal_handling();
+	setup_wait_loop();
+	return run_command_line(command_array, number_of_commands, exec_last);
+}
+
+/**
+ * can_exec_in_place() - Checks if a parsed command line is a single external
+ * command which the shell does not have to wait for, so it can be executed in
+ * place of the shell. Its prefixes are parsed once here, and only a placement
+ * is allowed.
+ *
+ * @param command_array An array of parsed commands.
+ * @param number_of_commands The number of commands in the array.
+ * @param prefixes Set to the prefixes of the command, which are stripped from
+ * it, if it can be executed in place.
+ * @return 1 if the command can be executed in place, -1 if it has a bad
+ * prefix, which has been reported, else 0.
+ */
+int can_exec_in_place(command *command_array, int number_of_commands, \
+		pipeline_prefixes *prefixes){
+	if(number_of_commands != 1 || tagged_output){
+		return 0;
+	}
+
+	//Words with substitutions, a "~" or quotes are only expanded by
+	//run_pipeline().
+	char **argv = command_array[0].argv;
+	int argc = command_array[0].argc;
+	for(int i = 0; i < argc; i++){
+		if(strpbrk(argv[i], "$~" QUOTE_BYTES) != NULL){
+			return 0;
+		}
+	}
+	if((command_array[0].infile != NULL && \
+			strpbrk(command_array[0].infile, "$~" QUOTE_BYTES) != NULL) || \
+			(command_array[0].outfile != NULL && \
+			strpbrk(command_array[0].outfile, "$~" QUOTE_BYTES) != NULL)){
+		return 0;
+	}
+
+	//A placement can be applied to the shell before the exec.
+	command cmd = command_array[0];
+	if(parse_prefixes(&cmd, prefixes) < 0){
+		return -1;
+	}
+	if(prefixes->timed || prefixes->benched || prefixes->cached || \
+			prefixes->watched || prefixes->profiled || \
+			is_internal_command(cmd.argv[0]) || is_stage_command(cmd.argv[0])){
+		return 0;
+	}
+	command_array[0] = cmd;
+	return 1;
+}
+
+/**
+ * exec_in_place() - Executes a single external command in place of the shell.
+ * A placement prefix is applied to the shell before the exec.
+ *
+ * @param cmd The command, which can_exec_in_place() has accepted.
+ * @param prefixes The prefixes which can_exec_in_place() has parsed.
+ */
+void exec_in_place(command *cmd, pipeline_prefixes *prefixes){
+	if(prefixes->pinned){
+		placement_spread(&prefixes->pin);
+		placement_apply(&prefixes->pin, 0);
+	}
+	execute_external_command(*cmd);
+}
+
+/**
+ * run_parsed_line() - Runs a parsed line. A line with a keyword is added to
+ * the open block, which is built and run when all its compound commands are
+ * closed. Other lines are run directly.
+ *
+ * @param command_array An array of parsed commands.
+ * @param number_of_commands The number of commands in the array.
+ * @return The exit status of the line, 0 while a block is still open.
+ */
+int run_parsed_line(command *command_array, int number_of_commands){
+	if(open_block == NULL){
+		if(!ast_has_keyword(command_array, number_of_commands)){
+			return run_command_line(command_array, number_of_commands, 0);
+		}
+		open_block = ast_block_new();
+	}
+
+	int open = ast_block_add(open_block, command_array, number_of_commands);
+	if(open > 0){
+		return 0;
+	}
+
+	int status = 1;
+	if(open == 0){
+		ast_node *tree = ast_block_build(open_block);
+		if(tree != NULL){
+			status = run_node(tree);
+		}
+	}
+	ast_block_kill(open_block);
+	open_block = NULL;
+	return status;
+}
+
+/**
+ * close_open_block() - Drops a block which was not closed before the end of
+ * the input.
+ *
+ * @param source What the input was, for the error message.
+ */
+void close_open_block(const char *source){
+	if(open_block != NULL){
+		fprintf(stderr, "Syntax error: unexpected end of %s\n", source);
+		ast_block_kill(open_block);
+		open_block = NULL;
+	}
+}
+
+/**
+ * run_node() - Runs a list of nodes of a compound command. Loops stop when
+ * the shell is interrupted.
+ *
+ * @param node The first node of the list.
+ * @return The exit status of the last node which was run.
+ */
+int run_node(ast_node *node){
+	int status = 0;
+
+	for(; node != NULL && !shell_interrupted; node = node->next){
+		switch(node->kind){
+		case AST_COMMANDS:
+			status = run_command_line(node->commands, \
+					node->number_of_commands, 0);
+			break;
+		case AST_IF:
+			if(run_node(node->condition) == 0){
+				status = run_node(node->body);
+			}
+			else{
+				status = run_node(node->otherwise);
+			}
+			break;
+		case AST_WHILE:
+			status = 0;
+			loop_depth++;
+			while(!shell_interrupted && run_node(node->condition) == 0){
+				status = run_node(node->body);
+			}
+			loop_depth--;
+			break;
+		case AST_FOR:
+			status = run_for(node);
+			break;
+		case AST_GROUP:
+			status = run_group(node);
+			break;
+		case AST_SUBSHELL:
+			status = run_subshell(node);
+			break;
+		default:
+			break;
+		}
+		vars_set_status(status);
+	}
+	return status;
+}
+
+/**
+ * run_for() - Runs the body of a for loop once for every word. The words are
+ * substituted once when the loop starts, like the words of a command, so a
+ * command substitution may give many words.
+ *
+ * In a journaled script, a loop which is not inside another loop journals
+ * every round which succeeds. The rounds which are done in the journal are
+ * skipped and the state of the shell after the last of them is put back, see
+ * journal.h.
+ *
+ * @param node The for node.
+ * @return The exit status of the last round or 1 if the words could not be
+ * substituted.
+ */
+int run_for(ast_node *node){
+	command for_words = {node->words, node->number_of_words, NULL, NULL, 0, \
+			SEP_END};
+	command expanded = {NULL, 0, NULL, NULL, 0, SEP_END};
+	char *words[MAXWORDS];
+	char text[VARS_TEXT_MAX];
+	int status = 0;
+
+	size_t mark = vars_mark();
+	if(node->number_of_words > 0 && \
+			vars_expand(&for_words, 1, &expanded, words, text) < 0){
+		vars_release(mark);
+		return 1;
+	}
+
+	int loop = -1;	//The index of the loop in the journal, or -1.
+	int first_round = 0;
+	uint64_t words_hash = HASH_SEED;
+	if(script_journal != NULL && loop_depth == 0){
+		char **state;
+		loop = journal_loops++;
+		for(int i = 0; i < expanded.argc; i++){
+			words_hash = hash_bytes(expanded.argv[i], \
+					strlen(expanded.argv[i]) + 1, words_hash);
+		}
+		first_round = journal_done_rounds(script_journal, journal_line, loop, \
+				words_hash, &state);
+		if(state != NULL){
+			restore_shell_state(state);
+		}
+	}
+
+	loop_depth++;
+	for(int i = first_round; i < expanded.argc && !shell_interrupted; i++){
+		vars_set(node->name, expanded.argv[i]);
+		status = run_node(node->body);
+		if(loop >= 0 && status == 0 && !shell_interrupted){
+			char **state = shell_state();
+			if(state != NULL){
+				journal_record_round(script_journal, journal_line, loop, \
+						words_hash, i, state);
+				free(state);
+			}
+		}
+	}
+	loop_depth--;
+	vars_release(mark);
+	return status;
+}
+
+/**
+ * run_group() - Runs the list of a group in the shell itself. The stdin and
+ * stdout of the shell are redirected while the list runs, so the children
+ * inherit the redirections, and are put back afterwards.
+ *
+ * @param node The group or subshell node.
+ * @return The exit status of the list or 1 if it could not be redirected.
+ */
+int run_group(ast_node *node){
+	command expanded;
+	char *words[MAXWORDS];
+	char text[VARS_TEXT_MAX];
+	int saved_in = -1;
+	int saved_out = -1;
+	int status = 1;
+
+	size_t mark = vars_mark();
+	if(vars_expand(node->closing, 1, &expanded, words, text) == 0 && \
+			redirect_group(&expanded, &saved_in, &saved_out) == 0){
+		status = run_node(node->body);
+	}
+	restore_group(saved_in, saved_out);
+	vars_release(mark);
+	return status;
+}
+
+/**
+ * run_subshell() - Runs a subshell. Only a list which changes the shell is
+ * run by a forked copy of the shell, which is waited for like a job, any
+ * other list is run like a group.
+ *
+ * @param node The subshell node.
+ * @return The exit status of the list.
+ */
+int run_subshell(ast_node *node){
+	if(!changes_shell_state(node->body)){
+		return run_group(node);
+	}
+
+	//The child must not write out what is buffered in the shell.
+	fflush(stdout);
+	shell_job *job = job_new();
+	job->status = 1; //Until the copy is reaped.
+	pid_t pid = fork();
+	if(pid < 0){
+		perror("fork");
+		exit(1);
+	}
+	else if(pid == 0){ //Child process
+		if(job_control){
+			setpgid(0, 0);
+			reset_child_signals();
+		}
+		setup_subshell();
+		exit(run_group(node));
+	}
+
+	stats_count(STATS_FORKS, 1);
+	job_add_child(job, pid, 0, 1, "(");
+	if(job_control){
+		job->pgid = pid;
+		setpgid(pid, pid);
+		if(tcsetpgrp(STDIN_FILENO, pid) < 0){
+			perror("Job control");
+		}
+	}
+	return wait_for_job(job, NULL);
+}
+
+/**
+ * changes_shell_state() - Checks if a list may change the state of the shell,
+ * with "cd", "tagout", "fg", an assignment or a for loop. A subshell in the
+ * list keeps its changes to itself.
+ *
+ * @param node The first node of the list.
+ * @return 1 if the list may change the shell, else 0.
+ */
+int changes_shell_state(ast_node *node){
+	for(; node != NULL; node = node->next){
+		switch(node->kind){
+		case AST_COMMANDS:
+			if(commands_change_shell_state(node->commands, \
+					node->number_of_commands)){
+				return 1;
+			}
+			break;
+		case AST_FOR:
+			return 1; //The loop sets its variable.
+		case AST_SUBSHELL:
+			break;
+		default:
+			if(changes_shell_state(node->condition) || \
+					changes_shell_state(node->body) || \
+					changes_shell_state(node->otherwise)){
+				return 1;
+			}
+			break;
+		}
+	}
+	return 0;
+}
+
+/**
+ * commands_change_shell_state() - Checks if commands may change the state of
+ * the shell, with "cd", "tagout", "fg" or an assignment.
+ *
+ * @param command_array An array of parsed commands.
+ * @param number_of_commands The number of commands in the array.
+ * @return 1 if the commands may change the shell, else 0.
+ */
+int commands_change_shell_state(command *command_array, \
+		int number_of_commands){
+	for(int i = 0; i < number_of_commands; i++){
+		command *cmd = &command_array[i];
+		if(word_is(cmd->argv[0], "cd") || word_is(cmd->argv[0], "tagout") || \
+				word_is(cmd->argv[0], "fg") || \
+				(cmd->argc == 1 && vars_is_assignment(cmd->argv[0]))){
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * redirect_group() - Redirects the stdin and stdout of the shell for a group.
+ * The fds they had are kept in close-on-exec fds, which the children of the
+ * group do not inherit.
+ *
+ * @param closing The substituted closing command with the redirections.
+ * @param saved_in Set to the kept stdin, or left at -1.
+ * @param saved_out Set to the kept stdout, or left at -1.
+ * @return 0 on success or -1 on failure.
+ */
+int redirect_group(command *closing, int *saved_in, int *saved_out){
+	if(closing->infile != NULL){
+		*saved_in = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, SAVED_FD_MIN);
+		if(*saved_in < 0){
+			perror("Group");
+			return -1;
+		}
+		if(redirect(closing->infile, O_RDONLY, STDIN_FILENO) < 0){
+			return -1;
+		}
+	}
+	if(closing->outfile != NULL){
+		//What the shell has printed belongs to the old stdout.
+		fflush(stdout);
+		*saved_out = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, SAVED_FD_MIN);
+		if(*saved_out < 0){
+			perror("Group");
+			return -1;
+		}
+		if(redirect(closing->outfile, O_WRONLY | O_CREAT, STDOUT_FILENO) < 0){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * restore_group() - Gives the shell back the stdin and stdout it had before
+ * a group.
+ *
+ * @param saved_in The kept stdin or -1.
+ * @param saved_out The kept stdout or -1.
+ */
+void restore_group(int saved_in, int saved_out){
+	if(saved_in >= 0){
+		if(dup2(saved_in, STDIN_FILENO) < 0){
+			perror("Group");
+		}
+		close(saved_in);
+	}
+	if(saved_out >= 0){
+		fflush(stdout);
+		if(dup2(saved_out, STDOUT_FILENO) < 0){
+			perror("Group");
+		}
+		close(saved_out);
+	}
+}
+
+/**
+ * run_command_line() - Splits the parsed command line into and-or lists. A
+ * list followed by "&" is started without waiting for it, the other lists are
+ * run one after another. At the end of the line, the shell waits for all the
+ * children while the output of the jobs is multiplexed if tagged output is on.
+ *
+ * @param command_array An array of parsed commands.
+ * @param number_of_commands The number of commands in the array.
+ * @param exec_last 1 if the last pipeline may be executed in place of the
+ * shell, else 0.
+ * @return The exit status of the last list which was waited for.
+ */
+int run_command_line(command *command_array, int number_of_commands, \
+		int exec_last){
+	int status = 0;
+	mux *output_mux = NULL;
+	if(tagged_output){
+		output_mux = mux_new();
+	}
+	if(output_mux != NULL){
+		struct epoll_event event;
+		event.events = EPOLLIN;
+		event.data.fd = mux_fd(output_mux);
+		if(epoll_ctl(wait_epoll_fd, EPOLL_CTL_ADD, event.data.fd, &event) < 0){
+			perror("epoll_ctl");
+			mux_kill(output_mux);
+			output_mux = NULL;
+		}
+	}
+	//A line run for a command substitution has a multiplexer of its own.
+	mux *outer_mux = line_mux;
+	line_mux = output_mux;
+
+	int start = 0;
+	for(int i = 0; i < number_of_commands; i++){
+		int separator = command_array[i].separator;
+		if(separator == SEP_ASYNC){
+			start_and_or_list(command_array + start, i - start + 1, \
+					output_mux);
+			status = 0;
+		}
+		else if(separator == SEP_SEQ || separator == SEP_END){
+			status = run_and_or_list(command_array + start, i - start + 1, \
+					output_mux, exec_last && i == number_of_commands-1);
+		}
+		else{
+			continue;
+		}
+		start = i + 1;
+	}
+
+	wait_for_children(output_mux);
+	if(output_mux != NULL){
+		epoll_ctl(wait_epoll_fd, EPOLL_CTL_DEL, mux_fd(output_mux), NULL);
+		mux_kill(output_mux);
+	}
+	line_mux = outer_mux;
+	return status;
+}
+
+/**
+ * run_and_or_list() - Runs the pipelines of an and-or list one after another
+ * and waits for each of them. A pipeline after "&&" is only started if the
+ * status is 0 and a pipeline after "||" only if it is not. A skipped pipeline
+ * keeps the status, so "false && a || b" runs b.
+ *
+ * @param command_array An array with the commands of the list.
+ * @param number_of_commands The number of commands in the array.
+ * @param output_mux The multiplexer for the output or NULL.
+ * @param exec_last 1 if the last pipeline may be executed in place of the
+ * shell, else 0.
+ * @return The exit status of the last pipeline which was run.
+ */
+int run_and_or_list(command *command_array, int number_of_commands, \
+		mux *output_mux, int exec_last){
+	int status = 0;
+	int run = 1;
+	int start = 0;
+
+	for(int i = 0; i < number_of_commands; i++){
+		int separator = command_array[i].separator;
+		if(separator == SEP_PIPE || separator == SEP_FANOUT){
+			continue;
+		}
+		if(run){
+			command *pipeline = command_array + start;
+			int length = i - start + 1;
+			pipeline_prefixes prefixes;
+			int in_place = exec_last && i == number_of_commands-1 ? \
+					can_exec_in_place(pipeline, length, &prefixes) : 0;
+			if(in_place != 0){
+				if(in_place > 0){
+					exec_in_place(pipeline, &prefixes);
+				}
+				return 1;
+			}
+			status = wait_for_job(run_pipeline(pipeline, length, output_mux, \
+					1), output_mux);
+			vars_set_status(status);
+		}
+		run = launch_runs_after(separator, status);
+		start = i + 1;
+	}
+	return status;
+}
+
+/**
+ * start_and_or_list() - Starts an and-or list without waiting for it. A
+ * single pipeline is started directly, a list with "&&" or "||" is run by a
+ * subshell since the shell must wait for one pipeline before the next.
+ *
+ * @param command_array An array with the commands of the list.
+ * @param number_of_commands The number of commands in the array.
+ * @param output_mux The multiplexer for the output or NULL.
+ */
+void start_and_or_list(command *command_array, int number_of_commands, \
+		mux *output_mux){
+	if(launch_pipeline_length(command_array, number_of_commands) < \
+			number_of_commands){
+		start_subshell(command_array, number_of_commands, output_mux);
+		return;
+	}
+	run_pipeline(command_array, number_of_commands, output_mux, 0);
+}
+
+/**
+ * start_subshell() - Forks a copy of the shell which runs an and-or list and
+ * exits with its status. The copy is a single child of a new job, so its
+ * output is captured like the output of a pipeline. With job control the
+ * subshell and its children are one process group.
+ *
+ * @param command_array An array with the commands of the list.
+ * @param number_of_commands The number of commands in the array.
+ * @param output_mux The multiplexer for the output or NULL.
+ */
+void start_subshell(command *command_array, int number_of_commands, \
+		mux *output_mux){
+	int out_pipe[2];
+	int err_pipe[2];
+	if(output_mux != NULL && open_capture(out_pipe, err_pipe) < 0){
+		return;
+	}
+
+	//The child must not write out what is buffered in the shell.
+	fflush(stdout);
+	shell_job *job = job_new();
+	pid_t pid = fork();
+	if(pid < 0){
+		perror("fork");
+		exit(1);
+	}
+	else if(pid == 0){ //Child process
+		if(output_mux != NULL){
+			if(dup2(out_pipe[WRITE_END], STDOUT_FILENO) < 0 || \
+					dup2(err_pipe[WRITE_END], STDERR_FILENO) < 0){
+				perror("Capturing output");
+			}
+			close(out_pipe[READ_END]);
+			close(out_pipe[WRITE_END]);
+			close(err_pipe[READ_END]);
+			close(err_pipe[WRITE_END]);
+		}
+		if(job_control){
+			setpgid(0, 0);
+			reset_child_signals();
+		}
+		setup_subshell();
+		exit(run_and_or_list(command_array, number_of_commands, NULL, 0));
+	}
+
+	stats_count(STATS_FORKS, 1);
+	job_add_child(job, pid, 0, 1, command_array[0].argv[0]);
+	if(job_control){
+		job->pgid = pid;
+		setpgid(pid, pid);
+	}
+	if(output_mux != NULL){
+		hand_over_capture(output_mux, out_pipe, err_pipe, job->id);
+	}
+}
+
+/**
+ * setup_subshell() - Makes a forked copy of the shell independent of the
+ * shell. The jobs of the shell are forgotten and the subshell gets its own
+ * signal pipe and wait loop, so it only wakes up for its own children. The
+ * subshell has no job control, its children stay in its process group.
+ */
+void setup_subshell(void){
+	jobs_forget();
+	tagged_output = 0;
+	job_control = 0;
+	line_mux = NULL;
+	active_capture = NULL;
+	open_block = NULL; //The block being run belongs to the shell.
+	script_journal = NULL;
+
+	close(shell_signal_pipe[READ_END]);
+	close(shell_signal_pipe[WRITE_END]);
+	close(wait_epoll_fd);
+	setup_signal_handling();
+	setup_wait_loop();
+}
+
+/**
+ * run_pipeline() - Runs one pipeline. If it consists of internal commands they
+ * are run by the shell, else the commands are forked and executed. When a
+ * multiplexer is given, the stdout and stderr of the pipeline are captured
+ * through pipes which are handed to it. The first command may start with
+ * prefixes, see parse_prefixes(). The variables and commands are substituted
+ * in a copy of the commands, so the same commands can be run again. A lone
+ * "name=value" without quotes before the "=" sets a variable.
+ *
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @param output_mux The multiplexer for the output or NULL.
+ * @param foreground 1 if the shell waits for the pipeline, so it should get
+ * the terminal, else 0.
+ * @return The job of the pipeline. It is already done if the pipeline was run
+ * by the shell or could not be started.
+ */
+shell_job *run_pipeline(command *command_array, int number_of_commands, \
+		mux *output_mux, int foreground){
+	command expanded[number_of_commands];
+	char *words[MAXWORDS];
+	char text[VARS_TEXT_MAX];
+	shell_job *job;
+
+	//The substituted words may point into the outputs of substitutions.
+	size_t mark = vars_mark();
+	if(vars_expand(command_array, number_of_commands, expanded, words, \
+			text) < 0){
+		job = finished_job(1);
+	}
+	else if(number_of_commands == 1 && command_array[0].argc == 1 && \
+			vars_is_assignment(command_array[0].argv[0])){
+		vars_assign(expanded[0].argv[0]);
+		job = finished_job(0);
+	}
+	else{
+		job = start_pipeline(expanded, number_of_commands, output_mux, \
+				foreground);
+	}
+	vars_release(mark);
+	return job;
+}
+
+/**
+ * start_pipeline() - Starts a pipeline whose words are substituted.
+ *
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @param output_mux The multiplexer for the output or NULL.
+ * @param foreground 1 if the shell waits for the pipeline, else 0.
+ * @return The job of the pipeline, see run_pipeline().
+ */
+shell_job *start_pipeline(command *command_array, int number_of_commands, \
+		mux *output_mux, int foreground){
+	for(int i = 0; i < number_of_commands; i++){
+		if(command_array[i].argc == 0){ //Every word was an empty variable.
+			if(number_of_commands == 1){
+				return finished_job(0);
+			}
+			fprintf(stderr, "Invalid null command.\n");
+			return finished_job(1);
+		}
+	}
+	launch_options options = {-1, -1, -1, NULL, NULL, foreground, 0, 1, NULL, \
+			0};
+	pipeline_prefixes prefixes;
+	if(parse_prefixes(&command_array[0], &prefixes) < 0){
+		return finished_job(1);
+	}
+	if(prefixes.pinned){
+		placement_spread(&prefixes.pin);
+		options.placement = &prefixes.pin;
+	}
+
+	int internal = check_for_internal_commands(command_array, \
+			number_of_commands);
+	if(internal < 0){
+		return finished_job(1);
+	}
+	else if(internal > 0){
+		//printf("Run internal commands!\n");
+		if(prefixes.pinned || prefixes.timed || prefixes.benched || \
+				prefixes.cached || prefixes.watched || prefixes.profiled){
+			fprintf(stderr, "Prefixes are not used for internal commands\n");
+		}
+		int status;
+		if(is_thread_pipeline(command_array, number_of_commands)){
+			status = run_thread_pipeline(command_array, number_of_commands);
+		}
+		else{
+			status = run_internal_commands(command_array, number_of_commands);
+		}
+		//Children forked later must not inherit buffered output.
+		fflush(stdout);
+		return finished_job(status);
+	}
+
+	//printf("Starting external command commands!\n");
+	if(prefixes.benched + prefixes.cached + prefixes.watched + \
+			prefixes.profiled > 1){
+		fprintf(stderr, "bench, cache, watch and pipeprof can not be used "
+				"together\n");
+		return finished_job(1);
+	}
+	else if(prefixes.benched){
+		return finished_job(run_bench(command_array, number_of_commands, \
+				&options, &prefixes, output_mux));
+	}
+	else if(prefixes.cached){
+		return finished_job(run_cached(command_array, number_of_commands, \
+				&options, &prefixes, output_mux));
+	}
+	else if(prefixes.watched){
+		return finished_job(run_watch(command_array, number_of_commands, \
+				&options, &prefixes, output_mux));
+	}
+	else if(prefixes.profiled){
+		return finished_job(run_profile(command_array, number_of_commands, \
+				&options, &prefixes, output_mux));
+	}
+	return launch_job(command_array, number_of_commands, &options, \
+			&prefixes, output_mux);
+}
+
+/**
+ * launch_job() - Forks the commands of a pipeline as a new job, with the
+ * output captured if there is a multiplexer, and starts its timeout.
+ *
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @param options How the pipeline is connected, the job is set in them.
+ * @param prefixes The prefixes of the pipeline.
+ * @param output_mux The multiplexer for the output or NULL.
+ * @return The job of the pipeline.
+ */
+shell_job *launch_job(command *command_array, int number_of_commands, \
+		launch_options *options, const pipeline_prefixes *prefixes, \
+		mux *output_mux){
+	int out_pipe[2];
+	int err_pipe[2];
+	if(output_mux != NULL){
+		if(open_capture(out_pipe, err_pipe) < 0){
+			return finished_job(1);
+		}
+		options->stdout_fd = out_pipe[WRITE_END];
+		options->stderr_fd = err_pipe[WRITE_END];
+	}
+
+	shell_job *job = job_new();
+	job->status = 1; //Until the last command is reaped.
+	options->job = job;
+	//The timeout kills the whole group, also what the commands have forked.
+	//It is armed first, a stage may block before its exec, like "cat < fifo".
+	if(prefixes->timed){
+		options->own_group = 1;
+		timeout_start(&prefixes->deadline, job->id, wait_epoll_fd);
+	}
+	pipe_and_fork_commands(command_array, number_of_commands, options);
+
+	if(output_mux != NULL){
+		hand_over_capture(output_mux, out_pipe, err_pipe, job->id);
+	}
+	return job;
+}
+
+/**
+ * run_bench() - Runs a pipeline with the bench prefix the given number of
+ * times, one run after another, and reports the measured runs. A run is
+ * timed from before it is forked until its last child is reaped.
+ *
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @param options How the pipeline is connected.
+ * @param prefixes The prefixes of the pipeline.
+ * @param output_mux The multiplexer for the output or NULL.
+ * @return The exit status of the last run.
+ */
+int run_bench(command *command_array, int number_of_commands, \
+		launch_options *options, const pipeline_prefixes *prefixes, \
+		mux *output_mux){
+	const bench_spec *spec = &prefixes->bench;
+	bench_sample *samples = malloc(spec->runs * sizeof(*samples));
+	if(samples == NULL){
+		perror("mish.c");
+		exit(errno);
+	}
+
+	int measured = 0;
+	int status = 0;
+	for(int i = 0; i < spec->warmup + spec->runs; i++){
+		uint64_t started = stats_now();
+		shell_job *job = launch_job(command_array, number_of_commands, \
+				options, prefixes, output_mux);
+		wait_loop(job, output_mux);
+
+		//Read before wait_for_job() removes the job.
+		bench_sample sample = {stats_now() - started, job->usage, 0};
+		int stopped = job_is_stopped(job);
+		status = wait_for_job(job, output_mux);
+		if(stopped || shell_interrupted){
+			break;
+		}
+		sample.status = status;
+		if(i >= spec->warmup){
+			samples[measured++] = sample;
+		}
+	}
+
+	if(measured > 0 && bench_report(spec, samples, measured, \
+			command_array[0].argv[0]) < 0){
+		status = 1;
+	}
+	free(samples);
+	return status;
+}
+
+/**
+ * run_watch() - Runs a pipeline with the watch prefix, and again every time
+ * a change of the watched paths is due. A run which is still going when a
+ * change is due gets SIGTERM and is waited for before the next run. Every run
+ * is a process group of its own, so the SIGTERM also reaches what its
+ * commands have forked.
+ *
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @param options How the pipeline is connected.
+ * @param prefixes The prefixes of the pipeline.
+ * @param output_mux The multiplexer for the output or NULL.
+ * @return The exit status of the last run.
+ */
+int run_watch(command *command_array, int number_of_commands, \
+		launch_options *options, const pipeline_prefixes *prefixes, \
+		mux *output_mux){
+	watcher *w = watch_start(&prefixes->watch, wait_epoll_fd);
+	if(w == NULL){
+		return 1;
+	}
+	active_watch = w;
+	options->own_group = 1;
+
+	int status = 0;
+	while(1){
+		watch_clear(w);
+		shell_job *job = launch_job(command_array, number_of_commands, \
+				options, prefixes, output_mux);
+		watched_job = job;
+		wait_loop(job, output_mux);
+		watched_job = NULL;
+		if(!job_is_done(job) && !job_is_stopped(job)){
+			fprintf(stderr, "watch: changed, restarting %s\n", job->name);
+			job_signal(job, SIGTERM);
+		}
+
+		int stopped = job_is_stopped(job);
+		status = wait_for_job(job, output_mux);
+		if(stopped || shell_interrupted){
+			break;
+		}
+		//Waits for the next change, the shell has the terminal meanwhile.
+		wait_loop(NULL, output_mux);
+		if(shell_interrupted){
+			break;
+		}
+	}
+
+	active_watch = NULL;
+	watch_stop(w);
+	return status;
+}
+
+/**
+ * run_profile() - Runs a pipeline with the pipeprof prefix while its pipes
+ * and stages are sampled by the wait loop, and reports its bottleneck when it
+ * has ended or stopped.
+ *
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @param options How the pipeline is connected.
+ * @param prefixes The prefixes of the pipeline.
+ * @param output_mux The multiplexer for the output or NULL.
+ * @return The exit status of the pipeline.
+ */
+int run_profile(command *command_array, int number_of_commands, \
+		launch_options *options, const pipeline_prefixes *prefixes, \
+		mux *output_mux){
+	for(int i = 0; i < number_of_commands-1; i++){
+		if(command_array[i].separator == SEP_FANOUT){
+			fprintf(stderr, "pipeprof: a pipeline with |+ can not be "
+					"profiled\n");
+			return 1;
+		}
+	}
+	profiler *p = pipeprof_start(&prefixes->profile, number_of_commands, \
+			wait_epoll_fd);
+	if(p == NULL){
+		return 1;
+	}
+	active_profile = p;
+	options->profile = p;
+
+	shell_job *job = launch_job(command_array, number_of_commands, options, \
+			prefixes, output_mux);
+	wait_loop(job, output_mux);
+	pipeprof_report(p);
+	int status = wait_for_job(job, output_mux);
+
+	options->profile = NULL;
+	active_profile = NULL;
+	pipeprof_stop(p);
+	return status;
+}
+
+/**
+ * run_substitution() - Runs the line of a command substitution in a forked
+ * copy of the shell and returns what it wrote to stdout. The output is read
+ * into one buffer by the wait loop while the shell waits for the copy.
+ *
+ * @param line The command line.
+ * @param len Set to the length of the output.
+ * @return The output without trailing newlines, which the caller frees, or
+ * NULL on failure.
+ */
+char *run_substitution(const char *line, size_t *len){
+	substitution_capture capture = {-1, NULL, 0, 0};
+	int capture_pipe[2];
+	if(pipe2(capture_pipe, O_CLOEXEC) < 0){
+		perror("Pipe");
+		return NULL;
+	}
+
+	//The child must not write out what is buffered in the shell.
+	fflush(stdout);
+	shell_job *job = job_new();
+	job->status = 1; //Until the copy is reaped.
+	pid_t pid = fork();
+	if(pid < 0){
+		perror("fork");
+		exit(1);
+	}
+	else if(pid == 0){ //Child process
+		if(dup2(capture_pipe[WRITE_END], STDOUT_FILENO) < 0){
+			perror("Command substitution");
+			exit(1);
+		}
+		close(capture_pipe[READ_END]);
+		close(capture_pipe[WRITE_END]);
+		setup_subshell();
+
+		//The line may be read only, the copy ends with the child.
+		char *copy = strdup(line);
+		if(copy == NULL){
+			perror("mish.c");
+			exit(errno);
+		}
+		command command_array[MAXCOMMANDS];
+		int status = run_parsed_line(command_array, \
+				timed_parse(copy, command_array));
+		close_open_block("command substitution");
+		exit(status);
+	}
+
+	stats_count(STATS_FORKS, 1);
+	job_add_child(job, pid, 0, 1, "$(...)");
+	close(capture_pipe[WRITE_END]);
+	capture.fd = capture_pipe[READ_END];
+
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = capture.fd;
+	int flags = fcntl(capture.fd, F_GETFL);
+	if(flags < 0 || fcntl(capture.fd, F_SETFL, flags | O_NONBLOCK) < 0 || \
+			epoll_ctl(wait_epoll_fd, EPOLL_CTL_ADD, capture.fd, &event) < 0){
+		perror("Command substitution");
+		close(capture.fd);
+		capture.fd = -1;
+	}
+
+	substitution_capture *outer_capture = active_capture;
+	if(capture.fd >= 0){
+		active_capture = &capture;
+	}
+	//Like in other shells, $? is the status of the substitution.
+	vars_set_status(wait_for_job(job, line_mux));
+	active_capture = outer_capture;
+
+	//Read what the children of the copy may still write.
+	if(capture.fd >= 0){
+		epoll_ctl(wait_epoll_fd, EPOLL_CTL_DEL, capture.fd, NULL);
+		fcntl(capture.fd, F_SETFL, flags);
+		while(read_capture(&capture) > 0);
+		close(capture.fd);
+	}
+
+	if(capture.data == NULL){
+		capture.data = malloc(1);
+		if(capture.data == NULL){
+			perror("mish.c");
+			exit(errno);
+		}
+	}
+	while(capture.used > 0 && capture.data[capture.used-1] == '\n'){
+		capture.used--;
+	}
+	capture.data[capture.used] = '\0';
+	*len = capture.used;
+	return capture.data;
+}
+
+/**
+ * read_capture() - Reads the output of a command substitution into its
+ * buffer. The buffer is doubled when it has less free room than one large
+ * read.
+ *
+ * @param capture The substitution.
+ * @return 1 if something was read, 0 at end of file or -1 if nothing could
+ * be read now.
+ */
+int read_capture(substitution_capture *capture){
+	if(capture->size - capture->used < CAPTURE_READ_MIN + 1){
+		size_t size = capture->size > 0 ? capture->size * 2 : \
+				2 * CAPTURE_READ_MIN;
+		char *grown = realloc(capture->data, size);
+		if(grown == NULL){
+			perror("mish.c");
+			exit(errno);
+		}
+		capture->data = grown;
+		capture->size = size;
+	}
+
+	//One byte is kept for the end of the string.
+	ssize_t n;
+	do{
+		n = read(capture->fd, capture->data + capture->used, \
+				capture->size - capture->used - 1);
+	}while(n < 0 && errno == EINTR);
+	if(n < 0){
+		if(errno != EAGAIN && errno != EWOULDBLOCK){
+			perror("Command substitution");
+		}
+		return -1;
+	}
+	capture->used += n;
+	return n > 0 ? 1 : 0;
+}
+
+/**
+ * run_cached() - Runs a pipeline with the cache prefix. Its output is
+ * replayed if it is stored, else it is run and its output is stored. A
+ * pipeline which can not be cached is run as usual.
+ *
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @param options How the pipeline is connected.
+ * @param prefixes The prefixes of the pipeline.
+ * @param output_mux The multiplexer for the output or NULL.
+ * @return The exit status of the pipeline.
+ */
+int run_cached(command *command_array, int number_of_commands, \
+		launch_options *options, const pipeline_prefixes *prefixes, \
+		mux *output_mux){
+	outcache_entry entry;
+	int status;
+
+	//Children forked later must not inherit buffered output.
+	fflush(stdout);
+	if(output_mux != NULL || outcache_open(&entry, &prefixes->cache, \
+			command_array, number_of_commands) < 0){
+		return wait_for_job(launch_job(command_array, number_of_commands, \
+				options, prefixes, output_mux), output_mux);
+	}
+	if(outcache_replay(&entry, &status) == 0){
+		return status;
+	}
+	if(outcache_begin(&entry) < 0){
+		return wait_for_job(launch_job(command_array, number_of_commands, \
+				options, prefixes, output_mux), output_mux);
+	}
+
+	options->stdin_fd = entry.in_fd;
+	options->stdout_fd = entry.out_fd;
+	options->stderr_fd = entry.err_fd;
+	shell_job *job = launch_job(command_array, number_of_commands, options, \
+			prefixes, output_mux);
+	wait_loop(job, output_mux);
+	int stopped = job_is_stopped(job);
+	status = wait_for_job(job, output_mux);
+
+	//Only a run which ended by itself is stored.
+	outcache_finish(&entry, status, !stopped && !shell_interrupted && \
+			status < 128);
+	return status;
+}
+
+/**
+ * finished_job() - Creates a job without children for a pipeline which was
+ * run by the shell itself or could not be started.
+ *
+ * @param status The exit status of the pipeline.
+ * @return The job, which is already done.
+ */
+shell_job *finished_job(int status){
+	shell_job *job = job_new();
+	job->status = status;
+	return job;
+}
+
+/**
+ * open_capture() - Creates the pipes which capture the stdout and stderr of
+ * a job for the multiplexer.
+ *
+ * @param out_pipe The pipe for stdout.
+ * @param err_pipe The pipe for stderr.
+ * @return 0 on success or -1 on failure.
+ */
+int open_capture(int out_pipe[2], int err_pipe[2]){
+	if(pipe2(out_pipe, O_CLOEXEC) < 0){
+		perror("Pipe");
+		return -1;
+	}
+	if(pipe2(err_pipe, O_CLOEXEC) < 0){
+		perror("Pipe");
+		close(out_pipe[READ_END]);
+		close(out_pipe[WRITE_END]);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * hand_over_capture() - Closes the write ends of the capturing pipes after
+ * the job is forked and hands the read ends to the multiplexer.
+ *
+ * @param output_mux The multiplexer.
+ * @param out_pipe The pipe for stdout.
+ * @param err_pipe The pipe for stderr.
+ * @param job_id The id which the output is tagged with.
+ */
+void hand_over_capture(mux *output_mux, int out_pipe[2], int err_pipe[2], \
+		int job_id){
+	//Only the children should hold the write ends.
+	close(out_pipe[WRITE_END]);
+	close(err_pipe[WRITE_END]);
+	if(mux_add(output_mux, out_pipe[READ_END], job_id, STDOUT_FILENO) < 0){
+		close(out_pipe[READ_END]);
+	}
+	if(mux_add(output_mux, err_pipe[READ_END], job_id, STDERR_FILENO) < 0){
+		close(err_pipe[READ_END]);
+	}
+}
+
+/**
+ * wait_for_job() - Makes the mish process wait until all children of a job
+ * are reaped or stopped. A done job is removed, a stopped job is reported and
+ * kept. With job control the shell takes the terminal back afterwards.
+ *
+ * @param job The job to wait for.
+ * @param output_mux The multiplexer of the captured output or NULL.
+ * @return The exit status of the job.
+ */
+int wait_for_job(shell_job *job, mux *output_mux){
+	wait_loop(job, output_mux);
+	if(job_control && job->pgid > 0 && \
+			tcsetpgrp(STDIN_FILENO, shell_pgid) < 0){
+		perror("Job control");
+	}
+
+	int status = job->status;
+	if(job_is_stopped(job)){
+		fprintf(stderr, "\n[%d] Stopped\t%s\n", job->id, job->name);
+		return status;
+	}
+	//The terminal interrupted only the job, the shell passes it on.
+	if(status == 128 + SIGINT){
+		shell_interrupted = 1;
+		shell_interrupt_pending = 1;
+	}
+	job_remove(job);
+	return status;
+}
+
+/**
+ * wait_for_children() - Makes the mish process wait until the children finish
+ * their command which should be executed and all captured output is written.
+ *
+ * @param output_mux The multiplexer of the captured output or NULL.
  */
-int main(void) {
-
-	current_shell_children = list_new();
+void wait_for_children(mux *output_mux){
+	wait_loop(NULL, output_mux);
+	//All children are gone, give their entries back in one go.
+	jobs_reset();
+}
 
-	setup_signal_handling();
+/**
+ * wait_loop() - Waits for a job, or for all children and the captured output
+ * if no job is given. Stopped children are not waited for. While waiting, an
+ * interrupt of the shell is passed on to the jobs, expired timeouts are
+ * handled and the captured output is multiplexed.
+ *
+ * While a watch prefix runs, the wait for its job also ends when a change is
+ * due, and without a job the wait is for the next change or an interrupt.
+ *
+ * @param job The job to wait for or NULL.
+ * @param output_mux The multiplexer of the captured output or NULL.
+ */
+void wait_loop(shell_job *job, mux *output_mux){
+    struct epoll_event events[WAIT_EVENTS];
 
-	main_shell_loop();
+    while(1){
+        if(shell_interrupt_pending){
+        	shell_interrupt_pending = 0;
+        	jobs_signal(SIGINT);
+        }
+        reap_children();
+        timeout_finish_jobs();
+        if(job != NULL){
+        	if(job_is_done(job) || job_is_stopped(job) || \
+        			(job == watched_job && watch_is_due(active_watch))){
+        		break;
+        	}
+        }
+        else if(active_watch != NULL){
+        	if(watch_is_due(active_watch) || shell_interrupted){
+        		break;
+        	}
+        }
+        //The output of stopped jobs is not waited for.
+        else if(!jobs_have_running_children() && (output_mux == NULL || \
+        		mux_is_done(output_mux) || \
+        		!ilist_is_empty(&current_shell_children))){
+        	break;
+        }
 
-    list_kill(current_shell_children); // should be empty
-    return 0;
+        int ready = epoll_wait(wait_epoll_fd, events, WAIT_EVENTS, -1);
+        if(ready < 0){
+        	if(errno != EINTR){
+        		perror("Wait");
+        	}
+        	continue;
+        }
+        for(int i = 0; i < ready; i++){
+        	int fd = events[i].data.fd;
+        	if(fd == shell_signal_pipe[READ_END]){
+        		char drain[64];
+        		while(read(fd, drain, sizeof(drain)) > 0);
+        	}
+        	else if(line_mux != NULL && fd == mux_fd(line_mux)){
+        		mux_dispatch(line_mux);
+        	}
+        	else if(active_capture != NULL && fd == active_capture->fd){
+        		int read_status;
+        		while((read_status = read_capture(active_capture)) > 0);
+        		if(read_status == 0){ //Do not wake up for the end again.
+        			epoll_ctl(wait_epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        		}
+        	}
+        	else if((active_watch == NULL || !watch_handle(active_watch, fd)) \
+        			&& (active_profile == NULL || \
+        			!pipeprof_handle(active_profile, fd))){
+        		timeout_handle(fd);
+        	}
+        }
+    }
 }
 
 /**
- * main_shell_loop() - The main loop for the shell. This function handles the
- * given commands given to stdin. A parse is done on the input and check for
- * internal commands. If an internal command is found, the command(s) will be
- * sent to an internal command handler, else the command(s) will be forked and
- * executed.
+ * reap_children() - Collects all children which have exited, stopped or
+ * continued without blocking. Exited children are removed from the list of
+ * current children and the exit status of the last command of a pipeline and
+ * the resource usage of the children are kept in its job.
  */
-void main_shell_loop(void){
-	char input_line[MAXLINELEN+1];
-	command command_array[MAXCOMMANDS];
+void reap_children(void){
+    int status = 0;
+    struct rusage usage;
+    pid_t complete_child;
+    while(!ilist_is_empty(&current_shell_children)){
+        complete_child = wait4(-1, &status, \
+        		WNOHANG | WUNTRACED | WCONTINUED, &usage);
+        if(complete_child == 0){
+        	break;
+        }
+        else if(complete_child < 0){
+        	if(errno == EINTR){
+        		continue;
+        	}
+        	perror("Wait");
+        	if(errno == ECHILD){ //The list is out of date, fail the children.
+        		while(!ilist_is_empty(&current_shell_children)){
+        			shell_child *child = ilist_entry( \
+        					ilist_first(&current_shell_children), \
+        					shell_child, link);
+        			job_child_changed(child->pid, W_EXITCODE(1, 0), NULL);
+        		}
+        	}
+        	break;
+        }
+        if(active_profile != NULL && \
+        		(WIFEXITED(status) || WIFSIGNALED(status))){
+        	pipeprof_reaped(active_profile, complete_child, &usage);
+        }
+        job_child_changed(complete_child, status, \
+        		WIFEXITED(status) || WIFSIGNALED(status) ? &usage : NULL);
+    }
+}
 
-	while(1){ //Main terminal loop, only quit due to signal.
-		PRINT_PROMPT;
+/**
+ * parse_prefixes() - Parses and removes the prefixes at the start of the first
+ * command of a pipeline. "pin" gives the placement of the forked commands,
+ * "timeout" gives the pipeline a deadline, "bench" runs it several times,
+ * "cache" replays its output, "watch" runs it again when files change and
+ * "pipeprof" samples it to find its bottleneck.
+ *
+ * @param cmd The first command of the pipeline.
+ * @param prefixes The prefixes which were found.
+ * @return 0 on success or -1 on a bad prefix.
+ */
+int parse_prefixes(command *cmd, pipeline_prefixes *prefixes){
+	prefixes->pinned = 0;
+	prefixes->timed = 0;
+	prefixes->benched = 0;
+	prefixes->cached = 0;
+	prefixes->watched = 0;
+	prefixes->profiled = 0;
 
-		if(fgets(input_line, MAXLINELEN, stdin) == NULL){
-			if( feof(stdin) ) {
-				break;
-			}
-			else if(errno != 0){
-				perror("Reading input");
-				continue;
-			}
-			else{
-				break;
-			}
+	while(1){
+		int words;
+		if(strcmp(cmd->argv[0], "pin") == 0){
+			words = placement_parse(&prefixes->pin, cmd->argc, cmd->argv);
+			prefixes->pinned = 1;
 		}
-		int number_of_commands = parse(input_line,command_array);
-
-		if(check_for_internal_commands(command_array, number_of_commands) \
-				> 0){
-			//printf("Run internal commands!\n");
-			run_internal_commands(command_array, number_of_commands);
+		else if(strcmp(cmd->argv[0], "timeout") == 0){
+			words = timeout_parse(&prefixes->deadline, cmd->argc, cmd->argv);
+			prefixes->timed = 1;
 		}
-		else{ //External commands
-			//printf("Starting external command commands!\n");
-			pipe_and_fork_commands(command_array, number_of_commands);
-
-			wait_for_children();
+		else if(strcmp(cmd->argv[0], "bench") == 0){
+			words = bench_parse(&prefixes->bench, cmd->argc, cmd->argv);
+			prefixes->benched = 1;
+		}
+		else if(strcmp(cmd->argv[0], "cache") == 0){
+			words = outcache_parse(&prefixes->cache, cmd->argc, cmd->argv);
+			prefixes->cached = 1;
+		}
+		else if(strcmp(cmd->argv[0], "watch") == 0){
+			words = watch_parse(&prefixes->watch, cmd->argc, cmd->argv);
+			prefixes->watched = 1;
+		}
+		else if(strcmp(cmd->argv[0], "pipeprof") == 0){
+			words = pipeprof_parse(&prefixes->profile, cmd->argc, cmd->argv);
+			prefixes->profiled = 1;
+		}
+		else{
+			return 0;
+		}
+		if(words < 0 || strip_prefix(cmd, words) < 0){
+			return -1;
 		}
 	}
 }
 
 /**
- * wait_for_children() - Makes the mish process wait until the children finish
- * their command which should be executed.
+ * strip_prefix() - Removes the words of a prefix like "pin -r" from the
+ * start of a command.
+ *
+ * @param cmd The command starting with the prefix.
+ * @param words The number of words in the prefix.
+ * @return 0 on success or -1 if no command is left.
  */
-void wait_for_children(void){
-    int num_of_completed_children = 0;
-    int status = 0;
-    pid_t complete_child;
-    while(!list_is_empty(current_shell_children)){
-        if((complete_child = wait(&status)) < 0){
-        	if(errno != EINTR){
-        		perror("Wait");
-        	}
-        }
-        remove_child_from_list_of_current_children(complete_child);
-        num_of_completed_children++;
-    }
+int strip_prefix(command *cmd, int words){
+	if(words >= cmd->argc){
+		fprintf(stderr, "%s: missing command\n", cmd->argv[0]);
+		return -1;
+	}
+	cmd->argv += words;
+	cmd->argc -= words;
+	return 0;
 }
 
 /**
- * remove_child_from_list_of_current_children() - Steps through the dynamic list
- * of the current shell's children and remove the given child's pid.
+ * is_internal_command() - Checks if the given command name is one of the
+ * internal commands of the shell.
  *
- * @param The child's pid to remove from the list.
+ * @param name The name of the command.
+ * @return 1 if the command is internal, else 0.
  */
-void remove_child_from_list_of_current_children(pid_t complete_child){
-	list_pos first_pos = list_get_first_position(current_shell_children);
-	list_pos current_pos = \
-	list_get_previous_position(list_get_last_position(current_shell_children), \
-								current_shell_children);
+int is_internal_command(const char *name){
+	for(int i = 0; internal_command_names[i] != NULL; i++){
+		if(strcmp(name, internal_command_names[i]) == 0){
+			return 1;
+		}
+	}
+	return 0;
+}
 
-	while(current_pos != first_pos){
-		pid_t *pid_in_list = (pid_t*)list_get_value(current_pos);
-		if(complete_child == *pid_in_list){
-			list_remove_element(current_pos, current_shell_children);
-			free(pid_in_list);
-			break;
+/**
+ * is_stage_command() - Checks if the given command name is one of the stage
+ * commands, which the forked child runs instead of an external command.
+ *
+ * @param name The name of the command.
+ * @return 1 if the command is a stage command, else 0.
+ */
+int is_stage_command(const char *name){
+	for(int i = 0; stage_command_names[i] != NULL; i++){
+		if(strcmp(name, stage_command_names[i]) == 0){
+			return 1;
 		}
-		current_pos = list_get_previous_position(current_pos, \
-													current_shell_children);
 	}
+	return 0;
+}
 
+/**
+ * run_stage_command() - Runs a stage command in the forked child after the
+ * launch core has redirected its input and output.
+ *
+ * @param cmd The stage command.
+ * @return The exit status of the stage.
+ */
+int run_stage_command(command cmd){
+	reset_shell_handlers();
+	if(strcmp(cmd.argv[0], "buffer") == 0){
+		return buffer_main(cmd.argc, cmd.argv);
+	}
+	else if(strcmp(cmd.argv[0], "batch") == 0){
+		return batch_main(cmd.argc, cmd.argv);
+	}
+	fprintf(stderr, "Got an unexpected stage command!\n");
+	return 1;
 }
 
 /**
  * check_for_internal_commands() - Counts the number of internal commands in the
  * given array of command structures. If an internal and external commands are
- * found in the array, the function will give an error. Assumes only "cd" and
- * "echo" are internal commands.
+ * found in the array, the function will give an error.
  *
  * @param command_array A pointer to an array of commands.
  * @param number_of_commands The number of commands in the array.
@@ -174,8 +2230,7 @@ void remove_child_from_list_of_current_children(pid_t complete_child){
 int check_for_internal_commands(command *command_array, int number_of_commands){
     int internal_commands = 0;
     for(int i = 0; i < number_of_commands; i++){
-        if((strcmp(command_array[i].argv[0], "cd") == 0) ||
-            (strcmp(command_array[i].argv[0], "echo") == 0)){
+        if(is_internal_command(command_array[i].argv[0])){
             internal_commands++;
         }
         else if(internal_commands > 0){
@@ -188,24 +2243,174 @@ int check_for_internal_commands(command *command_array, int number_of_commands){
 
 /**
  * run_internal_commands() - Calls on the appropriate execution-function
- * depending on whether the given function is cd or echo. This function amuses
- * only "cd" and "echo" are internal commands.
+ * depending on which internal command is given.
  *
  * @param command_array A pointer to an array of internal commands.
  * @param number_of_commands The number of commands in the array.
+ * @return The exit status of the last command.
  */
-void run_internal_commands(command *command_array, int number_of_commands){
+int run_internal_commands(command *command_array, int number_of_commands){
+    int status = 0;
     for(int i = 0; i < number_of_commands; i++){
         if(strcmp(command_array[i].argv[0], "cd") == 0){
-            internal_cd(command_array[i].argv[1]);
+            status = internal_cd(command_array[i].argv[1]);
         }
         else if(strcmp(command_array[i].argv[0], "echo") == 0){
-            internal_echo(command_array[i].argv, command_array[i].argc);
+            status = internal_echo(command_array[i].argv, \
+            		command_array[i].argc, stdout);
+        }
+        else if(strcmp(command_array[i].argv[0], "tagout") == 0){
+            status = internal_tagout(command_array[i].argv[1]);
+        }
+        else if(strcmp(command_array[i].argv[0], "fg") == 0){
+            status = internal_fg(command_array[i].argv[1]);
+        }
+        else if(strcmp(command_array[i].argv[0], "jobs") == 0){
+            status = internal_jobs(stdout);
+        }
+        else if(strcmp(command_array[i].argv[0], "stats") == 0){
+            status = stats_main(command_array[i].argc, command_array[i].argv, \
+            		stdout);
+        }
+        else if(strcmp(command_array[i].argv[0], "pass") == 0){
+            status = internal_pass(stdin, stdout);
         }
         else {
         	fprintf(stderr, "Got an unexpected internal command!");
+        	status = 1;
         }
     }
+    return status;
+}
+
+/**
+ * is_thread_pipeline() - Checks if a pipeline of internal commands can be run
+ * by run_thread_pipeline(), which it can when it has more than one command and
+ * all of them print or copy their input.
+ *
+ * @param command_array A pointer to an array of internal commands.
+ * @param number_of_commands The number of commands in the array.
+ * @return 1 if the pipeline can run as threads, else 0.
+ */
+int is_thread_pipeline(command *command_array, int number_of_commands){
+	if(number_of_commands < 2){
+		return 0;
+	}
+	for(int i = 0; i < number_of_commands; i++){
+		int found = 0;
+		for(int j = 0; thread_command_names[j] != NULL; j++){
+			if(strcmp(command_array[i].argv[0], thread_command_names[j]) == 0){
+				found = 1;
+			}
+		}
+		if(!found){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * run_thread_pipeline() - Runs a pipeline of internal commands as threads of
+ * the shell, connected by thread pipes instead of pipes, and waits for them.
+ * Like a forked stage, a thread closes the ends of its pipes when it is done,
+ * so the next stage gets end of file. A thread pipe blocks the writer while
+ * it is full, so a stage is never more than the ring ahead of the next.
+ *
+ * @param command_array A pointer to an array of internal commands.
+ * @param number_of_commands The number of commands in the array.
+ * @return The exit status of the last command.
+ */
+int run_thread_pipeline(command *command_array, int number_of_commands){
+	thread_pipe pipes[number_of_commands - 1];
+	thread_stage stages[number_of_commands];
+
+	//Output written to stdout before must come before the output of a stage.
+	fflush(stdout);
+	for(int i = 0; i < number_of_commands - 1; i++){
+		if(thread_pipe_init(&pipes[i]) < 0){
+			perror("mish.c");
+			exit(errno);
+		}
+	}
+	for(int i = 0; i < number_of_commands; i++){
+		stages[i].cmd = &command_array[i];
+		stages[i].in = NULL;
+		stages[i].out = stdout;
+		if(i > 0){
+			stages[i].in = thread_pipe_reader(&pipes[i-1]);
+		}
+		if(i < number_of_commands - 1){
+			stages[i].out = thread_pipe_writer(&pipes[i]);
+		}
+		if((i > 0 && stages[i].in == NULL) || stages[i].out == NULL){
+			perror("mish.c");
+			exit(errno);
+		}
+	}
+
+	for(int i = 0; i < number_of_commands; i++){
+		int ret = pthread_create(&stages[i].thread, NULL, run_thread_stage, \
+				&stages[i]);
+		if(ret != 0){
+			errno = ret;
+			perror("mish.c");
+			exit(errno);
+		}
+	}
+	for(int i = 0; i < number_of_commands; i++){
+		pthread_join(stages[i].thread, NULL);
+	}
+
+	for(int i = 0; i < number_of_commands - 1; i++){
+		thread_pipe_destroy(&pipes[i]);
+	}
+	return stages[number_of_commands-1].status;
+}
+
+/**
+ * run_thread_stage() - Runs one internal command of run_thread_pipeline() and
+ * closes its pipes. A stage reads what is left of its input before it closes
+ * it, so the stage before it is never cut off with EPIPE. Its status then
+ * does not depend on which thread happened to run first, and a stage which
+ * does not read, like echo, waits for the stages before it like a stage which
+ * does.
+ *
+ * @param arg The thread_stage.
+ * @return NULL.
+ */
+void *run_thread_stage(void *arg){
+	thread_stage *stage = arg;
+	command *cmd = stage->cmd;
+
+	if(strcmp(cmd->argv[0], "echo") == 0){
+		stage->status = internal_echo(cmd->argv, cmd->argc, stage->out);
+	}
+	else if(strcmp(cmd->argv[0], "jobs") == 0){
+		stage->status = internal_jobs(stage->out);
+	}
+	else if(strcmp(cmd->argv[0], "pass") == 0){
+		stage->status = internal_pass(stage->in != NULL ? stage->in : stdin, \
+				stage->out);
+	}
+	else{
+		stage->status = stats_main(cmd->argc, cmd->argv, stage->out);
+	}
+
+	if(stage->out == stdout){
+		fflush(stdout);
+	}
+	else if(fclose(stage->out) != 0){
+		stage->status = 1;
+	}
+	if(stage->in != NULL){
+		char drained[BUFSIZ];
+		while(fread(drained, 1, sizeof(drained), stage->in) > 0){
+			//Thrown away, like the output of a command nobody reads.
+		}
+		fclose(stage->in);
+	}
+	return NULL;
 }
 
 /**
@@ -215,34 +2420,64 @@ void run_internal_commands(command *command_array, int number_of_commands){
  * then the working directory is set to the given directory.
  *
  * @param dir The full directory to change to.
+ * @return 0 on success or 1 on failure.
  */
-void internal_cd(char *dir){
-    if(dir == NULL){ //Change dir to homedir if no argument given
-        dir = get_home_directory();
-        if(dir == NULL){
+int internal_cd(char *dir){
+    const char *path = dir;
+    if(path == NULL){ //Change dir to homedir if no argument given
+        path = get_home_directory();
+        if(path == NULL){
             fprintf(stderr, "Could not get home directory...\n");
-            return;
+            return 1;
         }
     }
 
-    int ret = chdir(dir);
+    int ret = chdir(path);
     if(ret < 0){
         perror("Internal cd");
+        return 1;
     }
+    return 0;
 }
 
 /**
- * get_home_directory() - Gets the home directory of the current process owner.
+ * get_home_directory() - Gets the home directory of the current process owner,
+ * $HOME or else the one in the user database, which is only asked once.
  *
- * @return The current home directory as a string.
+ * @return The current home directory as a string or NULL if it is not known.
  */
-char *get_home_directory(void){
-    struct passwd *pw = getpwuid(getuid());
-    if(pw == NULL){
-        perror("Get home dir");
-    }
-    char *dir = pw->pw_dir;
-    return dir;
+const char *get_home_directory(void){
+    return vars_home(NULL);
+}
+
+/**
+ * internal_pass() - Copies the input to the output until end of file, like
+ * cat without files. It copies a line at a time, so a terminal sees every
+ * line when it is typed.
+ *
+ * @param in The stream to read.
+ * @param out The stream to write to.
+ * @return 0 on success or 1 on failure.
+ */
+int internal_pass(FILE *in, FILE *out){
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
+	int status = 0;
+
+	while((len = getline(&line, &size, in)) > 0){
+		if(fwrite(line, 1, len, out) != (size_t)len){
+			perror("pass");
+			status = 1;
+			break;
+		}
+	}
+	if(status == 0 && ferror(in)){
+		perror("pass");
+		status = 1;
+	}
+	free(line);
+	return status;
 }
 
 /**
@@ -251,143 +2486,372 @@ char *get_home_directory(void){
  *
  * @param message A string array containing the message which should be printed.
  * @param words The amount of words in the array which should be printed.
+ * @param out The stream to print to.
+ * @return 0 on success or 1 on failure.
  */
-void internal_echo(char **message, int words){
+int internal_echo(char **message, int words, FILE *out){
 
     //Print all words except for the last one with a blankspace
     for(int i = 1; i < words-1; i++){
-        int ret = printf("%s ",message[i]);
+        int ret = fprintf(out, "%s ",message[i]);
         if(ret < 0){
             perror("Internal echo:");
+            return 1;
         }
     }
 
     //Print last word without blankspace
-    int ret = printf("%s\n",message[words-1]);
+    int ret = fprintf(out, "%s\n",message[words-1]);
     if(ret < 0){
         perror("Internal echo");
+        return 1;
     }
+    return 0;
+}
+
+/**
+ * internal_tagout() - Turns the tagged output of the jobs on or off. Without
+ * an argument the current mode is printed.
+ *
+ * @param mode "on", "off" or NULL.
+ * @return 0 on success or 1 on a bad mode.
+ */
+int internal_tagout(char *mode){
+	if(mode == NULL){
+		printf("tagout %s\n", tagged_output ? "on" : "off");
+	}
+	else if(strcmp(mode, "on") == 0){
+		tagged_output = 1;
+	}
+	else if(strcmp(mode, "off") == 0){
+		tagged_output = 0;
+	}
+	else{
+		fprintf(stderr, "Usage: tagout [on|off]\n");
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * internal_fg() - Continues a stopped or background job in the foreground
+ * and waits for it.
+ *
+ * @param id The id of the job, optionally after a "%", or NULL for the newest
+ * job.
+ * @return The exit status of the job, or 1 if there is no such job.
+ */
+int internal_fg(char *id){
+	int job_id = 0;
+	if(id != NULL){
+		job_id = atoi(id[0] == '%' ? id + 1 : id);
+		if(job_id <= 0){
+			fprintf(stderr, "Usage: fg [%%job]\n");
+			return 1;
+		}
+	}
+
+	shell_job *job = job_find(job_id);
+	if(job == NULL){
+		fprintf(stderr, "fg: no such job\n");
+		return 1;
+	}
+	fprintf(stderr, "%s\n", job->name);
+
+	if(job_control && job->pgid > 0 && \
+			tcsetpgrp(STDIN_FILENO, job->pgid) < 0){
+		perror("fg");
+	}
+	if(job_continue(job) < 0){
+		return 1;
+	}
+	return wait_for_job(job, NULL);
+}
+
+/**
+ * internal_jobs() - Prints the jobs which are not done.
+ *
+ * @param out The stream to print to.
+ * @return 0.
+ */
+int internal_jobs(FILE *out){
+	list_link *current_link = ilist_first(&current_shell_jobs);
+	while(current_link != NULL){
+		shell_job *job = ilist_entry(current_link, shell_job, link);
+		if(!job_is_done(job)){
+			fprintf(out, "[%d] %s\t%s\n", job->id, \
+					job_is_stopped(job) ? "Stopped" : "Running", job->name);
+		}
+		current_link = ilist_next(current_link, &current_shell_jobs);
+	}
+	return 0;
 }
 
 /**
- * pipe_and_fork_commands() - Create the nesseccary pipes for the for the given
- * commands to communicate with each other. Then it forks a new process where
- * the child process goes on to connected and close the required pipes and it's
- * ends.
+ * pipe_and_fork_commands() - Forks the given commands connected by pipes with
+ * the launch core, see launch.h. The hooks of the core put every child in
+ * the job, its process group and on its CPUs, and run the stage commands. The
+ * commands are found through the PATH cache of the shell.
  *
- * The parent process add the child to the list of active children. The parent
- * process also closes the pipe which is npt used anymore and moves an out_pipe
- * to the in_pipe variable in order to prepare for the next command.
+ * The parent does not wait for the execs, a child tells through its exec
+ * status pipe when it executed its command or failed to, which is read when
+ * it is reaped, see jobs.h. A pipeline with "|+" is split by fork_fan_out().
  *
  * @param command_array An array of external commands.
  * @param number_of_commands The number of external commands.
+ * @param options Replacements for the stdout and stderr of the pipeline and
+ * the placement of the commands.
  */
-void pipe_and_fork_commands(command *command_array, int number_of_commands){
-
-    int in_pipe[2];
-    int out_pipe[2];
+void pipe_and_fork_commands(command *command_array, int number_of_commands, \
+		const launch_options *options){
+    launch_spec spec;
 
-    //Create pipe
+    for(int i = 0; i < number_of_commands-1; i++){
+    	if(command_array[i].separator == SEP_FANOUT){
+    		fork_fan_out(command_array, number_of_commands, options);
+    		return;
+    	}
+    }
     for(int i = 0; i < number_of_commands; i++){
-        //Fork the command(s)
-    	if(i < number_of_commands-1){
-    		int ret = pipe(out_pipe);
-			if (ret == -1) {
-				perror("Pipe");
-				return;
-			}
+    	command_array[i].internal = is_stage_command(command_array[i].argv[0]);
+    }
+    if(path_cache == NULL){
+    	path_cache = launch_paths_new(PATH_CACHE_SLOTS);
+    	if(path_cache == NULL){
+    		perror("mish.c");
+    		exit(errno);
     	}
+    }
 
-        pid_t pid = fork();
-        if ( pid < 0 ) {
-            perror("fork");
-            exit(1);
+    launch_spec_init(&spec);
+    spec.stdin_fd = options->stdin_fd;
+    spec.stdout_fd = options->stdout_fd;
+    spec.stderr_fd = options->stderr_fd;
+    spec.exec_status = 1;
+    spec.paths = path_cache;
+    spec.setup = setup_stage;
+    spec.run_internal = run_stage_hook;
+    spec.started = add_stage_child;
+    spec.arg = (void *)options;
+    //The stages which were started are reaped with the job.
+    if(launch_pipeline(command_array, number_of_commands, &spec) < \
+    		number_of_commands){
+        perror("Pipeline");
+    }
+}
 
-        } else if ( pid == 0 ) { //Child process
+/**
+ * setup_stage() - Sets up a forked stage before its command runs, the setup
+ * hook of the launch core. It only makes system calls, like the core.
+ *
+ * @param stage The index of the stage in the commands which were launched.
+ * @param arg The launch options of the pipeline.
+ */
+void setup_stage(int stage, void *arg){
+	const launch_options *options = arg;
 
-        	int ret = 0;
-        	if(i != 0){ //Change stdin
+	if(options->profile != NULL){ //Only the shell samples the pipes
+		pipeprof_forget(options->profile);
+	}
+	if(options->placement != NULL){ //CPU and scheduling placement
+		placement_apply(options->placement, options->first_stage + stage);
+	}
+	if(job_control){ //The pipeline is a process group of its own
+		setpgid(0, options->job->pgid);
+		if(options->foreground){
+			tcsetpgrp(STDIN_FILENO, getpgrp());
+		}
+		reset_child_signals();
+	}
+	else if(options->own_group){ //Signalled as a group by the shell
+		setpgid(0, options->job->pgid);
+	}
+}
 
-				ret = dupPipe(in_pipe, READ_END, STDIN_FILENO);
-				if(ret < 0){
-					return;
-				}
-				ret = close(in_pipe[WRITE_END]);
-				ret += close(in_pipe[READ_END]);
-				if(ret < 0){
-					perror("Closing pipe write end");
-				}
+/**
+ * run_stage_hook() - Runs a stage command in its forked child, the
+ * run_internal hook of the launch core.
+ *
+ * @param cmd The stage command.
+ * @param arg The launch options of the pipeline.
+ * @return The exit status of the stage.
+ */
+int run_stage_hook(command *cmd, void *arg){
+	(void)arg;
+	int status = run_stage_command(*cmd);
+	//The core leaves with _exit(), which does not flush.
+	fflush(stdout);
+	return status;
+}
 
-			}
-        	if(i != number_of_commands-1){ //Change stdout
+/**
+ * add_stage_child() - Adds a forked stage to the job of the pipeline, the
+ * started hook of the launch core. The job gets the exec status pipe of the
+ * stage, and the profiler its stage and the pipe it reads.
+ *
+ * @param launched The forked stage.
+ * @param arg The launch options of the pipeline.
+ */
+void add_stage_child(const launch_child *launched, void *arg){
+	const launch_options *options = arg;
+	int stage = launched->stage;
 
-				ret = dupPipe(out_pipe, WRITE_END, STDOUT_FILENO);
-				if(ret < 0){
-					return;
-				}
-				ret = close(out_pipe[READ_END]);
-				ret += close(out_pipe[WRITE_END]);
-				if(ret < 0){
-					perror("Closing pipe read end");
-				}
-			}
+	stats_count(STATS_FORKS, 1);
+	stats_count(STATS_PATH_HITS, launched->path_hit);
+	if(options->profile != NULL && launched->in_fd >= 0){
+		//Its reader is forked now.
+		pipeprof_add_pipe(options->profile, stage-1, launched->in_fd);
+	}
 
-            if(execute_external_command(command_array[i]) != 0){
-            	//Memory is copied, and a child will not have children.
-            	free_and_kill_entire_list();
-            	ret = close(STDIN_FILENO);
-            	ret += close(STDOUT_FILENO);
-            	ret += close(STDERR_FILENO);
-            	if(ret < 0){
-					perror("Closing pipe read end");
-				}
-            	exit(1);
-            }
+	//Only the last command of the pipeline is not followed by a pipe.
+	shell_child *child = job_add_child(options->job, launched->pid, \
+			options->first_stage + stage, options->ends_job && \
+			launched->cmd->separator != SEP_PIPE, launched->cmd->argv[0]);
+	child->exec_fd = launched->exec_fd;
+	child->forked = launched->forked;
+	if(options->profile != NULL){
+		pipeprof_add_stage(options->profile, stage, launched->pid, \
+				launched->cmd->argv[0]);
+	}
+	if(job_control || options->own_group){
+		//Also set here, so the group exists before either one runs.
+		if(options->job->pgid == 0){
+			options->job->pgid = launched->pid;
+		}
+		setpgid(launched->pid, options->job->pgid);
+		if(job_control && options->foreground && stage == 0){
+			tcsetpgrp(STDIN_FILENO, options->job->pgid);
+		}
+	}
+}
 
-            return;
+/**
+ * fork_fan_out() - Forks a pipeline with "|+". The commands before the first
+ * "|+" are the producer, which writes to a pipe. The commands between the
+ * following ones are the consumers, each reading from a pipe of its own. A
+ * helper copies the output of the producer to the consumers, see fanout.h.
+ * The last command is the last stage of the job.
+ *
+ * @param command_array An array of external commands.
+ * @param number_of_commands The number of external commands.
+ * @param options Replacements for the stdio of the pipeline and the
+ * placement of the commands.
+ */
+void fork_fan_out(command *command_array, int number_of_commands, \
+		const launch_options *options){
+	int producer_length = 0;
+	int consumers = 0;
+	for(int i = 0; i < number_of_commands-1; i++){
+		if(command_array[i].separator == SEP_FANOUT){
+			if(consumers++ == 0){
+				producer_length = i + 1;
+			}
+		}
+	}
 
-        } else { // Parentprocess
-        	if(i != 0){
-        		int ret = close(in_pipe[READ_END]);
-				if(ret < 0){
-					perror("Closing pipe");
-				}
-				ret = close(in_pipe[WRITE_END]);
-				if(ret < 0){
-					perror("Closing pipe");
-				}
+	//Close-on-exec, the children get them as stdin or stdout.
+	int producer_pipe[2];
+	int consumer_pipes[consumers][2];
+	if(pipe2(producer_pipe, O_CLOEXEC) < 0){
+		perror("Pipe");
+		return;
+	}
+	for(int i = 0; i < consumers; i++){
+		if(pipe2(consumer_pipes[i], O_CLOEXEC) < 0){
+			perror("Pipe");
+			close(producer_pipe[READ_END]);
+			close(producer_pipe[WRITE_END]);
+			for(int j = 0; j < i; j++){
+				close(consumer_pipes[j][READ_END]);
+				close(consumer_pipes[j][WRITE_END]);
 			}
+			return;
+		}
+	}
 
-        	in_pipe[0] = out_pipe[0];
-        	in_pipe[1] = out_pipe[1];
+	//The helper is forked first, so no other child holds its ends.
+	start_fan_out_helper(producer_pipe, consumer_pipes, consumers, options, \
+			producer_length);
+	close(producer_pipe[READ_END]);
+	for(int i = 0; i < consumers; i++){
+		close(consumer_pipes[i][WRITE_END]);
+	}
 
-        	int *child_pid = malloc(sizeof(int));
-        	*child_pid = pid;
-        	list_append(child_pid, current_shell_children);
-        }
+	launch_options part = *options;
+	part.stdout_fd = producer_pipe[WRITE_END];
+	part.ends_job = 0;
+	pipe_and_fork_commands(command_array, producer_length, &part);
+	close(producer_pipe[WRITE_END]);
 
-    }
-    return;
+	int start = producer_length;
+	int consumer = 0;
+	for(int i = start; i < number_of_commands; i++){
+		if(i < number_of_commands-1 && \
+				command_array[i].separator != SEP_FANOUT){
+			continue;
+		}
+		part = *options;
+		part.stdin_fd = consumer_pipes[consumer][READ_END];
+		part.first_stage = options->first_stage + start + 1;
+		part.ends_job = options->ends_job && i == number_of_commands-1;
+		pipe_and_fork_commands(command_array + start, i - start + 1, &part);
+		close(consumer_pipes[consumer][READ_END]);
+		consumer++;
+		start = i + 1;
+	}
 }
 
 /**
- * free_and_kill_entire_list() - Destroys the current_shell_children list of
- * the process. The inserted pids are also destroyed.
+ * start_fan_out_helper() - Forks the helper which copies the output of the
+ * producer of a fan-out to the consumers. It is a child of the job like the
+ * commands. The helper only keeps the ends it uses, so it sees when a
+ * consumer is gone.
+ *
+ * @param producer_pipe The pipe of the producer.
+ * @param consumer_pipes The pipes of the consumers.
+ * @param consumers The number of consumers.
+ * @param options The options of the pipeline.
+ * @param stage The stage of the helper in the job.
  */
-void free_and_kill_entire_list(void){
-	list_pos first_pos = list_get_first_position(current_shell_children);
-	list_pos current_pos = \
-	list_get_previous_position(list_get_last_position(current_shell_children), \
-			current_shell_children);
-
-	while(current_pos != first_pos){
-		int *pid = (int*)list_get_value(current_pos);
-		current_pos = list_remove_element(current_pos, current_shell_children);
-		free(pid);
+void start_fan_out_helper(int producer_pipe[2], int consumer_pipes[][2], \
+		int consumers, const launch_options *options, int stage){
+	fflush(stdout);
+	pid_t pid = fork();
+	if(pid < 0){
+		perror("fork");
+		exit(1);
 	}
+	else if(pid == 0){ //Child process
+		if(job_control){
+			setpgid(0, options->job->pgid);
+			reset_child_signals();
+		}
+		else if(options->own_group){
+			setpgid(0, options->job->pgid);
+		}
+		reset_shell_handlers();
+		//A consumer which exits early is dropped, not a reason to die.
+		signal(SIGPIPE, SIG_IGN);
+		jobs_forget();
 
-	list_kill(current_shell_children);
+		int out_fds[consumers];
+		close(producer_pipe[WRITE_END]);
+		for(int i = 0; i < consumers; i++){
+			close(consumer_pipes[i][READ_END]);
+			out_fds[i] = consumer_pipes[i][WRITE_END];
+		}
+		exit(fanout_copy(producer_pipe[READ_END], out_fds, consumers) < 0 ? \
+				1 : 0);
+	}
 
+	stats_count(STATS_FORKS, 1);
+	job_add_child(options->job, pid, options->first_stage + stage, 0, "|+");
+	if(job_control || options->own_group){
+		if(options->job->pgid == 0){
+			options->job->pgid = pid;
+		}
+		setpgid(pid, options->job->pgid);
+	}
 }
 
 /**
@@ -0,0 +1,294 @@
+/*
+ * mux.c Is the source code for the output multiplexer of mish. See the header
+ * file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "mux.h"
+#include "list.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+/* Defines */
+#define MUX_EVENTS 16
+#define MUX_PREFIX_MAX 64
+
+/*A captured stream and the partial line read from it.*/
+typedef struct mux_stream{
+	list_link link;
+	int fd;
+	int destfd;
+	int job_id;
+	size_t used;
+	char line[MUX_LINE_MAX];
+}mux_stream;
+
+/*The multiplexer type.*/
+struct mux{
+	int epoll_fd;
+	int open_streams;
+	ilist streams;
+};
+
+/*Function prototypes.*/
+static void mux_read_stream(mux *m, mux_stream *stream);
+static void mux_close_stream(mux *m, mux_stream *stream);
+static void mux_write_line(mux_stream *stream, const char *line, size_t len);
+static int write_all(int fd, const char *buf, size_t len);
+
+
+/**
+ * mux_new() - Creates a new multiplexer without any streams.
+ *
+ * @return A pointer to the new mux or NULL on failure.
+ */
+mux *mux_new(void){
+	mux *m = calloc(1, sizeof(*m));
+	if(m == NULL){
+		perror("mux");
+		return NULL;
+	}
+
+	m->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(m->epoll_fd < 0){
+		perror("epoll_create1");
+		free(m);
+		return NULL;
+	}
+	ilist_init(&m->streams);
+
+	return m;
+}
+
+/**
+ * mux_add() - Adds the read end of a pipe to the multiplexer. The mux takes
+ * over the file descriptor and closes it when the writers are gone.
+ *
+ * @param m The multiplexer.
+ * @param fd The read end of the pipe.
+ * @param job_id The id which the lines of the stream are tagged with.
+ * @param destfd The file descriptor which the tagged lines are written to.
+ * @return 0 on success or -1 on failure.
+ */
+int mux_add(mux *m, int fd, int job_id, int destfd){
+	int flags = fcntl(fd, F_GETFL);
+	if(flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0){
+		perror("mux fcntl");
+		return -1;
+	}
+
+	mux_stream *stream = calloc(1, sizeof(*stream));
+	if(stream == NULL){
+		perror("mux");
+		return -1;
+	}
+	stream->fd = fd;
+	stream->destfd = destfd;
+	stream->job_id = job_id;
+
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.ptr = stream;
+	if(epoll_ctl(m->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0){
+		perror("epoll_ctl");
+		free(stream);
+		return -1;
+	}
+
+	ilist_append(&stream->link, &m->streams);
+	m->open_streams++;
+	return 0;
+}
+
+/**
+ * mux_fd() - Gets a file descriptor which is readable when any stream of the
+ * multiplexer has output, so the mux can be waited on together with other
+ * events.
+ *
+ * @param m The multiplexer.
+ * @return The epoll file descriptor of the mux.
+ */
+int mux_fd(mux *m){
+	return m->epoll_fd;
+}
+
+/**
+ * mux_dispatch() - Reads and writes the output of all streams which are ready
+ * without waiting for more.
+ *
+ * @param m The multiplexer.
+ */
+void mux_dispatch(mux *m){
+	struct epoll_event events[MUX_EVENTS];
+	int ready;
+
+	do{
+		ready = epoll_wait(m->epoll_fd, events, MUX_EVENTS, 0);
+		if(ready < 0){
+			if(errno != EINTR){
+				perror("epoll_wait");
+			}
+			return;
+		}
+		for(int i = 0; i < ready; i++){
+			mux_read_stream(m, events[i].data.ptr);
+		}
+	}while(ready == MUX_EVENTS);
+}
+
+/**
+ * mux_is_done() - Checks if every stream has reached end of file.
+ *
+ * @param m The multiplexer.
+ * @return 1 if all streams are closed, else 0.
+ */
+int mux_is_done(mux *m){
+	return m->open_streams == 0;
+}
+
+/**
+ * mux_kill() - Closes the remaining streams and removes the multiplexer.
+ *
+ * @param m The multiplexer.
+ */
+void mux_kill(mux *m){
+	list_link *current_link = ilist_first(&m->streams);
+	while(current_link != NULL){
+		mux_stream *stream = ilist_entry(current_link, mux_stream, link);
+		current_link = ilist_next(current_link, &m->streams);
+		mux_close_stream(m, stream);
+	}
+
+	close(m->epoll_fd);
+	free(m);
+}
+
+/**
+ * mux_read_stream() - Reads everything available on a stream and writes all
+ * complete lines. A line which does not fit in the buffer is written in
+ * pieces. At end of file the last partial line is written and the stream is
+ * closed.
+ *
+ * @param m The multiplexer.
+ * @param stream The stream which is ready to be read.
+ */
+static void mux_read_stream(mux *m, mux_stream *stream){
+	while(1){
+		ssize_t n = read(stream->fd, stream->line + stream->used, \
+				MUX_LINE_MAX - stream->used);
+		if(n < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			if(errno != EAGAIN && errno != EWOULDBLOCK){
+				perror("mux read");
+				mux_close_stream(m, stream);
+			}
+			return;
+		}
+		if(n == 0){
+			if(stream->used > 0){
+				mux_write_line(stream, stream->line, stream->used);
+			}
+			mux_close_stream(m, stream);
+			return;
+		}
+
+		//Write every complete line and keep the rest for the next read.
+		size_t scanned = stream->used;
+		size_t start = 0;
+		stream->used += n;
+		for(size_t i = scanned; i < stream->used; i++){
+			if(stream->line[i] == '\n'){
+				mux_write_line(stream, stream->line + start, i - start);
+				start = i + 1;
+			}
+		}
+		if(start == 0 && stream->used == MUX_LINE_MAX){
+			mux_write_line(stream, stream->line, stream->used);
+			start = stream->used;
+		}
+		memmove(stream->line, stream->line + start, stream->used - start);
+		stream->used -= start;
+	}
+}
+
+/**
+ * mux_close_stream() - Closes the pipe of a stream and frees the stream.
+ *
+ * @param m The multiplexer.
+ * @param stream The stream which should be closed.
+ */
+static void mux_close_stream(mux *m, mux_stream *stream){
+	epoll_ctl(m->epoll_fd, EPOLL_CTL_DEL, stream->fd, NULL);
+	if(close(stream->fd) < 0){
+		perror("mux close");
+	}
+	ilist_remove(&stream->link);
+	free(stream);
+	m->open_streams--;
+}
+
+/**
+ * mux_write_line() - Writes one line to the destination of the stream
+ * prefixed with the job id and the current time. The line is written with a
+ * single write so lines from different jobs are never mixed.
+ *
+ * @param stream The stream which the line was read from.
+ * @param line The line without the newline.
+ * @param len The length of the line.
+ */
+static void mux_write_line(mux_stream *stream, const char *line, size_t len){
+	char out[MUX_PREFIX_MAX + MUX_LINE_MAX + 1];
+	struct timespec now;
+	struct tm local;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	localtime_r(&now.tv_sec, &local);
+	int prefix = snprintf(out, MUX_PREFIX_MAX, "[%d %02d:%02d:%02d.%03ld] ", \
+			stream->job_id, local.tm_hour, local.tm_min, local.tm_sec, \
+			now.tv_nsec / 1000000);
+	if(prefix < 0 || prefix >= MUX_PREFIX_MAX){
+		prefix = 0;
+	}
+
+	memcpy(out + prefix, line, len);
+	out[prefix + len] = '\n';
+	if(write_all(stream->destfd, out, prefix + len + 1) < 0){
+		perror("mux write");
+	}
+}
+
+/**
+ * write_all() - Writes the whole buffer to a file descriptor.
+ *
+ * @param fd The file descriptor to write to.
+ * @param buf The data.
+ * @param len The length of the data.
+ * @return 0 on success or -1 on failure.
+ */
+static int write_all(int fd, const char *buf, size_t len){
+	while(len > 0){
+		ssize_t n = write(fd, buf, len);
+		if(n < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * mux.h Is the header file for the output multiplexer of mish. When several
+ * pipelines run at once, their stdout and stderr can be captured through pipes
+ * and handed to a mux. The mux reads all pipes with epoll, buffers the output
+ * line by line for each job and writes every complete line prefixed with the
+ * job id and a timestamp. The pipes are read as soon as they have data, so the
+ * producers never wait on each other.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef MUX_H_
+#define MUX_H_
+
+/*The longest line which is written in one piece, longer lines are split.*/
+#define MUX_LINE_MAX 4096
+
+typedef struct mux mux;
+
+/**
+ * mux_new() - Creates a new multiplexer without any streams.
+ *
+ * @return A pointer to the new mux or NULL on failure.
+ */
+mux *mux_new(void);
+
+/**
+ * mux_add() - Adds the read end of a pipe to the multiplexer. The mux takes
+ * over the file descriptor and closes it when the writers are gone.
+ *
+ * @param m The multiplexer.
+ * @param fd The read end of the pipe.
+ * @param job_id The id which the lines of the stream are tagged with.
+ * @param destfd The file descriptor which the tagged lines are written to.
+ * @return 0 on success or -1 on failure.
+ */
+int mux_add(mux *m, int fd, int job_id, int destfd);
+
+/**
+ * mux_fd() - Gets a file descriptor which is readable when any stream of the
+ * multiplexer has output, so the mux can be waited on together with other
+ * events.
+ *
+ * @param m The multiplexer.
+ * @return The epoll file descriptor of the mux.
+ */
+int mux_fd(mux *m);
+
+/**
+ * mux_dispatch() - Reads and writes the output of all streams which are ready
+ * without waiting for more.
+ *
+ * @param m The multiplexer.
+ */
+void mux_dispatch(mux *m);
+
+/**
+ * mux_is_done() - Checks if every stream has reached end of file.
+ *
+ * @param m The multiplexer.
+ * @return 1 if all streams are closed, else 0.
+ */
+int mux_is_done(mux *m);
+
+/**
+ * mux_kill() - Closes the remaining streams and removes the multiplexer.
+ *
+ * @param m The multiplexer.
+ */
+void mux_kill(mux *m);
+
+#endif /* MUX_H_ */
@@ -0,0 +1,544 @@
+/*
+ * outcache.c Is the source code for the output cache of mish. See the header
+ * file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "outcache.h"
+#include "execute.h"
+#include "hash.h"
+#include "scriptcache.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+
+/* Defines */
+#define ENTRY_MAGIC 0x6d6f7574	//"mout"
+#define ENTRY_VERSION 1
+#define KEY_SEED_2 0x6f7574636163686bULL	//The seed of the second half
+#define COPY_CHUNK 65536
+
+/*The start of an entry file, followed by the stdout and the stderr.*/
+typedef struct entry_header{
+	uint32_t magic;
+	uint32_t version;
+	int32_t status;
+	uint32_t unused;
+	uint64_t out_len;
+	uint64_t err_len;
+}entry_header;
+
+/*A key of 128 bits, made of two hashes with different seeds.*/
+typedef struct cache_key{
+	uint64_t h1;
+	uint64_t h2;
+}cache_key;
+
+/*A stored entry, for the eviction.*/
+typedef struct stored_entry{
+	struct timespec used;
+	off_t size;
+	char name[NAME_MAX + 1];
+}stored_entry;
+
+/*Function prototypes.*/
+static void key_add(cache_key *key, const void *data, size_t len);
+static void key_add_string(cache_key *key, const char *str);
+static int key_add_command(cache_key *key, command *cmd);
+static int key_add_file(cache_key *key, const char *path);
+static int output_dir(char *dir, size_t size);
+static int copy_out(int in_fd, off_t offset, uint64_t len, int out_fd);
+static long cache_limit(void);
+static void evict(const char *dir, long limit);
+static int compare_used(const void *a, const void *b);
+
+
+/**
+ * outcache_parse() - Parses the options of the cache prefix.
+ *
+ * @param spec The options to fill in.
+ * @param argc The number of words, starting with "cache".
+ * @param argv The words.
+ * @return The number of words used by the prefix, or -1 on a bad option.
+ */
+int outcache_parse(outcache_spec *spec, int argc, char **argv){
+	spec->number_of_env = 0;
+
+	int opt;
+	optind = 0;
+	while((opt = getopt(argc, argv, "+e:")) != -1){
+		switch(opt){
+		case 'e':
+			if(spec->number_of_env == OUTCACHE_MAX_ENV){
+				fprintf(stderr, "cache: at most %d variables\n", \
+						OUTCACHE_MAX_ENV);
+				return -1;
+			}
+			spec->env[spec->number_of_env++] = optarg;
+			break;
+		default:
+			fprintf(stderr, "Usage: cache [-e NAME]... pipeline\n");
+			return -1;
+		}
+	}
+
+	if(optind >= argc){
+		fprintf(stderr, "Usage: cache [-e NAME]... pipeline\n");
+		return -1;
+	}
+	return optind;
+}
+
+/**
+ * outcache_open() - Makes the key of a pipeline and finds the file of its
+ * entry.
+ *
+ * @param entry The entry to fill in.
+ * @param spec The options of the prefix.
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @return 0 on success or -1 if the pipeline can not be cached.
+ */
+int outcache_open(outcache_entry *entry, const outcache_spec *spec, \
+		command *command_array, int number_of_commands){
+	cache_key key = {HASH_SEED, KEY_SEED_2};
+	char cwd[PATH_MAX];
+	char dir[PATH_MAX];
+
+	entry->in_fd = -1;
+	entry->out_fd = -1;
+	entry->err_fd = -1;
+
+	key_add(&key, &(uint32_t){ENTRY_VERSION}, sizeof(uint32_t));
+	if(getcwd(cwd, sizeof(cwd)) == NULL){
+		return -1;
+	}
+	key_add_string(&key, cwd);
+
+	for(int i = 0; i < spec->number_of_env; i++){
+		const char *value = getenv(spec->env[i]);
+		key_add_string(&key, spec->env[i]);
+		//An unset variable differs from an empty one.
+		key_add(&key, &(char){value != NULL}, 1);
+		if(value != NULL){
+			key_add_string(&key, value);
+		}
+	}
+
+	for(int i = 0; i < number_of_commands; i++){
+		if(key_add_command(&key, &command_array[i]) < 0){
+			return -1;
+		}
+	}
+
+	if(output_dir(dir, sizeof(dir)) < 0){
+		return -1;
+	}
+	int len = snprintf(entry->path, sizeof(entry->path), "%s/%016llx%016llx", \
+			dir, (unsigned long long)key.h1, (unsigned long long)key.h2);
+	int tmp_len = snprintf(entry->tmp_path, sizeof(entry->tmp_path), \
+			"%s/.tmp.%d", dir, (int)getpid());
+	if(len <= 0 || (size_t)len >= sizeof(entry->path) || tmp_len <= 0 || \
+			(size_t)tmp_len >= sizeof(entry->tmp_path)){
+		return -1;
+	}
+
+	if(command_array[0].infile == NULL){
+		entry->in_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	}
+	return 0;
+}
+
+/**
+ * outcache_replay() - Writes the stored output of an entry to the stdout
+ * and stderr of the shell and marks the entry as used.
+ *
+ * @param entry The entry.
+ * @param status Set to the stored exit status.
+ * @return 0 if the entry was replayed or -1 if it is not stored.
+ */
+int outcache_replay(outcache_entry *entry, int *status){
+	entry_header header;
+	struct stat st;
+
+	int fd = open(entry->path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0){
+		return -1;
+	}
+	if(fstat(fd, &st) < 0 || \
+			pread(fd, &header, sizeof(header), 0) != sizeof(header) || \
+			header.magic != ENTRY_MAGIC || header.version != ENTRY_VERSION || \
+			(uint64_t)st.st_size != sizeof(header) + header.out_len + \
+			header.err_len){
+		close(fd);
+		return -1;
+	}
+
+	//The mtime is when the entry was last used.
+	futimens(fd, NULL);
+	copy_out(fd, sizeof(header), header.out_len, STDOUT_FILENO);
+	copy_out(fd, sizeof(header) + header.out_len, header.err_len, \
+			STDERR_FILENO);
+	close(fd);
+
+	if(entry->in_fd >= 0){
+		close(entry->in_fd);
+	}
+	*status = header.status;
+	return 0;
+}
+
+/**
+ * outcache_begin() - Opens the files the output of the pipeline is written
+ * to while it runs.
+ *
+ * @param entry The entry, the fds of the pipeline are set in it.
+ * @return 0 on success or -1 on failure.
+ */
+int outcache_begin(outcache_entry *entry){
+	char dir[PATH_MAX];
+	strcpy(dir, entry->tmp_path);
+	*strrchr(dir, '/') = '\0';
+
+	//The stderr only needs a file while the pipeline runs.
+	entry->err_fd = open(dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+	entry->out_fd = open(entry->tmp_path, O_RDWR | O_CREAT | O_TRUNC | \
+			O_CLOEXEC, 0600);
+	//The output is written after the room for the header.
+	if(entry->err_fd < 0 || entry->out_fd < 0 || \
+			ftruncate(entry->out_fd, sizeof(entry_header)) < 0 || \
+			lseek(entry->out_fd, sizeof(entry_header), SEEK_SET) < 0){
+		if(entry->out_fd >= 0){
+			close(entry->out_fd);
+			unlink(entry->tmp_path);
+		}
+		if(entry->err_fd >= 0){
+			close(entry->err_fd);
+		}
+		if(entry->in_fd >= 0){
+			close(entry->in_fd);
+		}
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * outcache_finish() - Writes the output of a pipeline which has run to the
+ * stdout and stderr of the shell and stores it if asked to.
+ *
+ * @param entry The entry.
+ * @param status The exit status of the pipeline.
+ * @param store 1 if the entry is stored, else 0.
+ */
+void outcache_finish(outcache_entry *entry, int status, int store){
+	entry_header header = {ENTRY_MAGIC, ENTRY_VERSION, status, 0, 0, 0};
+	header.out_len = lseek(entry->out_fd, 0, SEEK_END) - sizeof(header);
+	header.err_len = lseek(entry->err_fd, 0, SEEK_END);
+
+	copy_out(entry->out_fd, sizeof(header), header.out_len, STDOUT_FILENO);
+	copy_out(entry->err_fd, 0, header.err_len, STDERR_FILENO);
+
+	long limit = cache_limit();
+	if(store && sizeof(header) + header.out_len + header.err_len <= \
+			(uint64_t)limit && \
+			copy_out(entry->err_fd, 0, header.err_len, entry->out_fd) == 0 && \
+			pwrite(entry->out_fd, &header, sizeof(header), 0) == \
+			sizeof(header) && rename(entry->tmp_path, entry->path) == 0){
+		*strrchr(entry->tmp_path, '/') = '\0';
+		evict(entry->tmp_path, limit);
+	}
+	else{
+		unlink(entry->tmp_path);
+	}
+
+	close(entry->out_fd);
+	close(entry->err_fd);
+	if(entry->in_fd >= 0){
+		close(entry->in_fd);
+	}
+}
+
+/**
+ * key_add() - Adds data to a key, with its length so that the fields of the
+ * key can not run into each other.
+ *
+ * @param key The key.
+ * @param data The data.
+ * @param len The length of the data.
+ */
+static void key_add(cache_key *key, const void *data, size_t len){
+	uint64_t len64 = len;
+	key->h1 = hash_bytes(data, len, hash_bytes(&len64, sizeof(len64), \
+			key->h1));
+	key->h2 = hash_bytes(data, len, hash_bytes(&len64, sizeof(len64), \
+			key->h2));
+}
+
+/**
+ * key_add_string() - Adds a string to a key.
+ *
+ * @param key The key.
+ * @param str The string.
+ */
+static void key_add_string(cache_key *key, const char *str){
+	key_add(key, str, strlen(str));
+}
+
+/**
+ * key_add_command() - Adds a command to a key, with the identity of the file
+ * it executes and the contents of its input file.
+ *
+ * @param key The key.
+ * @param cmd The command.
+ * @return 0 on success or -1 if the command can not be cached.
+ */
+static int key_add_command(cache_key *key, command *cmd){
+	char path[PATH_MAX];
+	struct stat st;
+
+	if(cmd->outfile != NULL){
+		return -1;
+	}
+	if(strchr(cmd->argv[0], '/') != NULL){
+		snprintf(path, sizeof(path), "%s", cmd->argv[0]);
+	}
+	else if(find_command(cmd->argv[0], path, sizeof(path)) < 0){
+		return -1;
+	}
+	if(stat(path, &st) < 0){
+		return -1;
+	}
+
+	key_add(key, &cmd->argc, sizeof(cmd->argc));
+	for(int i = 0; i < cmd->argc; i++){
+		key_add_string(key, cmd->argv[i]);
+	}
+	key_add(key, &cmd->separator, sizeof(cmd->separator));
+	key_add(key, &st.st_dev, sizeof(st.st_dev));
+	key_add(key, &st.st_ino, sizeof(st.st_ino));
+	key_add(key, &st.st_size, sizeof(st.st_size));
+	key_add(key, &st.st_mtim, sizeof(st.st_mtim));
+
+	if(cmd->infile != NULL){
+		key_add_string(key, cmd->infile);
+		return key_add_file(key, cmd->infile);
+	}
+	return 0;
+}
+
+/**
+ * key_add_file() - Adds the contents of a file to a key.
+ *
+ * @param key The key.
+ * @param path The path of the file.
+ * @return 0 on success or -1 if the file can not be read.
+ */
+static int key_add_file(cache_key *key, const char *path){
+	struct stat st;
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0){
+		return -1;
+	}
+	if(fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)){
+		close(fd);
+		return -1;
+	}
+
+	void *data = NULL;
+	if(st.st_size > 0){
+		data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(data == MAP_FAILED){
+			close(fd);
+			return -1;
+		}
+	}
+	close(fd);
+
+	key_add(key, data, st.st_size);
+	if(data != NULL){
+		munmap(data, st.st_size);
+	}
+	return 0;
+}
+
+/**
+ * output_dir() - Gets the directory of the entries and makes sure it exists.
+ *
+ * @param dir The buffer for the directory.
+ * @param size The size of the buffer.
+ * @return 0 on success or -1 if there is no usable directory.
+ */
+static int output_dir(char *dir, size_t size){
+	if(script_cache_dir(dir, size) < 0){
+		return -1;
+	}
+	size_t len = strlen(dir);
+	if(len + sizeof("/output") > size){
+		return -1;
+	}
+	strcpy(dir + len, "/output");
+	if(mkdir(dir, 0700) < 0 && errno != EEXIST){
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * copy_out() - Copies a part of a file to a file descriptor, with
+ * sendfile() when the kernel can do it.
+ *
+ * @param in_fd The file to copy from.
+ * @param offset Where the part starts.
+ * @param len The length of the part.
+ * @param out_fd The file descriptor to copy to.
+ * @return 0 on success or -1 on failure.
+ */
+static int copy_out(int in_fd, off_t offset, uint64_t len, int out_fd){
+	while(len > 0){
+		ssize_t n = sendfile(out_fd, in_fd, &offset, \
+				len < COPY_CHUNK ? len : COPY_CHUNK);
+		if(n > 0){
+			len -= n;
+			continue;
+		}
+		else if(n < 0 && errno == EINTR){
+			continue;
+		}
+		else if(n == 0 || (errno != EINVAL && errno != ENOSYS)){
+			return -1;
+		}
+
+		//The output can not take sendfile(), like a file in append mode.
+		char buf[COPY_CHUNK];
+		n = pread(in_fd, buf, len < sizeof(buf) ? len : sizeof(buf), offset);
+		if(n <= 0){
+			return -1;
+		}
+		for(ssize_t done = 0; done < n; ){
+			ssize_t written = write(out_fd, buf + done, n - done);
+			if(written < 0 && errno != EINTR){
+				return -1;
+			}
+			done += written > 0 ? written : 0;
+		}
+		offset += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/**
+ * cache_limit() - Gets the size limit of the cache from $MISH_CACHE_LIMIT.
+ *
+ * @return The limit in bytes.
+ */
+static long cache_limit(void){
+	const char *text = getenv("MISH_CACHE_LIMIT");
+	if(text == NULL){
+		return OUTCACHE_DEFAULT_LIMIT;
+	}
+
+	char *end;
+	long limit = strtol(text, &end, 10);
+	if(end == text || limit < 0){
+		return OUTCACHE_DEFAULT_LIMIT;
+	}
+	switch(*end){
+	case 'K':
+		limit <<= 10;
+		break;
+	case 'M':
+		limit <<= 20;
+		break;
+	case 'G':
+		limit <<= 30;
+		break;
+	default:
+		break;
+	}
+	return limit;
+}
+
+/**
+ * evict() - Removes the least recently used entries until the entries are
+ * no larger than the limit.
+ *
+ * @param dir The directory of the entries.
+ * @param limit The limit in bytes.
+ */
+static void evict(const char *dir, long limit){
+	DIR *d = opendir(dir);
+	if(d == NULL){
+		return;
+	}
+
+	stored_entry *entries = NULL;
+	size_t number_of_entries = 0;
+	size_t allocated = 0;
+	long total = 0;
+	struct dirent *ent;
+	while((ent = readdir(d)) != NULL){
+		struct stat st;
+		if(ent->d_name[0] == '.' || \
+				fstatat(dirfd(d), ent->d_name, &st, 0) < 0){
+			continue;
+		}
+		if(number_of_entries == allocated){
+			allocated = allocated > 0 ? allocated * 2 : 64;
+			entries = realloc(entries, allocated * sizeof(*entries));
+			if(entries == NULL){
+				perror("outcache.c");
+				exit(errno);
+			}
+		}
+		stored_entry *e = &entries[number_of_entries++];
+		e->used = st.st_mtim;
+		e->size = st.st_size;
+		strcpy(e->name, ent->d_name);
+		total += st.st_size;
+	}
+
+	if(total > limit){
+		qsort(entries, number_of_entries, sizeof(*entries), compare_used);
+		for(size_t i = 0; i < number_of_entries && total > limit; i++){
+			if(unlinkat(dirfd(d), entries[i].name, 0) == 0){
+				total -= entries[i].size;
+			}
+		}
+	}
+	free(entries);
+	closedir(d);
+}
+
+/**
+ * compare_used() - Compares two entries by when they were used, for qsort().
+ *
+ * @param a The first entry.
+ * @param b The second entry.
+ * @return Less than 0 if a was used before b, 0 if at the same time, else
+ * greater than 0.
+ */
+static int compare_used(const void *a, const void *b){
+	const struct timespec *x = &((const stored_entry *)a)->used;
+	const struct timespec *y = &((const stored_entry *)b)->used;
+	if(x->tv_sec != y->tv_sec){
+		return x->tv_sec < y->tv_sec ? -1 : 1;
+	}
+	return (x->tv_nsec > y->tv_nsec) - (x->tv_nsec < y->tv_nsec);
+}
@@ -0,0 +1,114 @@
+/*
+ * outcache.h Is the header file for the output cache of mish, which replays
+ * the output of deterministic pipelines instead of running them again:
+ *
+ *   cache [-e NAME]... pipeline
+ *
+ * The pipeline is looked up by a key made of the working directory, the
+ * words of its commands, the identity of the executed files (device, inode,
+ * size and mtime of the file found in PATH), the values of the environment
+ * variables named with -e and the contents of the files named in "<"
+ * redirections. If an entry with the key is stored, its stdout, stderr and
+ * exit status are replayed and nothing is executed.
+ *
+ * Otherwise the pipeline is run with its stdout and stderr written to files
+ * in the cache, which are written to the stdout and stderr of the shell when
+ * it is done, so the output of a cached pipeline is not seen while it runs
+ * and its stdout comes before its stderr. A pipeline without a "<" gets
+ * /dev/null as stdin, since what it reads is not part of the key. Pipelines
+ * which exit normally are stored, whatever their status. Pipelines killed by
+ * a signal, stopped or interrupted are not.
+ *
+ * A pipeline whose commands are not found, which has a ">" redirection or
+ * which runs with tagged output is run without the cache.
+ *
+ * The entries are files in the "output" directory of the cache directory of
+ * mish, see scriptcache.h. The total size is kept under $MISH_CACHE_LIMIT, a
+ * size like "500K", "64M" or "1G", by removing the least recently used
+ * entries when an entry is stored. An entry larger than the limit is never
+ * stored.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef OUTCACHE_H_
+#define OUTCACHE_H_
+
+#include "parser.h"
+
+#include <limits.h>
+
+/*The most environment variables a key may be made of.*/
+#define OUTCACHE_MAX_ENV 16
+
+/*The size limit of the cache if $MISH_CACHE_LIMIT is not set.*/
+#define OUTCACHE_DEFAULT_LIMIT (64L << 20)
+
+typedef struct outcache_spec{
+	const char *env[OUTCACHE_MAX_ENV];	//The names given with -e.
+	int number_of_env;
+}outcache_spec;
+
+/*A pipeline looked up in the cache, and its output while it runs.*/
+typedef struct outcache_entry{
+	char path[PATH_MAX];	//The file of the entry.
+	char tmp_path[PATH_MAX];	//The file the entry is written to.
+	int in_fd;	//The stdin of the pipeline, or -1 to keep it.
+	int out_fd;	//The stdout of the pipeline.
+	int err_fd;	//The stderr of the pipeline.
+}outcache_entry;
+
+/**
+ * outcache_parse() - Parses the options of the cache prefix.
+ *
+ * @param spec The options to fill in.
+ * @param argc The number of words, starting with "cache".
+ * @param argv The words.
+ * @return The number of words used by the prefix, or -1 on a bad option.
+ */
+int outcache_parse(outcache_spec *spec, int argc, char **argv);
+
+/**
+ * outcache_open() - Makes the key of a pipeline and finds the file of its
+ * entry.
+ *
+ * @param entry The entry to fill in.
+ * @param spec The options of the prefix.
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @return 0 on success or -1 if the pipeline can not be cached.
+ */
+int outcache_open(outcache_entry *entry, const outcache_spec *spec, \
+		command *command_array, int number_of_commands);
+
+/**
+ * outcache_replay() - Writes the stored output of an entry to the stdout
+ * and stderr of the shell and marks the entry as used.
+ *
+ * @param entry The entry.
+ * @param status Set to the stored exit status.
+ * @return 0 if the entry was replayed or -1 if it is not stored.
+ */
+int outcache_replay(outcache_entry *entry, int *status);
+
+/**
+ * outcache_begin() - Opens the files the output of the pipeline is written
+ * to while it runs.
+ *
+ * @param entry The entry, the fds of the pipeline are set in it.
+ * @return 0 on success or -1 on failure.
+ */
+int outcache_begin(outcache_entry *entry);
+
+/**
+ * outcache_finish() - Writes the output of a pipeline which has run to the
+ * stdout and stderr of the shell and stores it if asked to.
+ *
+ * @param entry The entry.
+ * @param status The exit status of the pipeline.
+ * @param store 1 if the entry is stored, else 0.
+ */
+void outcache_finish(outcache_entry *entry, int status, int store);
+
+#endif /* OUTCACHE_H_ */
@@ -30,9 +30,55 @@
  * What?	Missing command after last pipe is now recognized as an error
  *		and makes the parer return zero, in agreement with the function
  * 		header.
+ * **********
+ * Modified by: Bram Coenen
+ * Date:	2026-10-18
+ * What?	Added & for running pipelines concurrently. The separator
+ *		after each command is stored in the command.
+ *
+ * Date:	2026-10-18
+ * What?	Added ; for running pipelines in sequence and && and || for
+ *		running a pipeline depending on the status of the previous one.
+ *
+ * Date:	2026-10-18
+ * What?	A $( ... ) in a word is kept in the word up to its closing
+ *		parenthesis, with its spaces and punctuation, for command
+ *		substitution.
+ *
+ * Date:	2026-10-18
+ * What?	Added parse_r() which parses into buffers given by the
+ *		caller, parse() uses it with static buffers.
+ *
+ * Date:	2026-10-18
+ * What?	Added |+ which gives the output of the commands before it
+ *		to the commands after it too, like a pipe.
+ *
+ * Date:	2026-10-18
+ * What?	( and ) are words of their own for grouping. A ) ends the
+ *		command before it like a ; does, so it starts a command.
+ *
+ * Date:	2026-10-18
+ * What?	Added quoting with '...', "..." and \. The words are split in
+ *		one pass in the line itself by parse_in_place(), only words
+ *		with quotes or escapes are moved. Operators are words of
+ *		their own in a table, so a quoted | is an ordinary word.
+ *
+ * Date:	2026-10-18
+ * What?	parse_in_place() takes flags, with PARSE_QUIET the syntax
+ *		errors are not printed.
+ *
+ * Date:	2026-10-18
+ * What?	The quotes and escapes are turned into the QUOTE_ bytes where
+ *		they are, so no word is moved. With PARSE_KEEP_QUOTES they are
+ *		kept for the shell, which substitutes in what is not quoted and
+ *		removes them, else they are removed from the words here.
+ *
+ * Date:	2026-10-18
+ * What?	internal is reset to 0, the launch core reads it.
  */
 
 #include <ctype.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -40,12 +86,35 @@
 
 #include "parser.h"
 
-static char newline[MAXLINELEN];
-static char *words[MAXWORDS];
+/* Characters which are words of their own */
+#define PUNCTUATION "|<>&;"
+#define GROUPING "()"
+
+/* Characters which end a run of ordinary characters in a word */
+#define WORD_STOPS " \t\n\v\f\r|<>&;()'\"\\$"
+
+/* Characters which \ escapes between " and " */
+#define DOUBLE_ESCAPES "\"\\$`"
 
+/* The words of the operators, which the words of a line point to */
+static char operators[][3] = {"|", "|+", "||", "&", "&&", ";", "<", ">",
+	"(", ")"};
+#define NUMBER_OF_OPERATORS ((int)(sizeof(operators) / sizeof(operators[0])))
 
-/* parse() parses a command line with commands separated with pipe (|)
- * symbols
+static char static_newline[PARSE_TEXT_LEN];
+static char *static_words[MAXWORDS];
+
+static char *operator_word(const char *op);
+static int is_operator(const char *word, const char *op);
+static int is_punctuation(const char *word);
+static char *lex_word(char *lp, int *quoted, int flags);
+static char *lex_substitution(char *lp, int flags);
+static void remove_quotes(char *word);
+static void report(int flags, const char *format, ...);
+
+
+/* parse() parses a command line with commands separated with pipe (|),
+ * fan-out (|+), ampersand (&), semicolon (;), and (&&) or or (||) symbols
  * For each command optional input and output redirection files
  * are located.
  * parse() puts the commands in the array comLine and returns
@@ -53,53 +122,118 @@ static char *words[MAXWORDS];
  * If a syntax error occured parse() prints an error message and returns 0
  *
  * The commands have the syntax
- * command [args ...] [< path] [> path] | command ...
+ * command [args ...] [< path] [> path] | command ... [|+ command ...]
+ *	[&& command ...]
+ *	[|| command ...] [& command ...] [; command ...] [&|;]
+ *
+ * Characters between '...' are taken as they are and between "..." too,
+ * except that \ escapes ", \, $ and `. Outside quotes \ escapes any
+ * character. Quoted characters and escaped characters are part of a word,
+ * also spaces and operators. The quotes and escapes are removed from the
+ * words.
  *
  * This function assumes that comLine[] is big enough, i.e. declared to contain
  * MAXCOMMANDS commands.
  */
 int parse(const char *line, command comLine[])
 {
-	const char *lp;
-	char *nlp;
+	return parse_r(line, comLine, static_newline, static_words);
+}
+
+/* parse_r() works like parse() but copies the line to the buffer newline,
+ * PARSE_TEXT_LEN characters long, and puts the words in words, MAXWORDS
+ * pointers long, so it keeps no state of its own.
+ */
+int parse_r(const char *line, command comLine[], char *newline, char *words[])
+{
+	size_t len = strlen(line);
+
+	if (len >= PARSE_TEXT_LEN) {
+		fprintf(stderr, "Line too long.\n");
+		return 0;
+	}
+	memcpy(newline, line, len + 1);
+	return parse_in_place(newline, comLine, words, 0);
+}
+
+/* parse_in_place() works like parse() but splits the words in the line
+ * itself, which is changed. Every word is ended where it is, its quotes and
+ * escapes are turned into QUOTE_ bytes in their places. Only a word which
+ * has them is moved together over them, unless flags has PARSE_KEEP_QUOTES.
+ * Operators point to words of their own, so a character after a word can be
+ * overwritten by its end. With PARSE_QUIET in flags a syntax error only
+ * returns 0.
+ */
+int parse_in_place(char *line, command comLine[], char *words[], int flags)
+{
+	char *lp;
+	char next = '\0';	/* The character an ended word overwrote */
+	int quoted;
 	int wordc = 0, comc = 0, i;
 
-	/* Split command line in words and put in array newline
-	 * Also build array of pointers to words
-	 */
+	/* The QUOTE_ bytes can only come from quotes */
+	if (strpbrk(line, QUOTE_BYTES) != NULL) {
+		report(flags, "Invalid character in command.\n");
+		return 0;
+	}
+
+	/* Split command line in words and build array of pointers to words */
 	lp = line;
-	nlp = newline;
 	wordc = 0;
-	words[wordc] = nlp;
-	while (*lp != '\0') {
+	while (next != '\0' || *lp != '\0') {
 #ifndef ORIGINAL
 		if (wordc == MAXWORDS-1) {
-			fprintf(stderr, "Too many words in command.\n");
+			report(flags, "Too many words in command.\n");
 			return 0;
 		}
 #endif
-		/* Skip leading whitespace */
-		while (isspace((int)*lp))
-			lp++;
+		char c = next;
+		next = '\0';
+		if (c == '\0') {
+			/* Skip leading whitespace */
+			while (isspace((int)*lp))
+				lp++;
+			c = *lp;
+		}
 
-		if (!*lp)
+		if (c == '\0')
 			break;
 
-		if (strchr("|<>", *lp)) {
-			/* Found punctuation character */
-			*nlp++ = *lp++;
-			*nlp++ = '\0';
-			wordc++;
-			words[wordc] = nlp;
+		if (strchr(GROUPING, c)) {
+			/* Put a ; before a ) which does not follow a separator */
+			if (c == ')' && wordc > 0 && !is_punctuation(words[wordc-1])) {
+				if (wordc == MAXWORDS-2) {
+					report(flags, "Too many words in command.\n");
+					return 0;
+				}
+				words[wordc++] = operator_word(";");
+			}
+			words[wordc++] = operator_word(c == '(' ? "(" : ")");
+			lp++;
+		} else if (strchr(PUNCTUATION, c)) {
+			/* Found punctuation character, &&, || and |+ are one word */
+			char op[3] = {c, '\0', '\0'};
+			if (((c == '&' || c == '|') && lp[1] == c) ||
+					(c == '|' && lp[1] == '+'))
+				op[1] = lp[1];
+			lp += strlen(op);
+			words[wordc++] = operator_word(op);
 		} else {
-			/* Found a word; copy to delimiter */
-			while (!isspace((int)*lp) && !strchr("|<>", *lp))
-				*nlp++ = *lp++;
-
-			/* End word */
-			*nlp++ = '\0';
-			wordc++;
-			words[wordc] = nlp;
+			/* Found a word; mark its quotes up to delimiter */
+			words[wordc++] = lp;
+			lp = lex_word(lp, &quoted, flags);
+			if (lp == NULL)
+				return 0;
+
+			/* End word, keep the operator its end overwrites */
+			if (isspace((int)*lp))
+				*lp++ = '\0';
+			else {
+				next = *lp;
+				*lp = '\0';
+			}
+			if (quoted && !(flags & PARSE_KEEP_QUOTES))
+				remove_quotes(words[wordc-1]);
 		}
 	}
 
@@ -109,6 +243,8 @@ int parse(const char *line, command comLine[])
 		comLine[i].argc = 0;
 		comLine[i].infile = NULL;
 		comLine[i].outfile = NULL;
+		comLine[i].internal = 0;
+		comLine[i].separator = SEP_END;
 	}
 
 	words[wordc] = NULL;
@@ -120,33 +256,60 @@ int parse(const char *line, command comLine[])
 		}
 #ifndef ORIGINAL
 		/* the altered code by Tomas */
-		else if ((!strcmp(words[i], "<")) && (i+1 < wordc)) {
-			if (strchr("|<>", *words[i+1])) {
-				fprintf(stderr, "Missing name for redirect.\n");
+		else if ((is_operator(words[i], "<")) && (i+1 < wordc)) {
+			if (is_punctuation(words[i+1])) {
+				report(flags, "Missing name for redirect.\n");
 				return 0;
 			} else {
 				words[i] = NULL;
 				comLine[comc].infile = words[++i];
 			}
-		} else if ((!strcmp(words[i], ">")) && (i+1 < wordc)) {
-			if (strchr("|<>", *words[i+1])) {
-				fprintf(stderr, "Missing name for redirect.\n");
+		} else if ((is_operator(words[i], ">")) && (i+1 < wordc)) {
+			if (is_punctuation(words[i+1])) {
+				report(flags, "Missing name for redirect.\n");
 				return 0;
 			} else {
 				words[i] = NULL;
 				comLine[comc].outfile = words[++i];
 			}
-		} else if (!strcmp(words[i], "|")) {
-			if ((i+1 < wordc) && strchr("|<>", *words[i+1])) {
-				fprintf(stderr, "Invalid null command.\n");
+		} else if (is_operator(words[i], "|") ||
+				is_operator(words[i], "|+")) {
+			if ((i+1 < wordc) && is_punctuation(words[i+1])) {
+				report(flags, "Invalid null command.\n");
 				return 0;
 			} else {
+				comLine[comc].separator =
+					words[i][1] == '+' ? SEP_FANOUT : SEP_PIPE;
 				words[i] = NULL;
 				comc++;
 			}
-		} else if (((!strcmp(words[i], "<")) ||
-				(!strcmp(words[i], ">"))) && (i == wordc-1)) {
-			fprintf(stderr, "Missing name for redirect.\n");
+		} else if (is_operator(words[i], "&&") ||
+				is_operator(words[i], "||")) {
+			if ((i+1 < wordc) && is_punctuation(words[i+1])) {
+				report(flags, "Invalid null command.\n");
+				return 0;
+			} else {
+				comLine[comc].separator =
+					(*words[i] == '&') ? SEP_AND : SEP_OR;
+				words[i] = NULL;
+				comc++;
+			}
+		} else if (is_operator(words[i], "&") ||
+				is_operator(words[i], ";")) {
+			if ((i+1 < wordc) && is_punctuation(words[i+1])) {
+				report(flags, "Invalid null command.\n");
+				return 0;
+			} else {
+				comLine[comc].separator =
+					(*words[i] == '&') ? SEP_ASYNC : SEP_SEQ;
+				words[i] = NULL;
+				/* A trailing & or ; ends the line like the last word */
+				if (i != wordc-1)
+					comc++;
+			}
+		} else if (((is_operator(words[i], "<")) ||
+				(is_operator(words[i], ">"))) && (i == wordc-1)) {
+			report(flags, "Missing name for redirect.\n");
 			return 0;
 		}
 #else
@@ -164,7 +327,7 @@ int parse(const char *line, command comLine[])
 #endif
 		else {
 			if (comLine[comc].infile || comLine[comc].outfile) {
-				fprintf(stderr, "Extra characters after "
+				report(flags, "Extra characters after "
 						"command: %s\n",
 						words[i]);
 				return 0;
@@ -178,9 +341,180 @@ int parse(const char *line, command comLine[])
 
 	if(comc>0 && comLine[comc-1].argv==NULL)
 	{
-		fprintf(stderr, "Invalid null command.\n");
+		report(flags, "Invalid null command.\n");
 		comc = 0;
 	}
 
 	return comc;
 }
+
+/* operator_word() returns the word of the operator op in the table */
+static char *operator_word(const char *op)
+{
+	int i;
+
+	for (i = 0; i < NUMBER_OF_OPERATORS - 1; i++)
+		if (!strcmp(operators[i], op))
+			break;
+	return operators[i];
+}
+
+/* is_operator() checks if a word is the operator op, not just a word with
+ * the same characters. With op NULL any operator is accepted.
+ */
+static int is_operator(const char *word, const char *op)
+{
+	for (int i = 0; i < NUMBER_OF_OPERATORS; i++)
+		if (word == operators[i])
+			return op == NULL || !strcmp(word, op);
+	return 0;
+}
+
+/* is_punctuation() checks if a word is an operator other than ( and ) */
+static int is_punctuation(const char *word)
+{
+	return is_operator(word, NULL) && strchr(PUNCTUATION, *word);
+}
+
+/* lex_word() reads a word starting at lp up to an unquoted space or
+ * operator. Runs of ordinary characters are skipped with strcspn(). The
+ * quotes are turned into QUOTE_SINGLE and QUOTE_DOUBLE and the backslash of
+ * an escape into QUOTE_ESCAPE where they are, so nothing in the line moves.
+ * lex_word() returns the delimiter after the word and sets quoted if the
+ * word has quotes or escapes, or returns NULL if a quote is not closed.
+ */
+static char *lex_word(char *lp, int *quoted, int flags)
+{
+	*quoted = 0;
+	while (1) {
+		lp += strcspn(lp, WORD_STOPS);
+
+		if (*lp == '\'') {
+			/* Everything up to the next ' is taken as it is */
+			char *close = strchr(lp + 1, '\'');
+			if (close == NULL) {
+				report(flags, "Missing closing '.\n");
+				return NULL;
+			}
+			*lp = QUOTE_SINGLE;
+			*close = QUOTE_SINGLE;
+			lp = close + 1;
+			*quoted = 1;
+		} else if (*lp == '"') {
+			/* Only \ escapes ", \, $ and ` between " and " */
+			*lp++ = QUOTE_DOUBLE;
+			while (*lp != '"') {
+				if (*lp == '\0') {
+					report(flags, "Missing closing \".\n");
+					return NULL;
+				} else if (*lp == '$' && lp[1] == '(') {
+					lp = lex_substitution(lp, flags);
+					if (lp == NULL)
+						return NULL;
+				} else if (*lp == '\\' && lp[1] != '\0' &&
+						strchr(DOUBLE_ESCAPES, lp[1])) {
+					*lp = QUOTE_ESCAPE;
+					lp += 2;
+				} else
+					lp++;
+			}
+			*lp++ = QUOTE_DOUBLE;
+			*quoted = 1;
+		} else if (*lp == '\\') {
+			/* An escaped character, a \ at the end is kept */
+			if (lp[1] != '\0') {
+				*lp++ = QUOTE_ESCAPE;
+				*quoted = 1;
+			}
+			lp++;
+		} else if (*lp == '$' && lp[1] == '(') {
+			lp = lex_substitution(lp, flags);
+			if (lp == NULL)
+				return NULL;
+		} else if (*lp == '$') {
+			lp++;
+		} else {
+			/* A space, an operator or the end of the line */
+			return lp;
+		}
+	}
+}
+
+/* lex_substitution() skips a $( ... ) whole, with its spaces, operators and
+ * quotes, which are split when its line is run. A ) in quotes does not close
+ * it. lex_substitution() returns the character after the closing ), or NULL
+ * if it is missing.
+ */
+static char *lex_substitution(char *lp, int flags)
+{
+	int depth = 0;
+	char quote = '\0';
+
+	lp++;
+	do {
+		if (*lp == '\0') {
+			report(flags, "Missing ) in command substitution.\n");
+			return NULL;
+		}
+		if (quote != '\0') {
+			if (*lp == quote)
+				quote = '\0';
+			else if (*lp == '\\' && quote == '"' && lp[1] != '\0')
+				lp++;
+		} else if (*lp == '\'' || *lp == '"')
+			quote = *lp;
+		else if (*lp == '\\' && lp[1] != '\0')
+			lp++;
+		else if (*lp == '(')
+			depth++;
+		else if (*lp == ')')
+			depth--;
+		lp++;
+	} while (depth > 0);
+	return lp;
+}
+
+/* remove_quotes() removes the QUOTE_ bytes from a word, moving the rest of
+ * the word back over them. The character after a QUOTE_ESCAPE is kept.
+ */
+static void remove_quotes(char *word)
+{
+	char *out = word;
+
+	for (; *word != '\0'; word++) {
+		if (*word == QUOTE_SINGLE || *word == QUOTE_DOUBLE)
+			continue;
+		if (*word == QUOTE_ESCAPE)
+			word++;
+		*out++ = *word;
+	}
+	*out = '\0';
+}
+
+/* word_is() checks if a word with its quotes kept is text when its quotes
+ * are removed, so "cd" and \cd are cd too.
+ */
+int word_is(const char *word, const char *text)
+{
+	for (; *word != '\0'; word++) {
+		if (*word == QUOTE_SINGLE || *word == QUOTE_DOUBLE)
+			continue;
+		if (*word == QUOTE_ESCAPE)
+			word++;
+		if (*word != *text++)
+			return 0;
+	}
+	return *text == '\0';
+}
+
+/* report() prints a syntax error like fprintf() unless flags has PARSE_QUIET */
+static void report(int flags, const char *format, ...)
+{
+	va_list args;
+
+	if (flags & PARSE_QUIET)
+		return;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+}
@@ -12,6 +12,26 @@
  *
  * Date:	1999-08-01
  * What?	Changed comments a bit more
+ *
+ * Modified by: Bram Coenen
+ * Date:	2026-10-18
+ * What?	Added parse_r() which uses buffers given by the caller
+ *
+ * Date:	2026-10-18
+ * What?	( and ) are words of their own
+ *
+ * Date:	2026-10-18
+ * What?	Added quoting and parse_in_place() which splits the words in the
+ *		line itself
+ *
+ * Date:	2026-10-18
+ * What?	Added the flags of parse_in_place()
+ *
+ * Date:	2026-10-18
+ * What?	Added PARSE_KEEP_QUOTES, the QUOTE_ bytes and word_is()
+ *
+ * Date:	2026-10-18
+ * What?	internal is reset by the parser
  */
 
 /* command describes a parsed command.
@@ -21,8 +41,10 @@
  *  (NULL if N/A)
  * outfile is the name of the file to which output should be redirected
  *  (NULL if N/A)
- * internal is a field which is not used by the parser, but which
- *  can be used to indicate that the command is an internal command
+ * internal is set to 0 by the parser, but can be set to indicate
+ *  that the command is an internal command, see launch.h
+ * separator tells what follows the command on the line, one of the SEP_
+ *  constants below
  */
 typedef struct command_t
 {
@@ -31,12 +53,60 @@ typedef struct command_t
 	char *infile;
 	char *outfile;
 	int internal;
+	int separator;
 } command;
 
+/* Separators between commands */
+#define SEP_END		0	/* last command on the line */
+#define SEP_PIPE	1	/* | */
+#define SEP_ASYNC	2	/* & */
+#define SEP_SEQ		3	/* ; */
+#define SEP_AND		4	/* && */
+#define SEP_OR		5	/* || */
+#define SEP_FANOUT	6	/* |+ */
+
 #define MAXWORDS	(1024)
 #define MAXCOMMANDS	(MAXWORDS / 2 + 1)
 #define MAXLINELEN	MAXWORDS
 
+/* Room for the copy of a line which parse_r() splits the words in */
+#define PARSE_TEXT_LEN	(MAXLINELEN + 1)
+
+/* Flags of parse_in_place() */
+#define PARSE_QUIET		1	/* syntax errors are not printed */
+#define PARSE_KEEP_QUOTES	2	/* the QUOTE_ bytes are kept in the words */
+
+/* The bytes which the quotes and escapes of a word are turned into. Only
+ * parse_in_place() with PARSE_KEEP_QUOTES leaves them in the words, so the
+ * shell knows what was quoted. A line which has them is a syntax error.
+ * Between two QUOTE_SINGLE everything is quoted, between two QUOTE_DOUBLE
+ * everything but $ is, and the character after a QUOTE_ESCAPE is. A \ which
+ * is left is an ordinary character. The text of a $( ... ) is left as it
+ * was, with its quotes, since it is parsed when it is run.
+ */
+#define QUOTE_SINGLE	'\001'	/* '...' */
+#define QUOTE_DOUBLE	'\002'	/* "..." */
+#define QUOTE_ESCAPE	'\003'	/* \ */
+#define QUOTE_BYTES	"\001\002\003"
+
 int parse(const char *line, command comLine[]);
 
+/* parse_r() is parse() with the buffers given by the caller, so it can be
+ * called from many threads at once. text must hold PARSE_TEXT_LEN characters
+ * and words MAXWORDS pointers. The commands point into them.
+ */
+int parse_r(const char *line, command comLine[], char *text, char *words[]);
+
+/* parse_in_place() is parse() without a copy of the line. The words are split
+ * in the line itself, which must be writable and is changed, and words must
+ * hold MAXWORDS pointers. The commands point into the line. flags is 0 or
+ * PARSE_QUIET and PARSE_KEEP_QUOTES or'ed together.
+ */
+int parse_in_place(char *line, command comLine[], char *words[], int flags);
+
+/* word_is() checks if a word with its quotes kept is text when its quotes are
+ * removed.
+ */
+int word_is(const char *word, const char *text);
+
 #endif
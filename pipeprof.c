@@ -0,0 +1,489 @@
+/*
+ * pipeprof.c Is the source code for the pipeprof prefix of mish. See the
+ * header file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "pipeprof.h"
+#include "timeout.h"
+#include "stats.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+/* Defines */
+#define PIPEPROF_USAGE "Usage: pipeprof [-i INTERVAL] pipeline\n"
+#define PIPEPROF_NAME_LEN 32
+#define STAT_PATH_LEN 64
+#define STAT_READ_SIZE 1024
+#define NSEC_PER_USEC 1000L
+#define NSEC_PER_SEC 1000000000L
+
+/*A stage of the profiled pipeline and what its samples have shown.*/
+typedef struct profiled_stage{
+	pid_t pid;	//0 until the stage is forked.
+	char name[PIPEPROF_NAME_LEN];
+	uint64_t cpu;	//Nanoseconds of user and system time.
+	uint64_t ended;	//When the stage was reaped, 0 while it runs.
+	int samples;	//The samples which found the stage.
+	int running;	//The samples which found it running.
+	int blocked;	//The samples which found it sleeping.
+}profiled_stage;
+
+/*A pipe from a stage to the next one and what its samples have shown.*/
+typedef struct profiled_pipe{
+	int fd;		//A copy of the read end, -1 when closed.
+	int capacity;	//The size of the pipe in bytes.
+	int samples;
+	int full;	//The samples with less than PIPE_BUF bytes free.
+	int empty;	//The samples with no bytes in the pipe.
+	uint64_t bytes;	//The summed bytes of the samples.
+}profiled_pipe;
+
+struct profiler{
+	int timer_fd;
+	struct timespec interval;
+	uint64_t started;
+	long clock_ticks;	//Clock ticks of /proc/PID/stat per second.
+	int number_of_samples;
+	int number_of_stages;
+	profiled_stage *stages;
+	profiled_pipe *pipes;	//One less than the stages.
+};
+
+/*Function prototypes.*/
+static void sample(profiler *p);
+static void sample_stage(profiler *p, profiled_stage *stage);
+static void sample_pipe(profiled_pipe *pipe);
+static int find_bottleneck(const profiler *p);
+static double stage_utilization(const profiler *p, int stage);
+static double share(int count, int samples);
+static uint64_t timeval_nsec(const struct timeval *tv);
+
+
+/**
+ * pipeprof_parse() - Parses the options of the pipeprof prefix.
+ *
+ * @param spec The options to fill in.
+ * @param argc The number of words, starting with "pipeprof".
+ * @param argv The words.
+ * @return The number of words used by the prefix, or -1 on a bad option.
+ */
+int pipeprof_parse(pipeprof_spec *spec, int argc, char **argv){
+	spec->interval.tv_sec = 0;
+	spec->interval.tv_nsec = PIPEPROF_DEFAULT_INTERVAL_MS * 1000000L;
+
+	int opt;
+	optind = 0;
+	while((opt = getopt(argc, argv, "+i:")) != -1){
+		switch(opt){
+		case 'i':
+			if(parse_duration(optarg, &spec->interval) < 0 || \
+					(spec->interval.tv_sec == 0 && \
+					spec->interval.tv_nsec == 0)){
+				fprintf(stderr, "pipeprof: bad interval: %s\n", optarg);
+				return -1;
+			}
+			break;
+		default:
+			fprintf(stderr, PIPEPROF_USAGE);
+			return -1;
+		}
+	}
+
+	if(optind >= argc){
+		fprintf(stderr, PIPEPROF_USAGE);
+		return -1;
+	}
+	return optind;
+}
+
+/**
+ * pipeprof_start() - Creates a profiler for a pipeline and adds its sampling
+ * timer to the wait loop.
+ *
+ * @param spec The options of the prefix.
+ * @param number_of_stages The number of commands in the pipeline.
+ * @param epoll_fd The epoll file descriptor of the wait loop.
+ * @return The profiler or NULL on failure.
+ */
+profiler *pipeprof_start(const pipeprof_spec *spec, int number_of_stages, \
+		int epoll_fd){
+	profiler *p = malloc(sizeof(*p));
+	profiled_stage *stages = calloc(number_of_stages, sizeof(*stages));
+	profiled_pipe *pipes = calloc(number_of_stages, sizeof(*pipes));
+	if(p == NULL || stages == NULL || pipes == NULL){
+		perror("pipeprof.c");
+		exit(errno);
+	}
+	for(int i = 0; i < number_of_stages; i++){
+		pipes[i].fd = -1;
+	}
+	p->stages = stages;
+	p->pipes = pipes;
+	p->number_of_stages = number_of_stages;
+	p->number_of_samples = 0;
+	p->interval = spec->interval;
+	p->clock_ticks = sysconf(_SC_CLK_TCK);
+	p->started = stats_now();
+
+	p->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(p->timer_fd < 0){
+		perror("pipeprof");
+		pipeprof_stop(p);
+		return NULL;
+	}
+	struct itimerspec timer = {spec->interval, spec->interval};
+	if(timerfd_settime(p->timer_fd, 0, &timer, NULL) < 0){
+		perror("pipeprof timerfd_settime");
+		pipeprof_stop(p);
+		return NULL;
+	}
+
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = p->timer_fd;
+	if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, p->timer_fd, &event) < 0){
+		perror("pipeprof epoll_ctl");
+		pipeprof_stop(p);
+		return NULL;
+	}
+	return p;
+}
+
+/**
+ * pipeprof_add_stage() - Adds a forked stage of the pipeline.
+ *
+ * @param p The profiler.
+ * @param stage The index of the stage in the pipeline.
+ * @param pid The pid of the stage.
+ * @param name The command the stage runs.
+ */
+void pipeprof_add_stage(profiler *p, int stage, pid_t pid, const char *name){
+	if(stage < 0 || stage >= p->number_of_stages){
+		return;
+	}
+	p->stages[stage].pid = pid;
+	snprintf(p->stages[stage].name, PIPEPROF_NAME_LEN, "%s", name);
+}
+
+/**
+ * pipeprof_add_pipe() - Adds the pipe from a stage to the next one. The
+ * profiler keeps a copy of the read end, so the caller may close its own once
+ * the next stage is forked.
+ *
+ * @param p The profiler.
+ * @param stage The index of the stage writing to the pipe.
+ * @param read_fd The read end of the pipe.
+ */
+void pipeprof_add_pipe(profiler *p, int stage, int read_fd){
+	if(stage < 0 || stage >= p->number_of_stages-1){
+		return;
+	}
+	profiled_pipe *pipe = &p->pipes[stage];
+	pipe->fd = fcntl(read_fd, F_DUPFD_CLOEXEC, 0);
+	if(pipe->fd < 0){
+		perror("pipeprof");
+		return;
+	}
+	pipe->capacity = fcntl(pipe->fd, F_GETPIPE_SZ);
+}
+
+/**
+ * pipeprof_forget() - Closes the file descriptors of the profiler in a forked
+ * child, which must not keep the pipes open.
+ *
+ * @param p The profiler.
+ */
+void pipeprof_forget(profiler *p){
+	for(int i = 0; i < p->number_of_stages; i++){
+		if(p->pipes[i].fd >= 0){
+			close(p->pipes[i].fd);
+		}
+	}
+	close(p->timer_fd);
+}
+
+/**
+ * pipeprof_handle() - Handles a file descriptor which the wait loop found
+ * ready, if it is the timer of the profiler, by taking a sample.
+ *
+ * @param p The profiler.
+ * @param fd The ready file descriptor.
+ * @return 1 if the file descriptor belongs to the profiler, else 0.
+ */
+int pipeprof_handle(profiler *p, int fd){
+	if(fd != p->timer_fd){
+		return 0;
+	}
+	uint64_t expirations;
+	if(read(fd, &expirations, sizeof(expirations)) > 0){
+		sample(p);
+	}
+	return 1;
+}
+
+/**
+ * pipeprof_reaped() - Records the CPU time of a reaped stage and closes the
+ * copy of the pipe it read from.
+ *
+ * @param p The profiler.
+ * @param pid The pid of the reaped child, which may not be a stage.
+ * @param usage The resource usage of the child.
+ */
+void pipeprof_reaped(profiler *p, pid_t pid, const struct rusage *usage){
+	for(int i = 0; i < p->number_of_stages; i++){
+		profiled_stage *stage = &p->stages[i];
+		if(stage->pid != pid || stage->ended != 0){
+			continue;
+		}
+		stage->cpu = timeval_nsec(&usage->ru_utime) + \
+				timeval_nsec(&usage->ru_stime);
+		stage->ended = stats_now();
+		//Nobody reads the pipe anymore, its writer must get SIGPIPE.
+		if(i > 0 && p->pipes[i-1].fd >= 0){
+			close(p->pipes[i-1].fd);
+			p->pipes[i-1].fd = -1;
+		}
+		return;
+	}
+}
+
+/**
+ * pipeprof_report() - Prints the utilization of the stages, the fill of the
+ * pipes and the bottleneck to stderr.
+ *
+ * @param p The profiler.
+ */
+void pipeprof_report(profiler *p){
+	char interval[STATS_TIME_TEXT_LEN];
+	char wall[STATS_TIME_TEXT_LEN];
+	stats_format_time(interval, p->interval.tv_sec * NSEC_PER_SEC + \
+			p->interval.tv_nsec);
+	stats_format_time(wall, stats_now() - p->started);
+	fprintf(stderr, "pipeprof: %d stages, %d samples every %s over %s\n", \
+			p->number_of_stages, p->number_of_samples, interval, wall);
+
+	fprintf(stderr, "%-8s%-16s%10s%10s%10s%10s\n", "stage", "command", \
+			"cpu", "util", "running", "blocked");
+	for(int i = 0; i < p->number_of_stages; i++){
+		const profiled_stage *stage = &p->stages[i];
+		char cpu[STATS_TIME_TEXT_LEN];
+		stats_format_time(cpu, stage->cpu);
+		fprintf(stderr, "%-8d%-16s%10s%9.1f%%%9.1f%%%9.1f%%\n", i, \
+				stage->name, cpu, 100 * stage_utilization(p, i), \
+				100 * share(stage->running, stage->samples), \
+				100 * share(stage->blocked, stage->samples));
+	}
+
+	if(p->number_of_stages > 1){
+		fprintf(stderr, "%-8s%-16s%10s%10s%10s\n", "pipe", "", "fill", \
+				"full", "empty");
+	}
+	for(int i = 0; i < p->number_of_stages-1; i++){
+		const profiled_pipe *pipe = &p->pipes[i];
+		char between[PIPEPROF_NAME_LEN];
+		snprintf(between, sizeof(between), "%d -> %d", i, i+1);
+		double fill = pipe->samples == 0 || pipe->capacity <= 0 ? 0 : \
+				(double)pipe->bytes / pipe->samples / pipe->capacity;
+		fprintf(stderr, "%-24s%9.1f%%%9.1f%%%9.1f%%\n", between, 100 * fill, \
+				100 * share(pipe->full, pipe->samples), \
+				100 * share(pipe->empty, pipe->samples));
+	}
+
+	int bottleneck = find_bottleneck(p);
+	if(bottleneck < 0){
+		fprintf(stderr, "bottleneck: none found, no pipe was seen full or "
+				"empty\n");
+		return;
+	}
+	fprintf(stderr, "bottleneck: stage %d (%s)\n", bottleneck, \
+			p->stages[bottleneck].name);
+}
+
+/**
+ * pipeprof_stop() - Closes the file descriptors of the profiler and frees it.
+ * Closing the timer also removes it from the wait loop.
+ *
+ * @param p The profiler.
+ */
+void pipeprof_stop(profiler *p){
+	for(int i = 0; i < p->number_of_stages; i++){
+		if(p->pipes[i].fd >= 0){
+			close(p->pipes[i].fd);
+		}
+	}
+	if(p->timer_fd >= 0){
+		close(p->timer_fd);
+	}
+	free(p->stages);
+	free(p->pipes);
+	free(p);
+}
+
+/**
+ * sample() - Takes a sample of every stage which runs and every pipe which
+ * is still read.
+ *
+ * @param p The profiler.
+ */
+static void sample(profiler *p){
+	p->number_of_samples++;
+	for(int i = 0; i < p->number_of_stages; i++){
+		if(p->stages[i].pid > 0 && p->stages[i].ended == 0){
+			sample_stage(p, &p->stages[i]);
+		}
+		if(p->pipes[i].fd >= 0){
+			sample_pipe(&p->pipes[i]);
+		}
+	}
+}
+
+/**
+ * sample_stage() - Reads the state and the CPU time of a stage from
+ * /proc/PID/stat. A stage which is sleeping waits for a pipe, a file or a
+ * timer, a stage which is runnable wants the CPU.
+ *
+ * @param p The profiler.
+ * @param stage The stage.
+ */
+static void sample_stage(profiler *p, profiled_stage *stage){
+	char path[STAT_PATH_LEN];
+	char buf[STAT_READ_SIZE];
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int)stage->pid);
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0){
+		return;
+	}
+	ssize_t len = read(fd, buf, sizeof(buf)-1);
+	close(fd);
+	if(len <= 0){
+		return;
+	}
+	buf[len] = '\0';
+
+	//The name in parentheses may hold spaces, the fields follow the last ).
+	char *fields = strrchr(buf, ')');
+	char state;
+	unsigned long user_ticks;
+	unsigned long system_ticks;
+	if(fields == NULL || sscanf(fields + 1, " %c %*d %*d %*d %*d %*d %*u " \
+			"%*u %*u %*u %*u %lu %lu", &state, &user_ticks, \
+			&system_ticks) != 3){
+		return;
+	}
+
+	stage->samples++;
+	if(state == 'R'){
+		stage->running++;
+	}
+	else if(state == 'S' || state == 'D'){
+		stage->blocked++;
+	}
+	if(p->clock_ticks > 0){
+		stage->cpu = (uint64_t)(user_ticks + system_ticks) * NSEC_PER_SEC / \
+				p->clock_ticks;
+	}
+}
+
+/**
+ * sample_pipe() - Reads how many bytes wait in a pipe.
+ *
+ * @param pipe The pipe.
+ */
+static void sample_pipe(profiled_pipe *pipe){
+	int bytes;
+	if(ioctl(pipe->fd, FIONREAD, &bytes) < 0){
+		return;
+	}
+	pipe->samples++;
+	pipe->bytes += bytes;
+	if(bytes == 0){
+		pipe->empty++;
+	}
+	else if(pipe->capacity > 0 && pipe->capacity - bytes < PIPE_BUF){
+		pipe->full++;
+	}
+}
+
+/**
+ * find_bottleneck() - Finds the stage which limits the pipeline. A pipe which
+ * sits full points after it and a pipe which sits empty points before it, so
+ * the bottleneck is the stage with the most full pipes before it and empty
+ * pipes after it. Equal stages are told apart by their utilization.
+ *
+ * @param p The profiler.
+ * @return The index of the stage, or -1 if no sample has seen a pipe full or
+ * empty, which says nothing about the stages.
+ */
+static int find_bottleneck(const profiler *p){
+	int best = 0;
+	double best_score = -1;
+	if(p->number_of_samples == 0){
+		return -1;
+	}
+	for(int i = 0; i < p->number_of_stages; i++){
+		double score = 0;
+		for(int j = 0; j < p->number_of_stages-1; j++){
+			const profiled_pipe *pipe = &p->pipes[j];
+			score += j < i ? share(pipe->full, pipe->samples) : \
+					share(pipe->empty, pipe->samples);
+		}
+		if(score > best_score || (score == best_score && \
+				stage_utilization(p, i) > stage_utilization(p, best))){
+			best = i;
+			best_score = score;
+		}
+	}
+	return best_score > 0 ? best : -1;
+}
+
+/**
+ * stage_utilization() - Gives the share of the time a stage ran which it
+ * spent on the CPU.
+ *
+ * @param p The profiler.
+ * @param stage The index of the stage.
+ * @return The utilization, 1 for a stage which used one CPU all the time.
+ */
+static double stage_utilization(const profiler *p, int stage){
+	uint64_t ended = p->stages[stage].ended;
+	uint64_t ran = (ended != 0 ? ended : stats_now()) - p->started;
+	return ran == 0 ? 0 : (double)p->stages[stage].cpu / ran;
+}
+
+/**
+ * share() - Gives the share of the samples which found something.
+ *
+ * @param count The samples which found it.
+ * @param samples All samples.
+ * @return The share, 0 without samples.
+ */
+static double share(int count, int samples){
+	return samples == 0 ? 0 : (double)count / samples;
+}
+
+/**
+ * timeval_nsec() - Converts a time of the resource usage to nanoseconds.
+ *
+ * @param tv The time.
+ * @return The time in nanoseconds.
+ */
+static uint64_t timeval_nsec(const struct timeval *tv){
+	return (uint64_t)tv->tv_sec * NSEC_PER_SEC + \
+			(uint64_t)tv->tv_usec * NSEC_PER_USEC;
+}
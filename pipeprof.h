@@ -0,0 +1,134 @@
+/*
+ * pipeprof.h Is the header file for the pipeprof prefix of mish, which finds
+ * the stage that limits the throughput of a pipeline:
+ *
+ *   pipeprof [-i INTERVAL] pipeline
+ *
+ * The pipeline is run once like any other. Every INTERVAL, a duration like
+ * "5ms", see parse_duration() in timeout.h, 10ms if -i is not given, the
+ * shell samples how many bytes wait in every pipe between two stages with
+ * FIONREAD and reads the state and the CPU time of every stage from
+ * /proc/PID/stat. The timer is waited on in the wait loop of the shell, so
+ * the pipeline runs without any extra process.
+ *
+ * To sample a pipe the shell keeps a copy of its read end, which is closed as
+ * soon as the stage reading from the pipe is reaped, so the stage writing to
+ * it still gets SIGPIPE. The CPU time of a stage is taken from wait4() when
+ * it is reaped.
+ *
+ * When the pipeline has ended, the utilization of every stage, its CPU time
+ * over the time it ran, and how often it was running or blocked is printed to
+ * stderr, together with how full every pipe was and how often it sat full,
+ * which means the stages after it are slow, or empty, which means the stages
+ * before it are slow. The bottleneck is the stage with full pipes before it
+ * and empty pipes after it. If no sample was taken or no pipe was seen full
+ * or empty, no bottleneck is named. A pipeline with "|+" can not be profiled.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef PIPEPROF_H_
+#define PIPEPROF_H_
+
+#include <time.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+
+/*The sampling interval if -i is not given.*/
+#define PIPEPROF_DEFAULT_INTERVAL_MS 10
+
+typedef struct pipeprof_spec{
+	struct timespec interval;
+}pipeprof_spec;
+
+typedef struct profiler profiler;
+
+/**
+ * pipeprof_parse() - Parses the options of the pipeprof prefix.
+ *
+ * @param spec The options to fill in.
+ * @param argc The number of words, starting with "pipeprof".
+ * @param argv The words.
+ * @return The number of words used by the prefix, or -1 on a bad option.
+ */
+int pipeprof_parse(pipeprof_spec *spec, int argc, char **argv);
+
+/**
+ * pipeprof_start() - Creates a profiler for a pipeline and adds its sampling
+ * timer to the wait loop.
+ *
+ * @param spec The options of the prefix.
+ * @param number_of_stages The number of commands in the pipeline.
+ * @param epoll_fd The epoll file descriptor of the wait loop.
+ * @return The profiler or NULL on failure.
+ */
+profiler *pipeprof_start(const pipeprof_spec *spec, int number_of_stages, \
+		int epoll_fd);
+
+/**
+ * pipeprof_add_stage() - Adds a forked stage of the pipeline.
+ *
+ * @param p The profiler.
+ * @param stage The index of the stage in the pipeline.
+ * @param pid The pid of the stage.
+ * @param name The command the stage runs.
+ */
+void pipeprof_add_stage(profiler *p, int stage, pid_t pid, const char *name);
+
+/**
+ * pipeprof_add_pipe() - Adds the pipe from a stage to the next one. The
+ * profiler keeps a copy of the read end, so the caller may close its own once
+ * the next stage is forked.
+ *
+ * @param p The profiler.
+ * @param stage The index of the stage writing to the pipe.
+ * @param read_fd The read end of the pipe.
+ */
+void pipeprof_add_pipe(profiler *p, int stage, int read_fd);
+
+/**
+ * pipeprof_forget() - Closes the file descriptors of the profiler in a forked
+ * child, which must not keep the pipes open.
+ *
+ * @param p The profiler.
+ */
+void pipeprof_forget(profiler *p);
+
+/**
+ * pipeprof_handle() - Handles a file descriptor which the wait loop found
+ * ready, if it is the timer of the profiler, by taking a sample.
+ *
+ * @param p The profiler.
+ * @param fd The ready file descriptor.
+ * @return 1 if the file descriptor belongs to the profiler, else 0.
+ */
+int pipeprof_handle(profiler *p, int fd);
+
+/**
+ * pipeprof_reaped() - Records the CPU time of a reaped stage and closes the
+ * copy of the pipe it read from.
+ *
+ * @param p The profiler.
+ * @param pid The pid of the reaped child, which may not be a stage.
+ * @param usage The resource usage of the child.
+ */
+void pipeprof_reaped(profiler *p, pid_t pid, const struct rusage *usage);
+
+/**
+ * pipeprof_report() - Prints the utilization of the stages, the fill of the
+ * pipes and the bottleneck to stderr.
+ *
+ * @param p The profiler.
+ */
+void pipeprof_report(profiler *p);
+
+/**
+ * pipeprof_stop() - Closes the file descriptors of the profiler and frees it.
+ * Closing the timer also removes it from the wait loop.
+ *
+ * @param p The profiler.
+ */
+void pipeprof_stop(profiler *p);
+
+#endif /* PIPEPROF_H_ */
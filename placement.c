@@ -0,0 +1,321 @@
+/*
+ * placement.c Is the source code for the CPU and scheduling placement of the
+ * commands in a pipeline. See the header file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "placement.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+/* Defines for ioprio_set(), which has no glibc wrapper */
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_CLASS_RT 1
+#define IOPRIO_CLASS_BE 2
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_MAX_LEVEL 7
+
+/*Function prototypes.*/
+static int parse_cpu_set(const char *text, cpu_set_t *set);
+static int parse_cpu_mask(const char *text, cpu_set_t *set);
+static int parse_ioprio(const char *text);
+static int nth_allowed_cpu(int n);
+
+/*Where the next round-robin placement starts, so jobs spread out.*/
+static int next_first_cpu = 0;
+
+
+/**
+ * placement_parse() - Parses the options of the pin prefix.
+ *
+ * @param p The placement to fill in.
+ * @param argc The number of words, starting with "pin".
+ * @param argv The words.
+ * @return The number of words used by pin and its options, or -1 on a bad
+ * option.
+ */
+int placement_parse(placement *p, int argc, char **argv){
+	memset(p, 0, sizeof(*p));
+	p->ioprio = -1;
+
+	int opt;
+	optind = 0;
+	while((opt = getopt(argc, argv, "+rpc:n:i:")) != -1){
+		switch(opt){
+		case 'r':
+			p->mode = PLACE_ROUND_ROBIN;
+			break;
+		case 'p':
+			p->mode = PLACE_PAIRS;
+			break;
+		case 'c':{
+			p->mode = PLACE_EXPLICIT;
+			p->number_of_sets = 0;
+			char *copy = strdup(optarg);
+			char *saveptr = NULL;
+			if(copy == NULL){
+				perror("pin");
+				return -1;
+			}
+			for(char *set = strtok_r(copy, ":", &saveptr); set != NULL;
+					set = strtok_r(NULL, ":", &saveptr)){
+				if(p->number_of_sets == PLACEMENT_MAX_SETS ||
+						parse_cpu_set(set, &p->sets[p->number_of_sets]) < 0){
+					fprintf(stderr, "pin: bad CPU set: %s\n", set);
+					free(copy);
+					return -1;
+				}
+				p->number_of_sets++;
+			}
+			free(copy);
+			if(p->number_of_sets == 0){
+				fprintf(stderr, "pin: no CPUs given\n");
+				return -1;
+			}
+			break;
+		}
+		case 'n':{
+			char *end;
+			errno = 0;
+			long nice_value = strtol(optarg, &end, 10);
+			if(errno != 0 || *end != '\0' || nice_value < -20 ||
+					nice_value > 19){
+				fprintf(stderr, "pin: bad nice value: %s\n", optarg);
+				return -1;
+			}
+			p->set_nice = 1;
+			p->nice = (int)nice_value;
+			break;
+		}
+		case 'i':
+			p->ioprio = parse_ioprio(optarg);
+			if(p->ioprio < 0){
+				fprintf(stderr, "pin: bad I/O priority: %s\n", optarg);
+				return -1;
+			}
+			break;
+		default:
+			fprintf(stderr, "Usage: pin [-r | -p | -c CPUS[:CPUS...]] "
+					"[-n NICE] [-i CLASS[:LEVEL]] pipeline\n");
+			return -1;
+		}
+	}
+
+	return optind;
+}
+
+/**
+ * placement_spread() - Gives a round-robin or pairs placement the CPU which
+ * its stage 0 is placed on. Every job which is started with such a placement
+ * starts one CPU further, so the jobs spread out.
+ *
+ * @param p The placement of the job.
+ */
+void placement_spread(placement *p){
+	if(p->mode == PLACE_ROUND_ROBIN || p->mode == PLACE_PAIRS){
+		p->first_cpu = next_first_cpu++;
+	}
+}
+
+/**
+ * placement_apply() - Applies the placement to the calling process. Should
+ * be called in the child before exec.
+ *
+ * @param p The placement.
+ * @param stage The index of the stage in the pipeline.
+ * @return 0 on success or -1 on failure.
+ */
+int placement_apply(const placement *p, int stage){
+	cpu_set_t set;
+	int cpu = -1;
+
+	switch(p->mode){
+	case PLACE_ROUND_ROBIN:
+		cpu = nth_allowed_cpu(p->first_cpu + stage);
+		break;
+	case PLACE_PAIRS:
+		cpu = nth_allowed_cpu(p->first_cpu + stage / 2);
+		break;
+	case PLACE_EXPLICIT:
+		if(stage >= p->number_of_sets){
+			stage = p->number_of_sets - 1;
+		}
+		if(sched_setaffinity(0, sizeof(cpu_set_t), &p->sets[stage]) < 0){
+			perror("pin: sched_setaffinity");
+			return -1;
+		}
+		break;
+	default:
+		break;
+	}
+	if(cpu >= 0){
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		if(sched_setaffinity(0, sizeof(set), &set) < 0){
+			perror("pin: sched_setaffinity");
+			return -1;
+		}
+	}
+
+	if(p->set_nice && setpriority(PRIO_PROCESS, 0, p->nice) < 0){
+		perror("pin: setpriority");
+		return -1;
+	}
+	if(p->ioprio >= 0 && \
+			syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, p->ioprio) < 0){
+		perror("pin: ioprio_set");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * parse_cpu_set() - Parses a set of CPUs given as a hex mask ("0xf") or a
+ * list of CPUs and ranges ("0-3,6").
+ *
+ * @param text The text to parse.
+ * @param set The set to fill in.
+ * @return 0 on success or -1 on a bad set.
+ */
+static int parse_cpu_set(const char *text, cpu_set_t *set){
+	CPU_ZERO(set);
+	if(strncmp(text, "0x", 2) == 0 || strncmp(text, "0X", 2) == 0){
+		return parse_cpu_mask(text + 2, set);
+	}
+
+	const char *cp = text;
+	while(*cp != '\0'){
+		char *end;
+		long first = strtol(cp, &end, 10);
+		long last = first;
+		if(end == cp || first < 0){
+			return -1;
+		}
+		if(*end == '-'){
+			cp = end + 1;
+			last = strtol(cp, &end, 10);
+			if(end == cp || last < first){
+				return -1;
+			}
+		}
+		if(last >= CPU_SETSIZE){
+			return -1;
+		}
+		for(long cpu = first; cpu <= last; cpu++){
+			CPU_SET(cpu, set);
+		}
+		if(*end == ','){
+			end++;
+		}
+		else if(*end != '\0'){
+			return -1;
+		}
+		cp = end;
+	}
+	return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+/**
+ * parse_cpu_mask() - Parses a hex mask of CPUs, the lowest bit being CPU 0.
+ *
+ * @param hex The hex digits without the 0x.
+ * @param set The set to fill in.
+ * @return 0 on success or -1 on a bad mask.
+ */
+static int parse_cpu_mask(const char *hex, cpu_set_t *set){
+	size_t len = strlen(hex);
+	if(len == 0 || len * 4 > CPU_SETSIZE){
+		return -1;
+	}
+
+	for(size_t i = 0; i < len; i++){
+		char digit = hex[len - 1 - i];
+		if(!isxdigit((int)digit)){
+			return -1;
+		}
+		int value = isdigit((int)digit) ? digit - '0' : \
+				tolower((int)digit) - 'a' + 10;
+		for(int bit = 0; bit < 4; bit++){
+			if(value & (1 << bit)){
+				CPU_SET(i * 4 + bit, set);
+			}
+		}
+	}
+	return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+/**
+ * parse_ioprio() - Parses an I/O scheduling class with an optional level,
+ * like "idle" or "be:4".
+ *
+ * @param text The text to parse.
+ * @return The ioprio value or -1 on a bad class or level.
+ */
+static int parse_ioprio(const char *text){
+	int class;
+	int level = 4;
+	size_t name_len = strcspn(text, ":");
+
+	if(strncmp(text, "rt", name_len) == 0 && name_len == 2){
+		class = IOPRIO_CLASS_RT;
+	}
+	else if(strncmp(text, "be", name_len) == 0 && name_len == 2){
+		class = IOPRIO_CLASS_BE;
+	}
+	else if(strncmp(text, "idle", name_len) == 0 && name_len == 4){
+		class = IOPRIO_CLASS_IDLE;
+		level = 0;
+	}
+	else{
+		return -1;
+	}
+
+	if(text[name_len] == ':'){
+		char *end;
+		level = (int)strtol(text + name_len + 1, &end, 10);
+		if(*end != '\0' || level < 0 || level > IOPRIO_MAX_LEVEL){
+			return -1;
+		}
+	}
+	return (class << IOPRIO_CLASS_SHIFT) | level;
+}
+
+/**
+ * nth_allowed_cpu() - Gets the n:th CPU, counted modulo the number of CPUs
+ * the process may run on.
+ *
+ * @param n The index of the CPU.
+ * @return The CPU number or -1 on failure.
+ */
+static int nth_allowed_cpu(int n){
+	cpu_set_t allowed;
+	if(sched_getaffinity(0, sizeof(allowed), &allowed) < 0){
+		perror("pin: sched_getaffinity");
+		return -1;
+	}
+
+	int count = CPU_COUNT(&allowed);
+	if(count == 0){
+		return -1;
+	}
+	n %= count;
+	for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+		if(CPU_ISSET(cpu, &allowed) && n-- == 0){
+			return cpu;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,74 @@
+/*
+ * placement.h Is the header file for the CPU and scheduling placement of the
+ * commands in a pipeline. A placement is given with the "pin" prefix:
+ *
+ *   pin [-r | -p | -c CPUS[:CPUS...]] [-n NICE] [-i CLASS[:LEVEL]] pipeline
+ *
+ * -r places the stages round-robin over the CPUs the shell may run on, -p
+ * places each pair of stages which share a pipe on the same CPU and -c gives
+ * the CPUs explicitly, either as a list like "0-3,6" or a hex mask like
+ * "0xf". With several ":" separated sets, stage n gets set n (the last set is
+ * repeated). -n sets the nice value and -i the I/O scheduling class (rt, be or
+ * idle) and level of every stage.
+ *
+ * The placement is applied in the child between fork() and exec.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef PLACEMENT_H_
+#define PLACEMENT_H_
+
+#include <sched.h>
+
+/*The most CPU sets which can be given to -c.*/
+#define PLACEMENT_MAX_SETS 16
+
+/*How the stages are placed on the CPUs.*/
+#define PLACE_NONE		0
+#define PLACE_ROUND_ROBIN	1
+#define PLACE_PAIRS		2
+#define PLACE_EXPLICIT		3
+
+typedef struct placement{
+	int mode;
+	int first_cpu;		//The CPU index which stage 0 starts from.
+	int number_of_sets;
+	cpu_set_t sets[PLACEMENT_MAX_SETS];
+	int set_nice;
+	int nice;
+	int ioprio;		//The ioprio value, -1 to keep it.
+}placement;
+
+/**
+ * placement_parse() - Parses the options of the pin prefix.
+ *
+ * @param p The placement to fill in.
+ * @param argc The number of words, starting with "pin".
+ * @param argv The words.
+ * @return The number of words used by pin and its options, or -1 on a bad
+ * option.
+ */
+int placement_parse(placement *p, int argc, char **argv);
+
+/**
+ * placement_spread() - Gives a round-robin or pairs placement the CPU which
+ * its stage 0 is placed on. Every job which is started with such a placement
+ * starts one CPU further, so the jobs spread out.
+ *
+ * @param p The placement of the job.
+ */
+void placement_spread(placement *p);
+
+/**
+ * placement_apply() - Applies the placement to the calling process. Should
+ * be called in the child before exec.
+ *
+ * @param p The placement.
+ * @param stage The index of the stage in the pipeline.
+ * @return 0 on success or -1 on failure.
+ */
+int placement_apply(const placement *p, int stage);
+
+#endif /* PLACEMENT_H_ */
@@ -0,0 +1,126 @@
+/*
+ * ring.c Is the source code for the lock-free ring buffer of mish. See the
+ * header file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "ring.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <sys/mman.h>
+
+/* Defines */
+#define RING_MIN_SIZE 4096
+
+
+/**
+ * ring_init() - Allocates the buffer of a ring.
+ *
+ * @param r The ring.
+ * @param size The smallest size of the buffer, rounded up to a power of two.
+ * @return 0 on success or -1 on failure.
+ */
+int ring_init(ring *r, size_t size){
+	size_t rounded = RING_MIN_SIZE;
+	while(rounded < size){
+		rounded <<= 1;
+		if(rounded == 0){
+			fprintf(stderr, "Ring buffer too large\n");
+			return -1;
+		}
+	}
+
+	//Pages are only used when they are first written.
+	r->data = mmap(NULL, rounded, PROT_READ | PROT_WRITE, \
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(r->data == MAP_FAILED){
+		perror("Ring buffer");
+		return -1;
+	}
+	r->size = rounded;
+	atomic_init(&r->head, 0);
+	atomic_init(&r->tail, 0);
+	return 0;
+}
+
+/**
+ * ring_destroy() - Frees the buffer of a ring.
+ *
+ * @param r The ring.
+ */
+void ring_destroy(ring *r){
+	munmap(r->data, r->size);
+	r->data = NULL;
+}
+
+/**
+ * ring_fill() - Gets the number of bytes in the ring.
+ *
+ * @param r The ring.
+ * @return The number of bytes which can be read.
+ */
+size_t ring_fill(ring *r){
+	return atomic_load(&r->head) - atomic_load(&r->tail);
+}
+
+/**
+ * ring_write_region() - Gets the free space which can be written in one
+ * piece. Only the producer may call it.
+ *
+ * @param r The ring.
+ * @param len Set to the length of the free space.
+ * @return A pointer to the free space.
+ */
+char *ring_write_region(ring *r, size_t *len){
+	size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+	size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+	size_t offset = head & (r->size - 1);
+	size_t free_space = r->size - (head - tail);
+
+	*len = free_space < r->size - offset ? free_space : r->size - offset;
+	return r->data + offset;
+}
+
+/**
+ * ring_commit_write() - Passes written bytes to the consumer.
+ *
+ * @param r The ring.
+ * @param len The number of bytes written into the free space.
+ */
+void ring_commit_write(ring *r, size_t len){
+	//Sequentially consistent, so a consumer going to sleep sees it.
+	atomic_fetch_add(&r->head, len);
+}
+
+/**
+ * ring_read_region() - Gets the data which can be read in one piece. Only
+ * the consumer may call it.
+ *
+ * @param r The ring.
+ * @param len Set to the length of the data.
+ * @return A pointer to the data.
+ */
+char *ring_read_region(ring *r, size_t *len){
+	size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+	size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+	size_t offset = tail & (r->size - 1);
+	size_t fill = head - tail;
+
+	*len = fill < r->size - offset ? fill : r->size - offset;
+	return r->data + offset;
+}
+
+/**
+ * ring_commit_read() - Gives read bytes back to the producer.
+ *
+ * @param r The ring.
+ * @param len The number of bytes which were read.
+ */
+void ring_commit_read(ring *r, size_t len){
+	//Sequentially consistent, so a producer going to sleep sees it.
+	atomic_fetch_add(&r->tail, len);
+}
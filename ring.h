@@ -0,0 +1,93 @@
+/*
+ * ring.h Is the header file for the lock-free ring buffer of mish. The ring
+ * has one producer and one consumer which may run in different threads. The
+ * producer only moves the head and the consumer only moves the tail, so no
+ * lock is needed to pass data. The size is a power of two and the positions
+ * only grow, so the fill is always head minus tail.
+ *
+ * The data is accessed in place. The producer asks for the free space up to
+ * the end of the buffer, fills it and commits it, and the consumer does the
+ * same with the data.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef RING_H_
+#define RING_H_
+
+#include <stdatomic.h>
+#include <stdalign.h>
+#include <stddef.h>
+
+/*Keeps the positions on their own cache lines.*/
+#define RING_CACHE_LINE 64
+
+typedef struct ring{
+	char *data;
+	size_t size;
+	alignas(RING_CACHE_LINE) atomic_size_t head;	//Written by the producer.
+	alignas(RING_CACHE_LINE) atomic_size_t tail;	//Written by the consumer.
+}ring;
+
+/**
+ * ring_init() - Allocates the buffer of a ring.
+ *
+ * @param r The ring.
+ * @param size The smallest size of the buffer, rounded up to a power of two.
+ * @return 0 on success or -1 on failure.
+ */
+int ring_init(ring *r, size_t size);
+
+/**
+ * ring_destroy() - Frees the buffer of a ring.
+ *
+ * @param r The ring.
+ */
+void ring_destroy(ring *r);
+
+/**
+ * ring_fill() - Gets the number of bytes in the ring.
+ *
+ * @param r The ring.
+ * @return The number of bytes which can be read.
+ */
+size_t ring_fill(ring *r);
+
+/**
+ * ring_write_region() - Gets the free space which can be written in one
+ * piece. Only the producer may call it.
+ *
+ * @param r The ring.
+ * @param len Set to the length of the free space.
+ * @return A pointer to the free space.
+ */
+char *ring_write_region(ring *r, size_t *len);
+
+/**
+ * ring_commit_write() - Passes written bytes to the consumer.
+ *
+ * @param r The ring.
+ * @param len The number of bytes written into the free space.
+ */
+void ring_commit_write(ring *r, size_t len);
+
+/**
+ * ring_read_region() - Gets the data which can be read in one piece. Only
+ * the consumer may call it.
+ *
+ * @param r The ring.
+ * @param len Set to the length of the data.
+ * @return A pointer to the data.
+ */
+char *ring_read_region(ring *r, size_t *len);
+
+/**
+ * ring_commit_read() - Gives read bytes back to the producer.
+ *
+ * @param r The ring.
+ * @param len The number of bytes which were read.
+ */
+void ring_commit_read(ring *r, size_t len);
+
+#endif /* RING_H_ */
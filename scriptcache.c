@@ -0,0 +1,774 @@
+/*
+ * scriptcache.c Is the source code for the compiled scripts of mish. See the
+ * header file for more information.
+ *
+ * The image is laid out as
+ *
+ *   header | path | lines | commands | words | strings
+ *
+ * where every line refers to a range of commands, every command to a range
+ * of words ended by WORD_NONE and every word to a string. All references are
+ * offsets, so the image can be used straight from the mapped cache file.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "scriptcache.h"
+#include "hash.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Defines */
+#define IMAGE_MAGIC "MISHSCR"
+#define IMAGE_VERSION 7	//Raised when the image or the parser changes.
+#define IMAGE_ALIGN 8
+#define WORD_NONE UINT32_MAX	//Ends an argv, or a missing redirection.
+
+/*Flags of a line.*/
+#define LINE_SYNTAX_ERROR	1	//Parsed again when run to report the error.
+#define LINE_TOO_LONG		2
+
+/*The header of an image.*/
+typedef struct image_header{
+	char magic[8];
+	uint32_t version;
+	uint32_t number_of_lines;
+	uint64_t script_size;
+	int64_t script_mtime_sec;
+	int64_t script_mtime_nsec;
+	uint64_t script_hash;
+	uint64_t path_len;
+	uint64_t lines_offset;
+	uint64_t commands_offset;
+	uint64_t words_offset;
+	uint64_t strings_offset;
+	uint64_t image_size;
+}image_header;
+
+/*A line of the script.*/
+typedef struct cached_line{
+	uint64_t source_offset;
+	uint32_t source_len;
+	uint32_t flags;
+	uint32_t first_command;
+	uint32_t number_of_commands;
+}cached_line;
+
+/*A parsed command.*/
+typedef struct cached_command{
+	uint32_t first_word;
+	uint32_t argc;
+	uint32_t infile;
+	uint32_t outfile;
+	int32_t separator;
+	uint32_t unused;
+}cached_command;
+
+/*A growable buffer for a section of the image.*/
+typedef struct section{
+	char *data;
+	size_t len;
+	size_t cap;
+}section;
+
+/*The script type.*/
+struct script{
+	char *source;
+	size_t source_size;
+	char *image;
+	size_t image_size;
+	int image_mapped;
+	int from_cache;
+	const image_header *header;
+	const cached_line *lines;
+	const cached_command *commands;
+	const uint32_t *words;
+	const char *strings;
+};
+
+/*Function prototypes.*/
+static char *compile_script(script *s, const struct stat *st, uint64_t hash, \
+		const char *path);
+static int compile_line(const char *line, size_t len, section *lines, \
+		section *commands, section *words, section *strings, \
+		uint64_t source_offset);
+static uint32_t add_string(section *strings, const char *str);
+static void *section_append(section *sec, const void *data, size_t len);
+static int cache_file_name(const char *path, char *name, size_t size);
+static int make_cache_dir(char *dir);
+static void save_image(const char *path, const char *image, size_t size);
+static char *load_image(const char *path, const struct stat *st, \
+		uint64_t hash, const char *real_path, size_t *size);
+static int check_image(const char *image);
+static int check_line(const char *image, const cached_line *line);
+static int check_string(const image_header *header, uint32_t str);
+static void use_image(script *s);
+static int is_blank(const char *line, size_t len);
+
+
+/**
+ * script_open() - Opens a script, loading its compiled image from the cache
+ * or compiling it and saving the image in the cache.
+ *
+ * @param path The path of the script.
+ * @return The opened script or NULL on failure.
+ */
+script *script_open(const char *path){
+	char real_path[PATH_MAX];
+	if(realpath(path, real_path) == NULL){
+		perror(path);
+		return NULL;
+	}
+
+	int fd = open(real_path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0){
+		perror(path);
+		return NULL;
+	}
+	struct stat st;
+	if(fstat(fd, &st) < 0){
+		perror(path);
+		close(fd);
+		return NULL;
+	}
+
+	script *s = calloc(1, sizeof(*s));
+	if(s == NULL){
+		perror("script");
+		close(fd);
+		return NULL;
+	}
+	s->source_size = st.st_size;
+	if(s->source_size > 0){
+		s->source = mmap(NULL, s->source_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(s->source == MAP_FAILED){
+			perror(path);
+			close(fd);
+			free(s);
+			return NULL;
+		}
+	}
+	close(fd);
+
+	uint64_t hash = hash_bytes(s->source, s->source_size, HASH_SEED);
+	char cache_name[PATH_MAX];
+	int cacheable = cache_file_name(real_path, cache_name, sizeof(cache_name));
+
+	if(cacheable == 0){
+		s->image = load_image(cache_name, &st, hash, real_path, &s->image_size);
+	}
+	if(s->image != NULL){
+		s->image_mapped = 1;
+		s->from_cache = 1;
+	}
+	else{
+		s->image = compile_script(s, &st, hash, real_path);
+		if(s->image == NULL){
+			script_close(s);
+			return NULL;
+		}
+		if(cacheable == 0){
+			save_image(cache_name, s->image, s->image_size);
+		}
+	}
+
+	use_image(s);
+	return s;
+}
+
+/**
+ * script_lines() - Gets the number of lines in the script.
+ *
+ * @param s The script.
+ * @return The number of lines.
+ */
+int script_lines(script *s){
+	return (int)s->header->number_of_lines;
+}
+
+/**
+ * script_from_cache() - Tells if the image of the script was loaded from the
+ * cache.
+ *
+ * @param s The script.
+ * @return 1 if loaded from the cache, 0 if it was compiled.
+ */
+int script_from_cache(script *s){
+	return s->from_cache;
+}
+
+/**
+ * script_hash() - Gets the hash of the source of the script, which tells
+ * versions of the script apart.
+ *
+ * @param s The script.
+ * @return The hash.
+ */
+uint64_t script_hash(script *s){
+	return s->header->script_hash;
+}
+
+/**
+ * script_get_line() - Gets the parsed commands of a line, like parse() does.
+ * The strings point into the image and are valid until the script is closed.
+ * The words keep their quotes, see PARSE_KEEP_QUOTES in parser.h.
+ *
+ * @param s The script.
+ * @param index The index of the line, starting at 0.
+ * @param comLine The array to put the commands in, MAXCOMMANDS long.
+ * @param words The array for the argv pointers, MAXWORDS long.
+ * @return The number of commands on the line, 0 if it is empty or -1 if it
+ * has a syntax error, which has been reported.
+ */
+int script_get_line(script *s, int index, command comLine[], char *words[]){
+	const cached_line *line = &s->lines[index];
+
+	if(line->flags & LINE_TOO_LONG){
+		fprintf(stderr, "Line too long.\n");
+		return -1;
+	}
+	if(line->flags & LINE_SYNTAX_ERROR){
+		//Let the parser report the error just like for a typed line.
+		char input_line[MAXLINELEN+1];
+		memcpy(input_line, s->source + line->source_offset, line->source_len);
+		input_line[line->source_len] = '\0';
+		parse(input_line, comLine);
+		return -1;
+	}
+
+	int wordc = 0;
+	for(uint32_t i = 0; i < line->number_of_commands; i++){
+		const cached_command *cmd = &s->commands[line->first_command + i];
+		comLine[i].argv = words + wordc;
+		comLine[i].argc = (int)cmd->argc;
+		for(const uint32_t *w = s->words + cmd->first_word; *w != WORD_NONE; w++){
+			words[wordc++] = (char *)s->strings + *w;
+		}
+		words[wordc++] = NULL;
+		comLine[i].infile = cmd->infile == WORD_NONE ? NULL : \
+				(char *)s->strings + cmd->infile;
+		comLine[i].outfile = cmd->outfile == WORD_NONE ? NULL : \
+				(char *)s->strings + cmd->outfile;
+		comLine[i].separator = cmd->separator;
+	}
+	return (int)line->number_of_commands;
+}
+
+/**
+ * script_close() - Closes the script and unmaps its image.
+ *
+ * @param s The script.
+ */
+void script_close(script *s){
+	if(s->image != NULL){
+		if(s->image_mapped){
+			munmap(s->image, s->image_size);
+		}
+		else{
+			free(s->image);
+		}
+	}
+	if(s->source != NULL){
+		munmap(s->source, s->source_size);
+	}
+	free(s);
+}
+
+/**
+ * compile_script() - Parses every line of the script and builds the image.
+ * Syntax errors are not printed here, the lines are marked so the errors are
+ * reported when the lines are run.
+ *
+ * @param s The script with the source mapped.
+ * @param st The status of the script file.
+ * @param hash The hash of the script.
+ * @param path The real path of the script.
+ * @return The image in allocated memory, or NULL on failure.
+ */
+static char *compile_script(script *s, const struct stat *st, uint64_t hash, \
+		const char *path){
+	section lines = {NULL, 0, 0};
+	section commands = {NULL, 0, 0};
+	section words = {NULL, 0, 0};
+	section strings = {NULL, 0, 0};
+	char *image = NULL;
+
+	size_t start = 0;
+	int failed = 0;
+	while(start < s->source_size && !failed){
+		const char *newline = memchr(s->source + start, '\n', \
+				s->source_size - start);
+		size_t len = newline != NULL ? (size_t)(newline - s->source) - start : \
+				s->source_size - start;
+		failed = compile_line(s->source + start, len, &lines, &commands, \
+				&words, &strings, start);
+		start += len + 1;
+	}
+
+	if(!failed){
+		image_header header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+		header.version = IMAGE_VERSION;
+		header.number_of_lines = lines.len / sizeof(cached_line);
+		header.script_size = st->st_size;
+		header.script_mtime_sec = st->st_mtim.tv_sec;
+		header.script_mtime_nsec = st->st_mtim.tv_nsec;
+		header.script_hash = hash;
+		header.path_len = strlen(path);
+
+		//Every section starts aligned after the one before it.
+		size_t offset = sizeof(header) + header.path_len + 1;
+		offset = (offset + IMAGE_ALIGN - 1) / IMAGE_ALIGN * IMAGE_ALIGN;
+		header.lines_offset = offset;
+		header.commands_offset = header.lines_offset + lines.len;
+		header.words_offset = header.commands_offset + commands.len;
+		header.strings_offset = header.words_offset + words.len;
+		header.image_size = header.strings_offset + strings.len;
+
+		image = calloc(1, header.image_size);
+		if(image == NULL){
+			perror("script");
+		}
+		else{
+			memcpy(image, &header, sizeof(header));
+			memcpy(image + sizeof(header), path, header.path_len + 1);
+			if(lines.len > 0){
+				memcpy(image + header.lines_offset, lines.data, lines.len);
+			}
+			if(commands.len > 0){
+				memcpy(image + header.commands_offset, commands.data, \
+						commands.len);
+			}
+			if(words.len > 0){
+				memcpy(image + header.words_offset, words.data, words.len);
+			}
+			if(strings.len > 0){
+				memcpy(image + header.strings_offset, strings.data, \
+						strings.len);
+			}
+			s->image_size = header.image_size;
+		}
+	}
+
+	free(lines.data);
+	free(commands.data);
+	free(words.data);
+	free(strings.data);
+	return image;
+}
+
+/**
+ * compile_line() - Parses one line and adds it to the sections of the image.
+ *
+ * @param line The line, not null terminated.
+ * @param len The length of the line without the newline.
+ * @param lines The section of lines.
+ * @param commands The section of commands.
+ * @param words The section of words.
+ * @param strings The section of strings.
+ * @param source_offset Where the line starts in the script.
+ * @return 0 on success or -1 on failure.
+ */
+static int compile_line(const char *line, size_t len, section *lines, \
+		section *commands, section *words, section *strings, \
+		uint64_t source_offset){
+	cached_line cached;
+	memset(&cached, 0, sizeof(cached));
+	cached.source_offset = source_offset;
+	cached.source_len = len;
+	cached.first_command = commands->len / sizeof(cached_command);
+
+	if(len >= MAXLINELEN){
+		cached.flags = LINE_TOO_LONG;
+		return section_append(lines, &cached, sizeof(cached)) ? 0 : -1;
+	}
+
+	char input_line[MAXLINELEN+1];
+	char *line_words[MAXWORDS];
+	command comLine[MAXCOMMANDS];
+	memcpy(input_line, line, len);
+	input_line[len] = '\0';
+	int number_of_commands = parse_in_place(input_line, comLine, line_words, \
+			PARSE_QUIET | PARSE_KEEP_QUOTES);
+	if(number_of_commands == 0 && !is_blank(line, len)){
+		cached.flags = LINE_SYNTAX_ERROR;
+	}
+	cached.number_of_commands = number_of_commands;
+
+	for(int i = 0; i < number_of_commands; i++){
+		cached_command cmd;
+		memset(&cmd, 0, sizeof(cmd));
+		cmd.first_word = words->len / sizeof(uint32_t);
+		cmd.argc = comLine[i].argc;
+		cmd.separator = comLine[i].separator;
+		cmd.infile = comLine[i].infile ? \
+				add_string(strings, comLine[i].infile) : WORD_NONE;
+		cmd.outfile = comLine[i].outfile ? \
+				add_string(strings, comLine[i].outfile) : WORD_NONE;
+		for(int j = 0; j < comLine[i].argc; j++){
+			uint32_t str = add_string(strings, comLine[i].argv[j]);
+			if(str == WORD_NONE || !section_append(words, &str, sizeof(str))){
+				return -1;
+			}
+		}
+		uint32_t end = WORD_NONE;
+		if(!section_append(words, &end, sizeof(end)) || \
+				!section_append(commands, &cmd, sizeof(cmd))){
+			return -1;
+		}
+	}
+
+	return section_append(lines, &cached, sizeof(cached)) ? 0 : -1;
+}
+
+/**
+ * add_string() - Adds a string to the string section.
+ *
+ * @param strings The section of strings.
+ * @param str The string.
+ * @return The offset of the string or WORD_NONE on failure.
+ */
+static uint32_t add_string(section *strings, const char *str){
+	size_t offset = strings->len;
+	if(offset >= WORD_NONE || \
+			section_append(strings, str, strlen(str) + 1) == NULL){
+		return WORD_NONE;
+	}
+	return (uint32_t)offset;
+}
+
+/**
+ * section_append() - Appends data to a section, growing it when needed.
+ *
+ * @param sec The section.
+ * @param data The data to append.
+ * @param len The length of the data.
+ * @return A pointer to the appended data or NULL on failure.
+ */
+static void *section_append(section *sec, const void *data, size_t len){
+	if(sec->len + len > sec->cap){
+		size_t cap = sec->cap > 0 ? sec->cap * 2 : 4096;
+		while(cap < sec->len + len){
+			cap *= 2;
+		}
+		char *data_copy = realloc(sec->data, cap);
+		if(data_copy == NULL){
+			perror("script");
+			return NULL;
+		}
+		sec->data = data_copy;
+		sec->cap = cap;
+	}
+
+	void *dest = sec->data + sec->len;
+	memcpy(dest, data, len);
+	sec->len += len;
+	return dest;
+}
+
+/**
+ * script_cache_dir() - Gets the cache directory of mish, which the other
+ * caches of mish keep their files below too, and makes sure it exists.
+ *
+ * @param dir The buffer for the directory.
+ * @param size The size of the buffer.
+ * @return 0 on success or -1 if there is no usable cache directory.
+ */
+int script_cache_dir(char *dir, size_t size){
+	const char *env;
+	int len;
+
+	if((env = getenv("MISH_CACHE_DIR")) != NULL){
+		len = snprintf(dir, size, "%s", env);
+	}
+	else if((env = getenv("XDG_CACHE_HOME")) != NULL && *env != '\0'){
+		len = snprintf(dir, size, "%s/mish", env);
+	}
+	else if((env = getenv("HOME")) != NULL && *env != '\0'){
+		len = snprintf(dir, size, "%s/.cache/mish", env);
+	}
+	else{
+		return -1;
+	}
+	if(len <= 0 || (size_t)len >= size || make_cache_dir(dir) < 0){
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * cache_file_name() - Gets the name of the cache file for a script and makes
+ * sure the cache directory exists.
+ *
+ * @param path The real path of the script.
+ * @param name The buffer for the name.
+ * @param size The size of the buffer.
+ * @return 0 on success or -1 if there is no usable cache directory.
+ */
+static int cache_file_name(const char *path, char *name, size_t size){
+	char dir[PATH_MAX];
+
+	if(script_cache_dir(dir, sizeof(dir)) < 0){
+		return -1;
+	}
+	int len = snprintf(name, size, "%s/%016llx.mishc", dir, \
+			(unsigned long long)hash_string(path, HASH_SEED));
+	return (len > 0 && (size_t)len < size) ? 0 : -1;
+}
+
+/**
+ * make_cache_dir() - Creates a directory and the directories above it.
+ *
+ * @param dir The directory, which is modified while the parents are created.
+ * @return 0 on success or -1 on failure.
+ */
+static int make_cache_dir(char *dir){
+	for(char *slash = strchr(dir + 1, '/'); slash != NULL;
+			slash = strchr(slash + 1, '/')){
+		*slash = '\0';
+		int ret = mkdir(dir, 0700);
+		*slash = '/';
+		if(ret < 0 && errno != EEXIST){
+			return -1;
+		}
+	}
+	if(mkdir(dir, 0700) < 0 && errno != EEXIST){
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * save_image() - Writes an image to its cache file. The image is written to
+ * a temporary file which is renamed, so a cache file is always complete.
+ *
+ * @param path The path of the cache file.
+ * @param image The image.
+ * @param size The size of the image.
+ */
+static void save_image(const char *path, const char *image, size_t size){
+	char tmp_path[PATH_MAX];
+	int len = snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, \
+			(int)getpid());
+	if(len <= 0 || (size_t)len >= sizeof(tmp_path)){
+		return;
+	}
+
+	int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if(fd < 0){
+		return; //Running without the cache is fine.
+	}
+	size_t written = 0;
+	while(written < size){
+		ssize_t n = write(fd, image + written, size - written);
+		if(n < 0 && errno == EINTR){
+			continue;
+		}
+		if(n <= 0){
+			break;
+		}
+		written += n;
+	}
+	close(fd);
+
+	if(written != size || rename(tmp_path, path) < 0){
+		unlink(tmp_path);
+	}
+}
+
+/**
+ * load_image() - Maps a cache file and checks that it is an image of the
+ * current version of the script.
+ *
+ * @param path The path of the cache file.
+ * @param st The status of the script file.
+ * @param hash The hash of the script.
+ * @param real_path The real path of the script.
+ * @param size Set to the size of the image.
+ * @return The mapped image or NULL if there is no valid image.
+ */
+static char *load_image(const char *path, const struct stat *st, \
+		uint64_t hash, const char *real_path, size_t *size){
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0){
+		return NULL;
+	}
+	struct stat cache_st;
+	if(fstat(fd, &cache_st) < 0 || \
+			(size_t)cache_st.st_size < sizeof(image_header)){
+		close(fd);
+		return NULL;
+	}
+	char *image = mmap(NULL, cache_st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(image == MAP_FAILED){
+		return NULL;
+	}
+
+	const image_header *header = (const image_header *)image;
+	size_t path_len = strlen(real_path);
+	if(memcmp(header->magic, IMAGE_MAGIC, sizeof(header->magic)) != 0 || \
+			header->version != IMAGE_VERSION || \
+			header->image_size != (uint64_t)cache_st.st_size || \
+			header->script_size != (uint64_t)st->st_size || \
+			header->script_mtime_sec != st->st_mtim.tv_sec || \
+			header->script_mtime_nsec != st->st_mtim.tv_nsec || \
+			header->script_hash != hash || \
+			header->path_len != path_len || \
+			sizeof(*header) + path_len >= header->lines_offset || \
+			header->lines_offset > header->commands_offset || \
+			header->commands_offset > header->words_offset || \
+			header->words_offset > header->strings_offset || \
+			header->strings_offset > header->image_size || \
+			memcmp(image + sizeof(*header), real_path, path_len) != 0 || \
+			check_image(image) < 0){
+		munmap(image, cache_st.st_size);
+		return NULL;
+	}
+
+	*size = cache_st.st_size;
+	return image;
+}
+
+/**
+ * check_image() - Checks that every offset in an image whose header has been
+ * checked is in its section, so a cut short or damaged cache file is
+ * compiled again instead of being read outside the image.
+ *
+ * @param image The image.
+ * @return 0 if the image can be used or -1 if it is damaged.
+ */
+static int check_image(const char *image){
+	const image_header *header = (const image_header *)image;
+	uint64_t lines_size = header->commands_offset - header->lines_offset;
+	uint64_t commands_size = header->words_offset - header->commands_offset;
+	uint64_t words_size = header->strings_offset - header->words_offset;
+	uint64_t strings_size = header->image_size - header->strings_offset;
+	if(header->lines_offset % IMAGE_ALIGN != 0 || \
+			lines_size != header->number_of_lines * sizeof(cached_line) || \
+			commands_size % sizeof(cached_command) != 0 || \
+			words_size % sizeof(uint32_t) != 0 || \
+			(strings_size > 0 && image[header->image_size - 1] != '\0')){
+		return -1;
+	}
+
+	const cached_line *lines = \
+			(const cached_line *)(image + header->lines_offset);
+	for(uint32_t i = 0; i < header->number_of_lines; i++){
+		if(check_line(image, &lines[i]) < 0){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * check_line() - Checks the source, the commands and the words of a line of
+ * an image, and that they fit in the arrays of script_get_line().
+ *
+ * @param image The image.
+ * @param line The line.
+ * @return 0 if the line can be used or -1 if it is damaged.
+ */
+static int check_line(const char *image, const cached_line *line){
+	const image_header *header = (const image_header *)image;
+	uint64_t number_of_commands = (header->words_offset - \
+			header->commands_offset) / sizeof(cached_command);
+	uint64_t number_of_words = (header->strings_offset - \
+			header->words_offset) / sizeof(uint32_t);
+	const cached_command *commands = \
+			(const cached_command *)(image + header->commands_offset);
+	const uint32_t *words = (const uint32_t *)(image + header->words_offset);
+
+	//The source of a line with a syntax error is parsed again when run.
+	if(line->source_offset > header->script_size || \
+			line->source_len > header->script_size - line->source_offset || \
+			((line->flags & LINE_SYNTAX_ERROR) && \
+			line->source_len > MAXLINELEN) || \
+			line->number_of_commands > MAXCOMMANDS || \
+			(uint64_t)line->first_command + line->number_of_commands > \
+			number_of_commands){
+		return -1;
+	}
+
+	uint64_t wordc = 0;	//The argv pointers script_get_line() sets.
+	for(uint32_t i = 0; i < line->number_of_commands; i++){
+		const cached_command *cmd = &commands[line->first_command + i];
+		if(cmd->separator < SEP_END || cmd->separator > SEP_FANOUT || \
+				(cmd->infile != WORD_NONE && \
+				check_string(header, cmd->infile) < 0) || \
+				(cmd->outfile != WORD_NONE && \
+				check_string(header, cmd->outfile) < 0)){
+			return -1;
+		}
+		uint64_t w = cmd->first_word;
+		for(; w < number_of_words && words[w] != WORD_NONE && \
+				w - cmd->first_word < MAXWORDS; w++){
+			if(check_string(header, words[w]) < 0){
+				return -1;
+			}
+		}
+		if(w >= number_of_words || words[w] != WORD_NONE || \
+				w - cmd->first_word != cmd->argc){
+			return -1;
+		}
+		wordc += cmd->argc + 1;
+	}
+	return wordc <= MAXWORDS ? 0 : -1;
+}
+
+/**
+ * check_string() - Checks that a string offset is in the string section. The
+ * section ends with a null character, so the string ends in it.
+ *
+ * @param header The header of the image.
+ * @param str The offset of the string.
+ * @return 0 if the offset is in the section, else -1.
+ */
+static int check_string(const image_header *header, uint32_t str){
+	return str < header->image_size - header->strings_offset ? 0 : -1;
+}
+
+/**
+ * use_image() - Sets up the pointers to the sections of the image.
+ *
+ * @param s The script with its image.
+ */
+static void use_image(script *s){
+	s->header = (const image_header *)s->image;
+	s->lines = (const cached_line *)(s->image + s->header->lines_offset);
+	s->commands = (const cached_command *) \
+			(s->image + s->header->commands_offset);
+	s->words = (const uint32_t *)(s->image + s->header->words_offset);
+	s->strings = s->image + s->header->strings_offset;
+}
+
+/**
+ * is_blank() - Checks if a line only contains whitespace.
+ *
+ * @param line The line.
+ * @param len The length of the line.
+ * @return 1 if the line is blank, else 0.
+ */
+static int is_blank(const char *line, size_t len){
+	for(size_t i = 0; i < len; i++){
+		if(!isspace((int)line[i])){
+			return 0;
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,94 @@
+/*
+ * scriptcache.h Is the header file for the compiled scripts of mish. A script
+ * given to mish is parsed once into a flat binary image which holds the
+ * parsed commands of every line with their argv and redirections. The image
+ * is saved in a cache file keyed by the path of the script and checked
+ * against the size, mtime and hash of the script. When the script has not
+ * changed, the cache file is mmap'd and the lines are run without calling
+ * parse() again.
+ *
+ * The cache files are kept in $MISH_CACHE_DIR, $XDG_CACHE_HOME/mish or
+ * $HOME/.cache/mish, in that order. If no cache file can be written, the
+ * image is only kept in memory.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef SCRIPTCACHE_H_
+#define SCRIPTCACHE_H_
+
+#include "parser.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct script script;
+
+/**
+ * script_open() - Opens a script, loading its compiled image from the cache
+ * or compiling it and saving the image in the cache.
+ *
+ * @param path The path of the script.
+ * @return The opened script or NULL on failure.
+ */
+script *script_open(const char *path);
+
+/**
+ * script_lines() - Gets the number of lines in the script.
+ *
+ * @param s The script.
+ * @return The number of lines.
+ */
+int script_lines(script *s);
+
+/**
+ * script_from_cache() - Tells if the image of the script was loaded from the
+ * cache.
+ *
+ * @param s The script.
+ * @return 1 if loaded from the cache, 0 if it was compiled.
+ */
+int script_from_cache(script *s);
+
+/**
+ * script_hash() - Gets the hash of the source of the script, which tells
+ * versions of the script apart.
+ *
+ * @param s The script.
+ * @return The hash.
+ */
+uint64_t script_hash(script *s);
+
+/**
+ * script_get_line() - Gets the parsed commands of a line, like parse() does.
+ * The strings point into the image and are valid until the script is closed.
+ * The words keep their quotes, see PARSE_KEEP_QUOTES in parser.h.
+ *
+ * @param s The script.
+ * @param index The index of the line, starting at 0.
+ * @param comLine The array to put the commands in, MAXCOMMANDS long.
+ * @param words The array for the argv pointers, MAXWORDS long.
+ * @return The number of commands on the line, 0 if it is empty or -1 if it
+ * has a syntax error, which has been reported.
+ */
+int script_get_line(script *s, int index, command comLine[], char *words[]);
+
+/**
+ * script_close() - Closes the script and unmaps its image.
+ *
+ * @param s The script.
+ */
+void script_close(script *s);
+
+/**
+ * script_cache_dir() - Gets the cache directory of mish, which the other
+ * caches of mish keep their files below too, and makes sure it exists.
+ *
+ * @param dir The buffer for the directory.
+ * @param size The size of the buffer.
+ * @return 0 on success or -1 if there is no usable cache directory.
+ */
+int script_cache_dir(char *dir, size_t size);
+
+#endif /* SCRIPTCACHE_H_ */
@@ -0,0 +1,783 @@
+/*
+ * serve.c Is the source code for the server mode of mish. See the header
+ * file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "serve.h"
+#include "parser.h"
+#include "launch.h"
+#include "list.h"
+#include "hash.h"
+#include "jobs.h"
+#include "stats.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* Defines */
+#define SERVE_BACKLOG 64	//Connections which may wait to be accepted
+#define SERVE_EVENTS 32	//Events handled per round of the loop
+#define SERVE_FDS 3	//The stdin, stdout and stderr of a request
+#define CHILD_POOL_SLAB 64	//Children per slab in the child pool
+#define PARSE_CACHE_SLOTS 256	//Lines in the parse cache
+#define PATH_CACHE_SLOTS 256	//Commands in the PATH cache
+#define REPLY_LEN 128
+
+/*A parsed line, allocated as one block with its commands and words. It is
+ *freed when neither the cache nor a request uses it.*/
+typedef struct parsed_line{
+	uint64_t hash;
+	int users;
+	int number_of_commands;
+	command *commands;
+	char *line;
+}parsed_line;
+
+/*The request a connection is running.*/
+typedef struct serve_request{
+	int fds[SERVE_FDS];
+	parsed_line *parsed;
+	int next;	//The first command of the next pipeline.
+	int separator;	//What followed the last pipeline which was reached.
+	int run;	//If the next pipeline is run or skipped.
+	int waiting;	//The children of the pipeline which is waited for.
+	int running;	//All children which are not reaped.
+	int status;	//The exit status of the last pipeline.
+	struct rusage pipeline_usage;	//Of the pipeline which is waited for.
+	struct rusage total_usage;	//Of all children of the request.
+}serve_request;
+
+/*A client of the server.*/
+typedef struct serve_connection{
+	list_link link;
+	int fd;
+	int busy;	//If a request is running.
+	int closed;	//If the client has gone, it is freed with its request.
+	serve_request request;
+}serve_connection;
+
+/*A child started for a request.*/
+typedef struct serve_child{
+	list_link link;
+	pid_t pid;
+	serve_connection *conn;
+	int foreground;	//If the pipeline of the child is waited for.
+	int last_stage;	//If the child is the last stage of its pipeline.
+}serve_child;
+
+/*The pipeline which start_pipeline() is starting, for its started hook.*/
+typedef struct serve_launch{
+	serve_connection *conn;
+	int foreground;	//If the request waits for the pipeline.
+}serve_launch;
+
+/*Function prototypes.*/
+static int open_socket(const char *path);
+static int open_signals(void);
+static void accept_connections(void);
+static void read_request(serve_connection *conn);
+static void start_request(serve_connection *conn, char *line, int fds[]);
+static void advance_request(serve_connection *conn);
+static void set_run(serve_request *r);
+static void finish_request(serve_connection *conn);
+static void end_request(serve_connection *conn);
+static int start_pipeline(serve_connection *conn, command *command_array, \
+		int number_of_commands, int foreground);
+static void add_child(const launch_child *launched, void *arg);
+static int run_stats(command *cmd, void *arg);
+static void reap_children(void);
+static void add_usage(struct rusage *sum, const struct rusage *usage);
+static void send_reply(serve_connection *conn, const char *kind, int status, \
+		const struct rusage *usage);
+static void send_error(serve_connection *conn, const char *message);
+static void close_connection(serve_connection *conn);
+static parsed_line *parse_cache_get(const char *line);
+static parsed_line *copy_parsed(const char *line, uint64_t hash, \
+		command *command_array, int number_of_commands);
+static void parsed_line_release(parsed_line *p);
+static int is_blank(const char *line);
+
+/*The listening socket, the signalfd and the epoll fd of the loop.*/
+static int listen_fd = -1;
+static int signal_fd = -1;
+static int serve_epoll_fd = -1;
+
+/*Given to the commands for the stdio a client did not pass.*/
+static int dev_null = -1;
+
+static ilist connections = ILIST_INIT(connections);
+static ilist children = ILIST_INIT(children);
+static list_pool *child_pool = NULL;
+
+static parsed_line *parse_cache[PARSE_CACHE_SLOTS];
+static launch_paths *path_cache = NULL;
+
+
+/**
+ * serve_main() - Runs the server until it gets SIGINT or SIGTERM.
+ *
+ * @param path The path of the socket. An old socket at the path is removed.
+ * @return The exit status of mish, 0 if the server was stopped or 1 if it
+ * could not be started.
+ */
+int serve_main(const char *path){
+	struct epoll_event events[SERVE_EVENTS];
+	struct epoll_event ev = {0};
+
+	child_pool = list_pool_new(sizeof(serve_child), CHILD_POOL_SLAB);
+	path_cache = launch_paths_new(PATH_CACHE_SLOTS);
+	if(path_cache == NULL){
+		perror("serve.c");
+		exit(errno);
+	}
+	dev_null = open("/dev/null", O_RDWR | O_CLOEXEC);
+	serve_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(dev_null < 0 || serve_epoll_fd < 0 || open_signals() < 0 || \
+			open_socket(path) < 0){
+		perror(path);
+		return 1;
+	}
+
+	ev.events = EPOLLIN;
+	ev.data.ptr = &listen_fd;
+	epoll_ctl(serve_epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+	ev.data.ptr = &signal_fd;
+	epoll_ctl(serve_epoll_fd, EPOLL_CTL_ADD, signal_fd, &ev);
+
+	int stop = 0;
+	while(!stop){
+		int ready = epoll_wait(serve_epoll_fd, events, SERVE_EVENTS, -1);
+		if(ready < 0){
+			if(errno != EINTR){
+				perror("serve");
+				break;
+			}
+			continue;
+		}
+		for(int i = 0; i < ready; i++){
+			if(events[i].data.ptr == &listen_fd){
+				accept_connections();
+			}
+			else if(events[i].data.ptr == &signal_fd){
+				struct signalfd_siginfo info;
+				while(read(signal_fd, &info, sizeof(info)) == sizeof(info)){
+					if(info.ssi_signo != SIGCHLD){
+						stop = 1;
+					}
+				}
+				reap_children();
+			}
+			else{
+				read_request(events[i].data.ptr);
+			}
+		}
+	}
+
+	unlink(path);
+	return 0;
+}
+
+/**
+ * open_socket() - Creates the listening socket and binds it to the path.
+ *
+ * @param path The path of the socket.
+ * @return 0 on success or -1 on failure.
+ */
+static int open_socket(const char *path){
+	struct sockaddr_un addr = {0};
+	struct stat st;
+
+	if(strlen(path) >= sizeof(addr.sun_path)){
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	//Only a socket is removed, never a file given by mistake.
+	if(stat(path, &st) == 0 && S_ISSOCK(st.st_mode)){
+		unlink(path);
+	}
+
+	listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | \
+			SOCK_NONBLOCK, 0);
+	if(listen_fd < 0 || \
+			bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || \
+			listen(listen_fd, SERVE_BACKLOG) < 0){
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * open_signals() - Blocks SIGCHLD, SIGINT and SIGTERM and creates the
+ * signalfd which they are read from in the loop.
+ *
+ * @return 0 on success or -1 on failure.
+ */
+static int open_signals(void){
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	if(sigprocmask(SIG_BLOCK, &mask, NULL) < 0){
+		return -1;
+	}
+	signal_fd = signalfd(-1, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+	return signal_fd < 0 ? -1 : 0;
+}
+
+/**
+ * accept_connections() - Accepts every waiting client and adds it to the
+ * loop.
+ */
+static void accept_connections(void){
+	int fd;
+	while((fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC)) >= 0){
+		serve_connection *conn = calloc(1, sizeof(*conn));
+		if(conn == NULL){
+			perror("serve.c");
+			exit(errno);
+		}
+		conn->fd = fd;
+		ilist_append(&conn->link, &connections);
+
+		struct epoll_event ev = {0};
+		ev.events = EPOLLIN;
+		ev.data.ptr = conn;
+		epoll_ctl(serve_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+	}
+	if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+		perror("serve");
+	}
+}
+
+/**
+ * read_request() - Reads a request of a client, with the fds passed with
+ * it, and starts it. A client which has gone is closed.
+ *
+ * @param conn The connection.
+ */
+static void read_request(serve_connection *conn){
+	char line[MAXLINELEN + 1];
+	union{
+		char buf[CMSG_SPACE(sizeof(int) * SERVE_FDS)];
+		struct cmsghdr align;
+	}control;
+	struct iovec iov = {line, MAXLINELEN};
+	struct msghdr msg = {0};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	if(conn->busy){ //Only a hang up is reported while a request runs.
+		epoll_ctl(serve_epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+		conn->closed = 1;
+		return;
+	}
+
+	ssize_t n = recvmsg(conn->fd, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+	if(n < 0 && (errno == EAGAIN || errno == EINTR)){
+		return;
+	}
+	else if(n <= 0){
+		close_connection(conn);
+		return;
+	}
+
+	int fds[SERVE_FDS] = {dev_null, dev_null, dev_null};
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	if(cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET && \
+			cmsg->cmsg_type == SCM_RIGHTS){
+		int passed = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		memcpy(fds, CMSG_DATA(cmsg), passed * sizeof(int));
+	}
+
+	if(msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)){
+		for(int i = 0; i < SERVE_FDS; i++){
+			if(fds[i] != dev_null){
+				close(fds[i]);
+			}
+		}
+		send_error(conn, msg.msg_flags & MSG_TRUNC ? "line too long" : \
+				"too many file descriptors");
+		return;
+	}
+
+	line[n] = '\0';
+	if(n > 0 && line[n-1] == '\n'){
+		line[n-1] = '\0';
+	}
+	start_request(conn, line, fds);
+}
+
+/**
+ * start_request() - Starts running a line for a client. The connection is
+ * not read from until the request is done.
+ *
+ * @param conn The connection.
+ * @param line The command line.
+ * @param fds The stdin, stdout and stderr of the request.
+ */
+static void start_request(serve_connection *conn, char *line, int fds[]){
+	serve_request *r = &conn->request;
+	memset(r, 0, sizeof(*r));
+	memcpy(r->fds, fds, sizeof(r->fds));
+	r->run = 1;
+	conn->busy = 1;
+
+	struct epoll_event ev = {0};
+	ev.data.ptr = conn;
+	epoll_ctl(serve_epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+
+	if(!is_blank(line)){
+		r->parsed = parse_cache_get(line);
+		if(r->parsed == NULL){
+			send_error(conn, "syntax error");
+			end_request(conn);
+			return;
+		}
+		for(int i = 0; i < r->parsed->number_of_commands; i++){
+			if(r->parsed->commands[i].separator == SEP_FANOUT){
+				send_error(conn, "fan-out is not supported");
+				end_request(conn);
+				return;
+			}
+		}
+	}
+	advance_request(conn);
+}
+
+/**
+ * advance_request() - Starts the pipelines of a request up to the next one
+ * which must be waited for. A pipeline after "&&" or "||" is skipped like in
+ * the shell. The request is finished when it has no pipelines or children
+ * left.
+ *
+ * @param conn The connection.
+ */
+static void advance_request(serve_connection *conn){
+	serve_request *r = &conn->request;
+	int number_of_commands = r->parsed != NULL ? \
+			r->parsed->number_of_commands : 0;
+
+	while(r->waiting == 0 && r->next < number_of_commands){
+		command *command_array = r->parsed->commands;
+		int length = launch_pipeline_length(command_array + r->next, \
+				number_of_commands - r->next);
+		int end = r->next + length - 1;
+		int separator = command_array[end].separator;
+
+		if(r->run){
+			memset(&r->pipeline_usage, 0, sizeof(r->pipeline_usage));
+			if(start_pipeline(conn, command_array + r->next, length, \
+					separator != SEP_ASYNC) < 0){
+				r->status = LAUNCH_EXEC_FAILED;
+			}
+			else if(separator == SEP_ASYNC){
+				r->status = 0;
+			}
+		}
+		r->next = end + 1;
+		r->separator = separator;
+		if(r->waiting == 0){ //Skipped, started in the background or failed.
+			set_run(r);
+		}
+	}
+
+	if(r->waiting == 0 && r->running == 0){
+		finish_request(conn);
+	}
+}
+
+/**
+ * set_run() - Decides if the next pipeline is run from what followed the
+ * last one and its status, like the shell does.
+ *
+ * @param r The request.
+ */
+static void set_run(serve_request *r){
+	r->run = launch_runs_after(r->separator, r->status);
+}
+
+/**
+ * finish_request() - Answers that a request is done and ends it.
+ *
+ * @param conn The connection.
+ */
+static void finish_request(serve_connection *conn){
+	send_reply(conn, "exit", conn->request.status, \
+			&conn->request.total_usage);
+	end_request(conn);
+}
+
+/**
+ * end_request() - Ends a request and reads the next one, or frees the
+ * connection if the client has gone.
+ *
+ * @param conn The connection.
+ */
+static void end_request(serve_connection *conn){
+	serve_request *r = &conn->request;
+
+	for(int i = 0; i < SERVE_FDS; i++){
+		if(r->fds[i] != dev_null){
+			close(r->fds[i]);
+		}
+	}
+	if(r->parsed != NULL){
+		parsed_line_release(r->parsed);
+	}
+	memset(r, 0, sizeof(*r));
+	conn->busy = 0;
+
+	if(conn->closed){
+		close_connection(conn);
+		return;
+	}
+	struct epoll_event ev = {0};
+	ev.events = EPOLLIN;
+	ev.data.ptr = conn;
+	epoll_ctl(serve_epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+}
+
+/**
+ * start_pipeline() - Forks the commands of a pipeline connected by pipes
+ * with the launch core, see launch.h. The commands are found through the
+ * PATH cache of the server.
+ *
+ * @param conn The connection of the request.
+ * @param command_array An array with the commands of the pipeline.
+ * @param number_of_commands The number of commands in the array.
+ * @param foreground 1 if the request waits for the pipeline, else 0.
+ * @return 0 on success or -1 if not every command could be started.
+ */
+static int start_pipeline(serve_connection *conn, command *command_array, \
+		int number_of_commands, int foreground){
+	serve_request *r = &conn->request;
+	serve_launch launch = {conn, foreground};
+	launch_spec spec;
+
+	launch_spec_init(&spec);
+	spec.stdin_fd = r->fds[0];
+	spec.stdout_fd = r->fds[1];
+	spec.stderr_fd = r->fds[2];
+	spec.paths = path_cache;
+	spec.run_internal = run_stats;
+	spec.started = add_child;
+	spec.arg = &launch;
+	//Only the children which were started are waited for.
+	if(launch_pipeline(command_array, number_of_commands, &spec) < \
+			number_of_commands){
+		perror("serve");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * add_child() - Adds a forked command to its request, the started hook of
+ * the launch core.
+ *
+ * @param launched The forked command.
+ * @param arg The serve_launch of the pipeline.
+ */
+static void add_child(const launch_child *launched, void *arg){
+	const serve_launch *launch = arg;
+	serve_connection *conn = launch->conn;
+	serve_request *r = &conn->request;
+
+	stats_count(STATS_FORKS, 1);
+	stats_count(STATS_PATH_HITS, launched->path_hit);
+
+	serve_child *child = list_pool_alloc(child_pool);
+	child->pid = launched->pid;
+	child->conn = conn;
+	child->foreground = launch->foreground;
+	child->last_stage = launched->cmd->separator != SEP_PIPE;
+	ilist_append(&child->link, &children);
+	r->running++;
+	if(child->foreground){
+		r->waiting++;
+	}
+}
+
+/**
+ * run_stats() - Runs "stats" in its forked child, the run_internal hook of
+ * the launch core. The counters of the server are copied into the child with
+ * the fork. The server has no threads, so stdio is safe in the child.
+ *
+ * @param cmd The command.
+ * @param arg The serve_launch of the pipeline.
+ * @return The exit status of stats.
+ */
+static int run_stats(command *cmd, void *arg){
+	(void)arg;
+	int status = stats_main(cmd->argc, cmd->argv, stdout);
+	fflush(stdout);
+	return status;
+}
+
+/**
+ * reap_children() - Collects all children which have exited without
+ * blocking and moves their requests on.
+ */
+static void reap_children(void){
+	int wait_status;
+	struct rusage usage;
+	pid_t pid;
+
+	while((pid = wait4(-1, &wait_status, WNOHANG, &usage)) > 0){
+		list_link *current_link = ilist_first(&children);
+		while(current_link != NULL){
+			serve_child *child = ilist_entry(current_link, serve_child, link);
+			if(child->pid == pid){
+				break;
+			}
+			current_link = ilist_next(current_link, &children);
+		}
+		if(current_link == NULL){
+			continue;
+		}
+
+		serve_child *child = ilist_entry(current_link, serve_child, link);
+		serve_connection *conn = child->conn;
+		serve_request *r = &conn->request;
+		stats_count(STATS_REAPED, 1);
+		add_usage(&r->total_usage, &usage);
+		r->running--;
+		if(child->foreground){
+			add_usage(&r->pipeline_usage, &usage);
+			if(child->last_stage){
+				r->status = exit_status(wait_status);
+			}
+			r->waiting--;
+			if(r->waiting == 0){
+				send_reply(conn, "status", r->status, &r->pipeline_usage);
+				set_run(r);
+			}
+		}
+		ilist_remove(current_link);
+		list_pool_free(child, child_pool);
+
+		advance_request(conn);
+	}
+}
+
+/**
+ * add_usage() - Adds the times of a child to a sum and keeps the largest
+ * resident set.
+ *
+ * @param sum The sum.
+ * @param usage The usage of the child.
+ */
+static void add_usage(struct rusage *sum, const struct rusage *usage){
+	timeradd(&sum->ru_utime, &usage->ru_utime, &sum->ru_utime);
+	timeradd(&sum->ru_stime, &usage->ru_stime, &sum->ru_stime);
+	if(usage->ru_maxrss > sum->ru_maxrss){
+		sum->ru_maxrss = usage->ru_maxrss;
+	}
+}
+
+/**
+ * send_reply() - Sends a status and usage line to a client. A client which
+ * does not read its answers loses them.
+ *
+ * @param conn The connection.
+ * @param kind "status" or "exit".
+ * @param status The exit status.
+ * @param usage The usage of the children.
+ */
+static void send_reply(serve_connection *conn, const char *kind, int status, \
+		const struct rusage *usage){
+	char reply[REPLY_LEN];
+	if(conn->closed){
+		return;
+	}
+	int len = snprintf(reply, sizeof(reply), "%s %d %ld %ld %ld\n", kind, \
+			status, \
+			(long)(usage->ru_utime.tv_sec * 1000000 + usage->ru_utime.tv_usec), \
+			(long)(usage->ru_stime.tv_sec * 1000000 + usage->ru_stime.tv_usec), \
+			usage->ru_maxrss);
+	send(conn->fd, reply, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+/**
+ * send_error() - Sends an error line to a client.
+ *
+ * @param conn The connection.
+ * @param message What went wrong.
+ */
+static void send_error(serve_connection *conn, const char *message){
+	char reply[REPLY_LEN];
+	if(conn->closed){
+		return;
+	}
+	int len = snprintf(reply, sizeof(reply), "error %s\n", message);
+	send(conn->fd, reply, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+/**
+ * close_connection() - Closes the connection of a client and frees it. It
+ * must not have a request running.
+ *
+ * @param conn The connection.
+ */
+static void close_connection(serve_connection *conn){
+	close(conn->fd); //Also removes it from the epoll set.
+	ilist_remove(&conn->link);
+	free(conn);
+}
+
+/**
+ * parse_cache_get() - Gets a line parsed, from the cache if it was parsed
+ * before. A line which is parsed replaces the line in its slot.
+ *
+ * @param line The command line.
+ * @return The parsed line, which the caller must release, or NULL on a
+ * syntax error.
+ */
+static parsed_line *parse_cache_get(const char *line){
+	uint64_t hash = hash_string(line, HASH_SEED);
+	parsed_line **slot = &parse_cache[hash % PARSE_CACHE_SLOTS];
+
+	if(*slot != NULL && (*slot)->hash == hash && \
+			strcmp((*slot)->line, line) == 0){
+		stats_count(STATS_CACHE_HITS, 1);
+		(*slot)->users++;
+		return *slot;
+	}
+
+	command command_array[MAXCOMMANDS];
+	char *words[MAXWORDS];
+	char text[PARSE_TEXT_LEN];
+	uint64_t started = stats_now();
+	int number_of_commands = parse_r(line, command_array, text, words);
+	stats_time(STATS_PARSE_TIME, stats_now() - started);
+	stats_count(STATS_PARSED, 1);
+	if(number_of_commands == 0){
+		return NULL;
+	}
+	//Run by the forked child instead of executed, see run_stats().
+	for(int i = 0; i < number_of_commands; i++){
+		command_array[i].internal = strcmp(command_array[i].argv[0], \
+				"stats") == 0;
+	}
+
+	parsed_line *p = copy_parsed(line, hash, command_array, \
+			number_of_commands);
+	if(*slot != NULL){
+		parsed_line_release(*slot);
+	}
+	*slot = p;
+	p->users = 2; //The cache and the caller.
+	return p;
+}
+
+/**
+ * copy_parsed() - Copies the commands of a parsed line, with their words, to
+ * one block of memory.
+ *
+ * @param line The command line.
+ * @param hash The hash of the line.
+ * @param command_array The commands.
+ * @param number_of_commands The number of commands.
+ * @return The copy.
+ */
+static parsed_line *copy_parsed(const char *line, uint64_t hash, \
+		command *command_array, int number_of_commands){
+	size_t words = 0;
+	size_t text = strlen(line) + 1;
+	for(int i = 0; i < number_of_commands; i++){
+		command *cmd = &command_array[i];
+		words += cmd->argc + 1;
+		for(int j = 0; j < cmd->argc; j++){
+			text += strlen(cmd->argv[j]) + 1;
+		}
+		text += cmd->infile != NULL ? strlen(cmd->infile) + 1 : 0;
+		text += cmd->outfile != NULL ? strlen(cmd->outfile) + 1 : 0;
+	}
+
+	parsed_line *p = malloc(sizeof(*p) + number_of_commands * \
+			sizeof(command) + words * sizeof(char *) + text);
+	if(p == NULL){
+		perror("serve.c");
+		exit(errno);
+	}
+	p->hash = hash;
+	p->number_of_commands = number_of_commands;
+	p->commands = (command *)(p + 1);
+	char **word = (char **)(p->commands + number_of_commands);
+	char *cp = (char *)(word + words);
+
+	p->line = cp;
+	cp = stpcpy(cp, line) + 1;
+	for(int i = 0; i < number_of_commands; i++){
+		command *cmd = &p->commands[i];
+		*cmd = command_array[i];
+		cmd->argv = word;
+		for(int j = 0; j < cmd->argc; j++){
+			*word++ = cp;
+			cp = stpcpy(cp, command_array[i].argv[j]) + 1;
+		}
+		*word++ = NULL;
+		if(cmd->infile != NULL){
+			cmd->infile = cp;
+			cp = stpcpy(cp, command_array[i].infile) + 1;
+		}
+		if(cmd->outfile != NULL){
+			cmd->outfile = cp;
+			cp = stpcpy(cp, command_array[i].outfile) + 1;
+		}
+	}
+	return p;
+}
+
+/**
+ * parsed_line_release() - Drops one user of a parsed line and frees it when
+ * it has none left.
+ *
+ * @param p The parsed line.
+ */
+static void parsed_line_release(parsed_line *p){
+	p->users--;
+	if(p->users == 0){
+		free(p);
+	}
+}
+
+/**
+ * is_blank() - Checks if a line has nothing but whitespace.
+ *
+ * @param line The line.
+ * @return 1 if the line is blank, else 0.
+ */
+static int is_blank(const char *line){
+	for(; *line != '\0'; line++){
+		if(!isspace((unsigned char)*line)){
+			return 0;
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,52 @@
+/*
+ * serve.h Is the header file for the server mode of mish:
+ *
+ *   mish --serve SOCKET
+ *
+ * The server listens on a SOCK_SEQPACKET Unix socket at the path SOCKET and
+ * runs command lines sent to it, so a program which starts many short
+ * commands does not pay for starting a shell every time. Many clients are
+ * served at once by one epoll loop, which also reaps the children through a
+ * signalfd.
+ *
+ * A request is one message with the command line, and up to three file
+ * descriptors passed with SCM_RIGHTS, which become the stdin, stdout and
+ * stderr of the commands in that order. A descriptor which is not passed is
+ * /dev/null. The line may have pipelines separated by "|", ";", "&&", "||"
+ * and "&", and redirections with "<" and ">". Only external commands and
+ * "stats" are run, there are no variables, compound commands or fan-outs. A
+ * connection runs one request at a time, the next message is read when the
+ * request is done.
+ *
+ * The server answers with one line per message:
+ *
+ *   status STATUS USER_US SYSTEM_US MAXRSS_KB	when a pipeline has finished
+ *   exit STATUS USER_US SYSTEM_US MAXRSS_KB	when the whole line is done
+ *   error MESSAGE				when the line can not be run
+ *
+ * The times are the summed user and system time of the children in
+ * microseconds, and MAXRSS_KB the largest resident set of any of them.
+ *
+ * The commands are started by the launch core of mish, like in the shell,
+ * see launch.h. The parsed lines are kept in a cache keyed by the text of the
+ * line, and the paths which commands were found at in PATH in the cache of
+ * the core, both shared by all clients. The server stops and removes the
+ * socket on SIGINT or SIGTERM.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef SERVE_H_
+#define SERVE_H_
+
+/**
+ * serve_main() - Runs the server until it gets SIGINT or SIGTERM.
+ *
+ * @param path The path of the socket. An old socket at the path is removed.
+ * @return The exit status of mish, 0 if the server was stopped or 1 if it
+ * could not be started.
+ */
+int serve_main(const char *path);
+
+#endif /* SERVE_H_ */
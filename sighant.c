@@ -1,8 +1,7 @@
 /*
  * sighant.c Is the source code for the signalhandler of mish. Here the
- * sigaction struct is setup to catch an interrupt and pass it on to the
- * children of the shell. The pids of these children are assumed to be saved
- * in the current_shell_children list.
+ * sigaction struct is setup to catch an interrupt and the changes of state of
+ * the children of the shell.
  *
  *  Created on: 10 Oct 2018
  *      Author: Bram Coenen (tfy15bcn)
@@ -15,30 +14,46 @@
 #include <stdio.h>
 #include <signal.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
+/*Global variables declared in the header. */
+int shell_signal_pipe[2] = {-1, -1};
+volatile sig_atomic_t shell_interrupted = 0;
+volatile sig_atomic_t shell_interrupt_pending = 0;
 
 /**
  * shell_signal_handler() - The handler which the signal will be passed along to
- *  by sigaction. If the signal is an interrupt, a function will be call which
- *  will kill all the child processes. Else the default action should occur.
+ *  by sigaction. If the signal is an interrupt, the interrupt flags are set.
+ *  In both cases the shell is woken up through shell_signal_pipe.
  *
  *  @param signo The identifier of the signal.
  */
 void shell_signal_handler(int signo){
+	int saved_errno = errno;
+	char byte = 0;
+
 	if(signo == SIGINT){
-		kill_children();
+		shell_interrupted = 1;
+		shell_interrupt_pending = 1;
 	}
-
+	//The pipe is non-blocking, a full pipe already wakes the shell.
+	ssize_t ret = write(shell_signal_pipe[1], &byte, 1);
+	(void)ret;
+	errno = saved_errno;
 }
 
 /**
- * setup_signal_handling() - Sets up sigaction so the interrupt signal will be
- * sent to the handler. The default action should occur for all the other
- * signals.
+ * setup_signal_handling() - Sets up sigaction so the interrupt and child
+ * signals will be sent to the handler and creates shell_signal_pipe. The
+ * default action should occur for all the other signals.
  */
 void setup_signal_handling(void){
 	struct sigaction new_action, old_action;
 
+	  if (pipe2(shell_signal_pipe, O_NONBLOCK | O_CLOEXEC) < 0)
+	    perror("Signal pipe");
+
 	  /* Set up the structure to specify the new action. */
 	  new_action.sa_handler = shell_signal_handler;
 	  sigemptyset (&new_action.sa_mask);
@@ -47,26 +62,56 @@ void setup_signal_handling(void){
 	  sigaction (SIGINT, NULL, &old_action);
 	  if (old_action.sa_handler != SIG_IGN)
 	    sigaction (SIGINT, &new_action, NULL);
+
+	  /* Children are waited for without interrupting reads of the input. A
+	   * stopped child also wakes the shell. */
+	  new_action.sa_flags = SA_RESTART;
+	  sigaction (SIGCHLD, &new_action, NULL);
 }
 
 /**
- * kill_children() - Steps through the entire list with the pids of the
- * childprocesses and sends an interrupt signal.
+ * ignore_job_control_signals() - Makes the shell ignore the stop signals from
+ * the terminal and the signals for using it from the background.
  */
-void kill_children(void){
-	list_pos first_pos = list_get_first_position(current_shell_children);
-	list_pos current_pos = \
-	list_get_previous_position(list_get_last_position(current_shell_children), \
-			current_shell_children);
-
-	while(current_pos != first_pos){
-		pid_t child_pid = *(pid_t *)list_get_value(current_pos);
-		//printf("Child pid: %d", child_pid);
-		int ret = kill(child_pid, SIGINT);
-		if(ret < 0){
-			perror("Killed child process");
-		}
-		current_pos = list_get_previous_position(current_pos, \
-												current_shell_children);
+void ignore_job_control_signals(void){
+	struct sigaction action;
+
+	action.sa_handler = SIG_IGN;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = 0;
+	sigaction(SIGTSTP, &action, NULL);
+	sigaction(SIGTTIN, &action, NULL);
+	sigaction(SIGTTOU, &action, NULL);
+}
+
+/**
+ * reset_shell_handlers() - Gives a forked child which does not execute a
+ * command the default action for the signals the shell handles.
+ */
+void reset_shell_handlers(void){
+	struct sigaction action, old_action;
+
+	action.sa_handler = SIG_DFL;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = 0;
+	sigaction(SIGINT, NULL, &old_action);
+	if(old_action.sa_handler == shell_signal_handler){
+		sigaction(SIGINT, &action, NULL);
 	}
+	sigaction(SIGCHLD, &action, NULL);
+}
+
+/**
+ * reset_child_signals() - Gives a forked child the default action for the
+ * signals which the shell ignores for job control.
+ */
+void reset_child_signals(void){
+	struct sigaction action;
+
+	action.sa_handler = SIG_DFL;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = 0;
+	sigaction(SIGTSTP, &action, NULL);
+	sigaction(SIGTTIN, &action, NULL);
+	sigaction(SIGTTOU, &action, NULL);
 }
@@ -1,8 +1,12 @@
 /*
  * signhant.h Is the header file for the signalhandler of mish. Here the
- * sigaction struct is setup to catch an interrupt and pass it on to the
- * children of the shell. The pids of these children are assumed to be saved
- * in the current_shell_children list.
+ * sigaction struct is setup to catch an interrupt and the changes of state of
+ * the children of the shell.
+ *
+ * The handler only sets flags and writes a byte to shell_signal_pipe, so the
+ * shell can wait for children together with other file descriptors. With job
+ * control the terminal sends an interrupt to the foreground pipeline itself,
+ * else the shell passes it on to the jobs from its wait loop.
  *
  *  Created on: 10 Oct 2018
  *      Author: Bram Coenen (tfy15bcn)
@@ -11,32 +15,52 @@
 #ifndef SIGHANT_H_
 #define SIGHANT_H_
 
-#include "list.h"
+#include "jobs.h"
+
+#include <signal.h>
+
+/*Global variable for the self-pipe which is written to on SIGCHLD.*/
+extern int shell_signal_pipe[2];
 
-/*Global variable for the list where the childrens pids should be saved.*/
-struct list *current_shell_children;
+/*Global variable which is set on an interrupt, so loops can stop.*/
+extern volatile sig_atomic_t shell_interrupted;
+
+/*Global variable which is set on an interrupt until it is passed on.*/
+extern volatile sig_atomic_t shell_interrupt_pending;
 
 
 /**
  * shell_signal_handler() - The handler which the signal will be passed along to
- *  by sigaction. If the signal is an interrupt, a function will be call which
- *  will kill all the child processes. Else the default action should occur.
+ *  by sigaction. If the signal is an interrupt, the interrupt flags are set.
+ *  In both cases the shell is woken up through shell_signal_pipe.
  *
  *  @param signo The identifier of the signal.
  */
 void shell_signal_handler(int signo);
 
 /**
- * setup_signal_handling() - Sets up sigaction so the interrupt signal will be
- * sent to the handler. The default action should occur for all the other
- * signals.
+ * setup_signal_handling() - Sets up sigaction so the interrupt and child
+ * signals will be sent to the handler and creates shell_signal_pipe. The
+ * default action should occur for all the other signals.
  */
 void setup_signal_handling(void);
 
 /**
- * kill_children() - Steps through the entire list with the pids of the
- * childprocesses and sends an interrupt signal.
+ * ignore_job_control_signals() - Makes the shell ignore the stop signals from
+ * the terminal and the signals for using it from the background.
+ */
+void ignore_job_control_signals(void);
+
+/**
+ * reset_shell_handlers() - Gives a forked child which does not execute a
+ * command the default action for the signals the shell handles.
+ */
+void reset_shell_handlers(void);
+
+/**
+ * reset_child_signals() - Gives a forked child the default action for the
+ * signals which the shell ignores for job control.
  */
-void kill_children(void);
+void reset_child_signals(void);
 
 #endif /* SIGHANT_H_ */
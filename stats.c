@@ -0,0 +1,243 @@
+/*
+ * stats.c Is the source code for the counters and latency histograms of mish.
+ * See the header file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "stats.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <pthread.h>
+
+/* Defines */
+#define NSEC_PER_SEC 1000000000L
+
+/*A latency histogram.*/
+typedef struct latency_histogram{
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t buckets[STATS_BUCKETS];
+}latency_histogram;
+
+/*Function prototypes.*/
+static uint64_t percentile(const latency_histogram *h, int percent);
+static void print_text(FILE *out);
+static void print_json(FILE *out);
+
+/*The names of the counters and histograms, in the order of the defines.*/
+static const char *const counter_names[STATS_COUNTERS] = {"parsed", \
+		"cache_hits", "forks", "exec_failures", "reaped", "path_hits"};
+static const char *const histogram_names[STATS_HISTOGRAMS] = {"parse", \
+		"spawn", "pipeline"};
+
+static uint64_t counters[STATS_COUNTERS];
+static latency_histogram histograms[STATS_HISTOGRAMS];
+static pthread_mutex_t getopt_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/**
+ * stats_count() - Adds to a counter.
+ *
+ * @param counter The counter.
+ * @param n The amount to add.
+ */
+void stats_count(int counter, uint64_t n){
+	counters[counter] += n;
+}
+
+/**
+ * stats_time() - Adds a latency to a histogram.
+ *
+ * @param histogram The histogram.
+ * @param nsec The latency in nanoseconds.
+ */
+void stats_time(int histogram, uint64_t nsec){
+	latency_histogram *h = &histograms[histogram];
+	h->count++;
+	h->sum += nsec;
+	if(nsec > h->max){
+		h->max = nsec;
+	}
+	h->buckets[63 - __builtin_clzll(nsec | 1)]++;
+}
+
+/**
+ * stats_now() - Gets the time of the monotonic clock, for latencies.
+ *
+ * @return The time in nanoseconds.
+ */
+uint64_t stats_now(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
+
+/**
+ * stats_format_time() - Writes a time with a unit which keeps it short.
+ *
+ * @param text The buffer, STATS_TIME_TEXT_LEN long.
+ * @param nsec The time in nanoseconds.
+ */
+void stats_format_time(char *text, uint64_t nsec){
+	if(nsec < 1000){
+		snprintf(text, STATS_TIME_TEXT_LEN, "%luns", (unsigned long)nsec);
+	}
+	else if(nsec < 1000000){
+		snprintf(text, STATS_TIME_TEXT_LEN, "%.1fus", nsec / 1e3);
+	}
+	else if(nsec < NSEC_PER_SEC){
+		snprintf(text, STATS_TIME_TEXT_LEN, "%.1fms", nsec / 1e6);
+	}
+	else{
+		snprintf(text, STATS_TIME_TEXT_LEN, "%.2fs", nsec / 1e9);
+	}
+}
+
+/**
+ * stats_main() - Runs the stats builtin, see the usage in the header.
+ *
+ * @param argc The number of words, starting with "stats".
+ * @param argv The words.
+ * @param out The stream to print to.
+ * @return The exit status of the builtin.
+ */
+int stats_main(int argc, char **argv, FILE *out){
+	int json = 0;
+	int reset = 0;
+	int opt;
+
+	//getopt() keeps its state in globals and stats may run as a thread.
+	pthread_mutex_lock(&getopt_lock);
+	optind = 0;
+	while((opt = getopt(argc, argv, "+jr")) != -1){
+		switch(opt){
+		case 'j':
+			json = 1;
+			break;
+		case 'r':
+			reset = 1;
+			break;
+		default:
+			pthread_mutex_unlock(&getopt_lock);
+			fprintf(stderr, "Usage: stats [-j] [-r]\n");
+			return 1;
+		}
+	}
+	int operands = argc - optind;
+	pthread_mutex_unlock(&getopt_lock);
+	if(operands > 0){
+		fprintf(stderr, "Usage: stats [-j] [-r]\n");
+		return 1;
+	}
+
+	if(json){
+		print_json(out);
+	}
+	else{
+		print_text(out);
+	}
+	fflush(out);
+
+	if(reset){
+		memset(counters, 0, sizeof(counters));
+		memset(histograms, 0, sizeof(histograms));
+	}
+	return 0;
+}
+
+/**
+ * percentile() - Reads a percentile from the buckets of a histogram. The
+ * upper bound of the bucket is given, but never more than the largest time.
+ *
+ * @param h The histogram.
+ * @param percent The percentile, 1 to 100.
+ * @return The percentile in nanoseconds, 0 for an empty histogram.
+ */
+static uint64_t percentile(const latency_histogram *h, int percent){
+	//The rank of the sample, rounded up.
+	uint64_t rank = (h->count * percent + 99) / 100;
+	uint64_t seen = 0;
+
+	for(int i = 0; i < STATS_BUCKETS && rank > 0; i++){
+		seen += h->buckets[i];
+		if(seen >= rank){
+			uint64_t bound = i < STATS_BUCKETS - 1 ? (uint64_t)2 << i : \
+					UINT64_MAX;
+			return bound < h->max ? bound : h->max;
+		}
+	}
+	return 0;
+}
+
+/**
+ * print_text() - Prints the counters and histograms as a table.
+ *
+ * @param out The stream to print to.
+ */
+static void print_text(FILE *out){
+	for(int i = 0; i < STATS_COUNTERS; i++){
+		fprintf(out, "%-16s%llu\n", counter_names[i], \
+				(unsigned long long)counters[i]);
+	}
+
+	fprintf(out, "\n%-16s%10s%10s%10s%10s%10s\n", "latency", "count", \
+			"mean", "p50", "p99", "max");
+	for(int i = 0; i < STATS_HISTOGRAMS; i++){
+		const latency_histogram *h = &histograms[i];
+		char mean[STATS_TIME_TEXT_LEN];
+		char p50[STATS_TIME_TEXT_LEN];
+		char p99[STATS_TIME_TEXT_LEN];
+		char max[STATS_TIME_TEXT_LEN];
+		stats_format_time(mean, h->count > 0 ? h->sum / h->count : 0);
+		stats_format_time(p50, percentile(h, 50));
+		stats_format_time(p99, percentile(h, 99));
+		stats_format_time(max, h->max);
+		fprintf(out, "%-16s%10llu%10s%10s%10s%10s\n", histogram_names[i], \
+				(unsigned long long)h->count, mean, p50, p99, max);
+	}
+}
+
+/**
+ * print_json() - Prints the counters and histograms as one JSON object. The
+ * times are in nanoseconds.
+ *
+ * @param out The stream to print to.
+ */
+static void print_json(FILE *out){
+	fprintf(out, "{\"counters\":{");
+	for(int i = 0; i < STATS_COUNTERS; i++){
+		fprintf(out, "%s\"%s\":%llu", i > 0 ? "," : "", counter_names[i], \
+				(unsigned long long)counters[i]);
+	}
+
+	fprintf(out, "},\"latency_ns\":{");
+	for(int i = 0; i < STATS_HISTOGRAMS; i++){
+		const latency_histogram *h = &histograms[i];
+		fprintf(out, "%s\"%s\":{\"count\":%llu,\"mean\":%llu,\"p50\":%llu,"
+				"\"p99\":%llu,\"max\":%llu,\"buckets\":[", i > 0 ? "," : "", \
+				histogram_names[i], (unsigned long long)h->count, \
+				(unsigned long long)(h->count > 0 ? h->sum / h->count : 0), \
+				(unsigned long long)percentile(h, 50), \
+				(unsigned long long)percentile(h, 99), \
+				(unsigned long long)h->max);
+		//Only up to the last bucket which is used.
+		int used = STATS_BUCKETS;
+		while(used > 0 && h->buckets[used-1] == 0){
+			used--;
+		}
+		for(int j = 0; j < used; j++){
+			fprintf(out, "%s%llu", j > 0 ? "," : "", \
+					(unsigned long long)h->buckets[j]);
+		}
+		fprintf(out, "]}");
+	}
+	fprintf(out, "}}\n");
+}
@@ -0,0 +1,90 @@
+/*
+ * stats.h Is the header file for the counters and latency histograms of mish.
+ * The shell counts what it does while it runs, like the lines it parses, the
+ * children it forks and reaps and the commands which could not be executed.
+ * The counters are plain integers which are only added to, so counting costs
+ * next to nothing.
+ *
+ * Latencies are kept in histograms with one bucket per power of two
+ * nanoseconds. Adding a sample is one count in a bucket, and the percentiles
+ * are read from the buckets, so p50 and p99 are known within a factor of two.
+ *
+ * The builtin prints them as text or JSON:
+ *
+ *   stats [-j] [-r]
+ *
+ * -j prints JSON instead of text and -r resets everything after printing.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*The counters.*/
+#define STATS_PARSED		0	//Lines parsed.
+#define STATS_CACHE_HITS	1	//Lines taken parsed from a cache.
+#define STATS_FORKS		2	//Processes forked.
+#define STATS_EXEC_FAILURES	3	//Children which could not be executed.
+#define STATS_REAPED		4	//Children which exited and were reaped.
+#define STATS_PATH_HITS		5	//Commands found in the PATH cache, see launch.h.
+#define STATS_COUNTERS		6
+
+/*The latency histograms.*/
+#define STATS_PARSE_TIME	0	//Parsing a line.
+#define STATS_SPAWN_TIME	1	//From fork to exec of a child.
+#define STATS_PIPELINE_TIME	2	//From start to end of a pipeline.
+#define STATS_HISTOGRAMS	3
+
+/*The number of buckets, bucket i holds the times below 2^(i+1) ns.*/
+#define STATS_BUCKETS 64
+
+/*The length of the text of a time, see stats_format_time().*/
+#define STATS_TIME_TEXT_LEN 32
+
+/**
+ * stats_count() - Adds to a counter.
+ *
+ * @param counter The counter.
+ * @param n The amount to add.
+ */
+void stats_count(int counter, uint64_t n);
+
+/**
+ * stats_time() - Adds a latency to a histogram.
+ *
+ * @param histogram The histogram.
+ * @param nsec The latency in nanoseconds.
+ */
+void stats_time(int histogram, uint64_t nsec);
+
+/**
+ * stats_now() - Gets the time of the monotonic clock, for latencies.
+ *
+ * @return The time in nanoseconds.
+ */
+uint64_t stats_now(void);
+
+/**
+ * stats_format_time() - Writes a time with a unit which keeps it short.
+ *
+ * @param text The buffer, STATS_TIME_TEXT_LEN long.
+ * @param nsec The time in nanoseconds.
+ */
+void stats_format_time(char *text, uint64_t nsec);
+
+/**
+ * stats_main() - Runs the stats builtin, see the usage above.
+ *
+ * @param argc The number of words, starting with "stats".
+ * @param argv The words.
+ * @param out The stream to print to.
+ * @return The exit status of the builtin.
+ */
+int stats_main(int argc, char **argv, FILE *out);
+
+#endif /* STATS_H_ */
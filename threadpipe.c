@@ -0,0 +1,225 @@
+/*
+ * threadpipe.c Is the source code for the in-process pipes of mish. See the
+ * header file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "threadpipe.h"
+
+/*Include default libraries */
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+
+/*Function prototypes.*/
+static ssize_t pipe_write(void *cookie, const char *buf, size_t size);
+static ssize_t pipe_read(void *cookie, char *buf, size_t size);
+static int close_writer(void *cookie);
+static int close_reader(void *cookie);
+static int writer_may_run(thread_pipe *p);
+static int reader_may_run(thread_pipe *p);
+static void wait_for_change(thread_pipe *p, int is_reader);
+static void notify(thread_pipe *p);
+
+
+/**
+ * thread_pipe_init() - Creates a thread pipe.
+ *
+ * @param p The pipe.
+ * @return 0 on success or -1 on failure.
+ */
+int thread_pipe_init(thread_pipe *p){
+	memset(p, 0, sizeof(*p));
+	if(ring_init(&p->ring, THREAD_PIPE_SIZE) < 0){
+		return -1;
+	}
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->changed, NULL);
+	return 0;
+}
+
+/**
+ * thread_pipe_destroy() - Frees a thread pipe whose ends are closed.
+ *
+ * @param p The pipe.
+ */
+void thread_pipe_destroy(thread_pipe *p){
+	pthread_cond_destroy(&p->changed);
+	pthread_mutex_destroy(&p->lock);
+	ring_destroy(&p->ring);
+}
+
+/**
+ * thread_pipe_writer() - Opens the write end of a thread pipe. Closing the
+ * stream closes the end.
+ *
+ * @param p The pipe.
+ * @return The stream or NULL on failure.
+ */
+FILE *thread_pipe_writer(thread_pipe *p){
+	cookie_io_functions_t io = {NULL, pipe_write, NULL, close_writer};
+	return fopencookie(p, "w", io);
+}
+
+/**
+ * thread_pipe_reader() - Opens the read end of a thread pipe. Closing the
+ * stream closes the end.
+ *
+ * @param p The pipe.
+ * @return The stream or NULL on failure.
+ */
+FILE *thread_pipe_reader(thread_pipe *p){
+	cookie_io_functions_t io = {pipe_read, NULL, NULL, close_reader};
+	return fopencookie(p, "r", io);
+}
+
+/**
+ * pipe_write() - Writes to the ring, waiting while it is full, like write()
+ * on a pipe.
+ *
+ * @param cookie The pipe.
+ * @param buf The data.
+ * @param size The length of the data.
+ * @return The number of bytes written, or 0 with errno set to EPIPE if the
+ * read end is closed.
+ */
+static ssize_t pipe_write(void *cookie, const char *buf, size_t size){
+	thread_pipe *p = cookie;
+	size_t written = 0;
+
+	while(written < size){
+		if(!writer_may_run(p)){
+			wait_for_change(p, 0);
+			continue;
+		}
+		if(atomic_load(&p->read_closed)){
+			errno = EPIPE;
+			return written;
+		}
+
+		size_t len;
+		char *space = ring_write_region(&p->ring, &len);
+		if(len > size - written){
+			len = size - written;
+		}
+		memcpy(space, buf + written, len);
+		ring_commit_write(&p->ring, len);
+		written += len;
+		notify(p);
+	}
+	return written;
+}
+
+/**
+ * pipe_read() - Reads from the ring, waiting while it is empty, like read()
+ * on a pipe.
+ *
+ * @param cookie The pipe.
+ * @param buf The buffer.
+ * @param size The size of the buffer.
+ * @return The number of bytes read, 0 at end of file.
+ */
+static ssize_t pipe_read(void *cookie, char *buf, size_t size){
+	thread_pipe *p = cookie;
+
+	while(!reader_may_run(p)){
+		wait_for_change(p, 1);
+	}
+
+	size_t len;
+	char *data = ring_read_region(&p->ring, &len);
+	if(len > size){
+		len = size;
+	}
+	memcpy(buf, data, len);
+	ring_commit_read(&p->ring, len);
+	notify(p);
+	return len;
+}
+
+/**
+ * close_writer() - Closes the write end, the reader gets end of file when it
+ * has read the rest.
+ *
+ * @param cookie The pipe.
+ * @return 0.
+ */
+static int close_writer(void *cookie){
+	thread_pipe *p = cookie;
+	atomic_store(&p->write_closed, 1);
+	notify(p);
+	return 0;
+}
+
+/**
+ * close_reader() - Closes the read end, the writer fails from then on.
+ *
+ * @param cookie The pipe.
+ * @return 0.
+ */
+static int close_reader(void *cookie){
+	thread_pipe *p = cookie;
+	atomic_store(&p->read_closed, 1);
+	notify(p);
+	return 0;
+}
+
+/**
+ * writer_may_run() - Checks if the writer can go on, which it can when the
+ * ring has room or the reader is gone.
+ *
+ * @param p The pipe.
+ * @return 1 if the writer can go on, else 0.
+ */
+static int writer_may_run(thread_pipe *p){
+	return ring_fill(&p->ring) < p->ring.size || \
+			atomic_load(&p->read_closed);
+}
+
+/**
+ * reader_may_run() - Checks if the reader can go on, which it can when the
+ * ring has data or the writer is gone.
+ *
+ * @param p The pipe.
+ * @return 1 if the reader can go on, else 0.
+ */
+static int reader_may_run(thread_pipe *p){
+	//The writer commits its data before it closes, so none is lost.
+	return atomic_load(&p->write_closed) || ring_fill(&p->ring) > 0;
+}
+
+/**
+ * wait_for_change() - Sleeps until the thread may go on, like in buffer.c.
+ * The sleeper count is raised before the condition is checked again, and
+ * the other end changes the ring before it reads the count, so a wakeup is
+ * never lost.
+ *
+ * @param p The pipe.
+ * @param is_reader 1 for the reader, 0 for the writer.
+ */
+static void wait_for_change(thread_pipe *p, int is_reader){
+	pthread_mutex_lock(&p->lock);
+	atomic_fetch_add(&p->sleepers, 1);
+	while(is_reader ? !reader_may_run(p) : !writer_may_run(p)){
+		pthread_cond_wait(&p->changed, &p->lock);
+	}
+	atomic_fetch_sub(&p->sleepers, 1);
+	pthread_mutex_unlock(&p->lock);
+}
+
+/**
+ * notify() - Wakes the other end if it sleeps. The lock is only taken when
+ * a thread sleeps, so the data path stays free of locks.
+ *
+ * @param p The pipe.
+ */
+static void notify(thread_pipe *p){
+	if(atomic_load(&p->sleepers) > 0){
+		pthread_mutex_lock(&p->lock);
+		pthread_cond_broadcast(&p->changed);
+		pthread_mutex_unlock(&p->lock);
+	}
+}
@@ -0,0 +1,70 @@
+/*
+ * threadpipe.h Is the header file for the in-process pipes of mish. A thread
+ * pipe connects two threads like a pipe connects two processes, through a
+ * ring buffer in memory instead of the kernel, see ring.h. Both ends are
+ * opened as stdio streams, so a builtin writes to it and reads from it like
+ * from any FILE.
+ *
+ * The semantics follow a pipe. A writer blocks while the ring is full and a
+ * reader blocks while it is empty. When the write end is closed, the reader
+ * gets the rest of the data and then end of file. When the read end is
+ * closed, every write fails with EPIPE.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef THREADPIPE_H_
+#define THREADPIPE_H_
+
+#include "ring.h"
+
+#include <stdio.h>
+#include <pthread.h>
+
+/*The size of the ring, the same as the default size of a pipe.*/
+#define THREAD_PIPE_SIZE 65536
+
+typedef struct thread_pipe{
+	ring ring;
+	atomic_int write_closed;
+	atomic_int read_closed;
+	atomic_int sleepers;	//Threads waiting on changed.
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+}thread_pipe;
+
+/**
+ * thread_pipe_init() - Creates a thread pipe.
+ *
+ * @param p The pipe.
+ * @return 0 on success or -1 on failure.
+ */
+int thread_pipe_init(thread_pipe *p);
+
+/**
+ * thread_pipe_destroy() - Frees a thread pipe whose ends are closed.
+ *
+ * @param p The pipe.
+ */
+void thread_pipe_destroy(thread_pipe *p);
+
+/**
+ * thread_pipe_writer() - Opens the write end of a thread pipe. Closing the
+ * stream closes the end.
+ *
+ * @param p The pipe.
+ * @return The stream or NULL on failure.
+ */
+FILE *thread_pipe_writer(thread_pipe *p);
+
+/**
+ * thread_pipe_reader() - Opens the read end of a thread pipe. Closing the
+ * stream closes the end.
+ *
+ * @param p The pipe.
+ * @return The stream or NULL on failure.
+ */
+FILE *thread_pipe_reader(thread_pipe *p);
+
+#endif /* THREADPIPE_H_ */
@@ -0,0 +1,299 @@
+/*
+ * timeout.c Is the source code for the timeout prefix of mish. See the header
+ * file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "timeout.h"
+#include "list.h"
+#include "sighant.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+/* Defines */
+#define NSEC_PER_SEC 1000000000L
+
+/*The states of a timed job.*/
+#define TIMED_RUNNING	0	//The timer runs for the duration.
+#define TIMED_TERMINATED	1	//SIGTERM is sent, the grace period runs.
+#define TIMED_KILLED	2	//SIGKILL is sent.
+
+/*A job with a deadline.*/
+typedef struct timed_job{
+	list_link link;
+	int fd;
+	int job_id;
+	int state;
+	timeout_spec spec;
+}timed_job;
+
+/*Function prototypes.*/
+static int arm_timer(int fd, const struct timespec *when);
+static void signal_job(timed_job *job, int signo, const char *signame);
+static void remove_timed_job(timed_job *job);
+
+/*The jobs which have a running timer.*/
+static ilist timed_jobs = ILIST_INIT(timed_jobs);
+
+
+/**
+ * timeout_parse() - Parses the options and duration of the timeout prefix.
+ *
+ * @param spec The timeout to fill in.
+ * @param argc The number of words, starting with "timeout".
+ * @param argv The words.
+ * @return The number of words used by the prefix, or -1 on a bad option or
+ * duration.
+ */
+int timeout_parse(timeout_spec *spec, int argc, char **argv){
+	memset(spec, 0, sizeof(*spec));
+	spec->grace.tv_sec = TIMEOUT_DEFAULT_GRACE_SEC;
+
+	int opt;
+	optind = 0;
+	while((opt = getopt(argc, argv, "+k:")) != -1){
+		switch(opt){
+		case 'k':
+			if(parse_duration(optarg, &spec->grace) < 0){
+				fprintf(stderr, "timeout: bad grace period: %s\n", optarg);
+				return -1;
+			}
+			break;
+		default:
+			fprintf(stderr, "Usage: timeout [-k GRACE] DURATION pipeline\n");
+			return -1;
+		}
+	}
+
+	if(optind >= argc){
+		fprintf(stderr, "Usage: timeout [-k GRACE] DURATION pipeline\n");
+		return -1;
+	}
+	if(parse_duration(argv[optind], &spec->duration) < 0 || \
+			(spec->duration.tv_sec == 0 && spec->duration.tv_nsec == 0)){
+		fprintf(stderr, "timeout: bad duration: %s\n", argv[optind]);
+		return -1;
+	}
+	return optind + 1;
+}
+
+/**
+ * parse_duration() - Parses a duration like "1.5", "200ms", "10s", "2m" or
+ * "1h". "nan", "inf" and durations longer than DURATION_MAX_SEC are bad, so
+ * the conversion to a timespec is always in range.
+ *
+ * @param text The text to parse.
+ * @param duration The parsed duration.
+ * @return 0 on success or -1 on a bad duration.
+ */
+int parse_duration(const char *text, struct timespec *duration){
+	char *unit;
+	errno = 0;
+	double value = strtod(text, &unit);
+	if(errno != 0 || unit == text || !isfinite(value) || value < 0){
+		return -1;
+	}
+
+	if(strcmp(unit, "ms") == 0){
+		value /= 1000;
+	}
+	else if(strcmp(unit, "m") == 0){
+		value *= 60;
+	}
+	else if(strcmp(unit, "h") == 0){
+		value *= 3600;
+	}
+	else if(strcmp(unit, "s") != 0 && *unit != '\0'){
+		return -1;
+	}
+	if(value > DURATION_MAX_SEC){
+		return -1;
+	}
+
+	duration->tv_sec = (time_t)value;
+	duration->tv_nsec = (long)((value - duration->tv_sec) * NSEC_PER_SEC);
+	return 0;
+}
+
+/**
+ * timeout_start() - Arms the timer for a started job and adds it to the wait
+ * loop.
+ *
+ * @param spec The timeout of the job.
+ * @param job_id The id of the job, which its children are tagged with.
+ * @param epoll_fd The epoll file descriptor of the wait loop.
+ * @return 0 on success or -1 on failure.
+ */
+int timeout_start(const timeout_spec *spec, int job_id, int epoll_fd){
+	timed_job *job = calloc(1, sizeof(*job));
+	if(job == NULL){
+		perror("timeout");
+		return -1;
+	}
+	job->job_id = job_id;
+	job->spec = *spec;
+	job->state = TIMED_RUNNING;
+
+	job->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(job->fd < 0){
+		perror("timerfd_create");
+		free(job);
+		return -1;
+	}
+	if(arm_timer(job->fd, &spec->duration) < 0){
+		close(job->fd);
+		free(job);
+		return -1;
+	}
+
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = job->fd;
+	if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, job->fd, &event) < 0){
+		perror("timeout epoll_ctl");
+		close(job->fd);
+		free(job);
+		return -1;
+	}
+
+	ilist_append(&job->link, &timed_jobs);
+	return 0;
+}
+
+/**
+ * timeout_handle() - Handles a readable file descriptor in the wait loop if
+ * it is the timer of a job.
+ *
+ * @param fd The readable file descriptor.
+ * @return 1 if the fd was a timer and has been handled, else 0.
+ */
+int timeout_handle(int fd){
+	list_link *current_link = ilist_first(&timed_jobs);
+	while(current_link != NULL){
+		timed_job *job = ilist_entry(current_link, timed_job, link);
+		if(job->fd == fd){
+			uint64_t expirations;
+			if(read(fd, &expirations, sizeof(expirations)) < 0){
+				return 1; //Not expired after all.
+			}
+
+			if(job->state == TIMED_RUNNING){
+				signal_job(job, SIGTERM, "SIGTERM");
+				job->state = TIMED_TERMINATED;
+				arm_timer(job->fd, &job->spec.grace);
+			}
+			else if(job->state == TIMED_TERMINATED){
+				signal_job(job, SIGKILL, "SIGKILL");
+				job->state = TIMED_KILLED;
+			}
+			return 1;
+		}
+		current_link = ilist_next(current_link, &timed_jobs);
+	}
+	return 0;
+}
+
+/**
+ * timeout_finish_jobs() - Removes the timers of all jobs which have no
+ * children left.
+ */
+void timeout_finish_jobs(void){
+	list_link *job_link = ilist_first(&timed_jobs);
+	while(job_link != NULL){
+		timed_job *job = ilist_entry(job_link, timed_job, link);
+		job_link = ilist_next(job_link, &timed_jobs);
+
+		int running = 0;
+		list_link *child_link = ilist_first(&current_shell_children);
+		while(child_link != NULL && !running){
+			shell_child *child = ilist_entry(child_link, shell_child, link);
+			running = child->job_id == job->job_id;
+			child_link = ilist_next(child_link, &current_shell_children);
+		}
+		if(!running){
+			remove_timed_job(job);
+		}
+	}
+}
+
+/**
+ * arm_timer() - Arms a timerfd to expire once after the given time.
+ *
+ * @param fd The timerfd.
+ * @param when The time until it expires.
+ * @return 0 on success or -1 on failure.
+ */
+static int arm_timer(int fd, const struct timespec *when){
+	struct itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	spec.it_value = *when;
+	if(spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0){
+		spec.it_value.tv_nsec = 1; //A zero time would disarm the timer.
+	}
+
+	if(timerfd_settime(fd, 0, &spec, NULL) < 0){
+		perror("timerfd_settime");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * signal_job() - Sends a signal to every stage of the job which is still
+ * running and reports the stage. A timed job is a process group of its own,
+ * so the signal is sent with one killpg() and also reaches what the stages
+ * have forked.
+ *
+ * @param job The timed job.
+ * @param signo The signal to send.
+ * @param signame The name of the signal for the report.
+ */
+static void signal_job(timed_job *job, int signo, const char *signame){
+	pid_t pgid = 0;
+	list_link *current_link = ilist_first(&current_shell_children);
+	while(current_link != NULL){
+		shell_child *child = ilist_entry(current_link, shell_child, link);
+		if(child->job_id == job->job_id){
+			fprintf(stderr, "timeout: job %d stage %d (%s) still running, "
+					"sending %s\n", job->job_id, child->stage, child->name, \
+					signame);
+			pgid = child->job->pgid;
+			if(pgid == 0 && kill(child->pid, signo) < 0 && errno != ESRCH){
+				perror("timeout kill");
+			}
+		}
+		current_link = ilist_next(current_link, &current_shell_children);
+	}
+
+	if(pgid > 0 && killpg(pgid, signo) < 0 && errno != ESRCH){
+		perror("timeout kill");
+	}
+}
+
+/**
+ * remove_timed_job() - Closes the timer of a job and frees it. Closing the
+ * timerfd also removes it from the epoll set.
+ *
+ * @param job The timed job.
+ */
+static void remove_timed_job(timed_job *job){
+	ilist_remove(&job->link);
+	if(close(job->fd) < 0){
+		perror("timeout close");
+	}
+	free(job);
+}
@@ -0,0 +1,83 @@
+/*
+ * timeout.h Is the header file for the timeout prefix of mish:
+ *
+ *   timeout [-k GRACE] DURATION pipeline
+ *
+ * A timerfd is armed for the pipeline and waited on in the shell's wait loop.
+ * When it expires, SIGTERM is sent to every stage of the pipeline which is
+ * still running and those stages are reported. If any stage is left after the
+ * grace period, SIGKILL is sent. Durations are numbers with an optional unit,
+ * ms, s (the default), m or h, like "1.5" or "200ms".
+ *
+ * The timed pipeline is a process group of its own, also in a script without
+ * job control, and the signals are sent to the group. So the children which
+ * the stages have forked are killed with them instead of being left behind.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef TIMEOUT_H_
+#define TIMEOUT_H_
+
+#include <time.h>
+
+/*The grace period between SIGTERM and SIGKILL if -k is not given.*/
+#define TIMEOUT_DEFAULT_GRACE_SEC 2
+
+/*The longest duration, a year.*/
+#define DURATION_MAX_SEC (365L * 24 * 60 * 60)
+
+typedef struct timeout_spec{
+	struct timespec duration;
+	struct timespec grace;
+}timeout_spec;
+
+/**
+ * timeout_parse() - Parses the options and duration of the timeout prefix.
+ *
+ * @param spec The timeout to fill in.
+ * @param argc The number of words, starting with "timeout".
+ * @param argv The words.
+ * @return The number of words used by the prefix, or -1 on a bad option or
+ * duration.
+ */
+int timeout_parse(timeout_spec *spec, int argc, char **argv);
+
+/**
+ * parse_duration() - Parses a duration like "1.5", "200ms", "10s", "2m" or
+ * "1h", up to DURATION_MAX_SEC.
+ *
+ * @param text The text to parse.
+ * @param duration The parsed duration.
+ * @return 0 on success or -1 on a bad duration.
+ */
+int parse_duration(const char *text, struct timespec *duration);
+
+/**
+ * timeout_start() - Arms the timer for a started job and adds it to the wait
+ * loop.
+ *
+ * @param spec The timeout of the job.
+ * @param job_id The id of the job, which its children are tagged with.
+ * @param epoll_fd The epoll file descriptor of the wait loop.
+ * @return 0 on success or -1 on failure.
+ */
+int timeout_start(const timeout_spec *spec, int job_id, int epoll_fd);
+
+/**
+ * timeout_handle() - Handles a readable file descriptor in the wait loop if
+ * it is the timer of a job.
+ *
+ * @param fd The readable file descriptor.
+ * @return 1 if the fd was a timer and has been handled, else 0.
+ */
+int timeout_handle(int fd);
+
+/**
+ * timeout_finish_jobs() - Removes the timers of all jobs which have no
+ * children left.
+ */
+void timeout_finish_jobs(void);
+
+#endif /* TIMEOUT_H_ */
@@ -0,0 +1,95 @@
+/*
+ * users.c Is the source code for the user database lookups of mish. See the
+ * header file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "users.h"
+#include "hash.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pwd.h>
+
+/* Defines */
+#define USERS_BUCKETS 64	//Must be a power of two.
+
+/*A looked up user in a bucket of the table.*/
+typedef struct user_entry{
+	struct user_entry *next;
+	char *name;
+	char *home;	//NULL if the user does not exist.
+}user_entry;
+
+/*Function prototypes.*/
+static char *copy_home(const struct passwd *pw);
+
+
+static user_entry *buckets[USERS_BUCKETS];
+
+/*The user of the shell, looked up by uid.*/
+static int own_looked_up = 0;
+static char *own_home = NULL;
+
+
+/**
+ * users_home() - Gets the home directory of a user from the user database.
+ * $HOME is not looked at, see vars_home().
+ *
+ * @param name The name of the user, or NULL for the user of the shell.
+ * @return The home directory, which is kept for the life of the shell, or
+ * NULL if there is no such user.
+ */
+const char *users_home(const char *name){
+	if(name == NULL){
+		if(!own_looked_up){
+			own_home = copy_home(getpwuid(getuid()));
+			own_looked_up = 1;
+		}
+		return own_home;
+	}
+
+	user_entry **bucket = \
+			&buckets[hash_string(name, HASH_SEED) & (USERS_BUCKETS - 1)];
+	for(user_entry *e = *bucket; e != NULL; e = e->next){
+		if(strcmp(e->name, name) == 0){
+			return e->home;
+		}
+	}
+
+	user_entry *e = malloc(sizeof(*e));
+	if(e == NULL || (e->name = strdup(name)) == NULL){
+		perror("users.c");
+		exit(errno);
+	}
+	e->home = copy_home(getpwnam(name));
+	e->next = *bucket;
+	*bucket = e;
+	return e->home;
+}
+
+/**
+ * copy_home() - Copies the home directory of a looked up user, since the
+ * entry of getpwnam() and getpwuid() is overwritten by the next lookup.
+ *
+ * @param pw The entry of the user or NULL.
+ * @return The copy or NULL if there is no user.
+ */
+static char *copy_home(const struct passwd *pw){
+	if(pw == NULL){
+		return NULL;
+	}
+	char *home = strdup(pw->pw_dir);
+	if(home == NULL){
+		perror("users.c");
+		exit(errno);
+	}
+	return home;
+}
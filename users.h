@@ -0,0 +1,27 @@
+/*
+ * users.h Is the header file for the user database lookups of mish. Looking
+ * up a user with getpwnam() or getpwuid() may ask a directory service like
+ * LDAP, which can take milliseconds, so every lookup is done once per shell
+ * and its result is kept, also when the user does not exist.
+ *
+ * The home directories are used for "~" and "~user" in words, see vars.h,
+ * and for "cd" without a directory.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef USERS_H_
+#define USERS_H_
+
+/**
+ * users_home() - Gets the home directory of a user from the user database.
+ * $HOME is not looked at, see vars_home().
+ *
+ * @param name The name of the user, or NULL for the user of the shell.
+ * @return The home directory, which is kept for the life of the shell, or
+ * NULL if there is no such user.
+ */
+const char *users_home(const char *name);
+
+#endif /* USERS_H_ */
@@ -0,0 +1,710 @@
+/*
+ * vars.c Is the source code for the shell variables of mish. See the header
+ * file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "vars.h"
+#include "hash.h"
+#include "users.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+/* Defines */
+#define VARS_BUCKETS 64	//Must be a power of two.
+#define STATUS_LEN 12
+#define USER_NAME_MAX 256	//The longest name in a "~user" which is looked up.
+
+/*The quote bytes which start and end a quoted part of a word.*/
+static const char quotes[] = {QUOTE_SINGLE, QUOTE_DOUBLE, '\0'};
+
+/*A shell variable in a bucket of the table.*/
+typedef struct var{
+	struct var *next;
+	char *name;
+	char *value;
+}var;
+
+/*Function prototypes.*/
+static var *find_var(const char *name, size_t len, var ***bucket);
+static const char *lookup(const char *name, size_t len);
+static char *expand_word(const char *word, char **text, char *end);
+static const char *expand_tilde(const char *word, int assignment, \
+		char **text, char *end);
+static int append_expanded(const char *p, size_t len, char *quote, \
+		char **out, char *end);
+static int expand_fields(const char *word, int split, char **words, \
+		int *used, char **text, char *end);
+static const char *next_substitution(const char *p, char quote);
+static char *substitute(const char *start, const char **after);
+static const char *matching_paren(const char *open);
+static size_t name_length(const char *str);
+
+/*The table of shell variables.*/
+static var *buckets[VARS_BUCKETS];
+
+/*The value of "$?".*/
+static char last_status[STATUS_LEN] = "0";
+
+/*The function which runs command substitutions.*/
+static vars_substitute substitute_run = NULL;
+
+/*The outputs of the command substitutions which are kept.*/
+static char **outputs = NULL;
+static size_t number_of_outputs = 0;
+static size_t outputs_size = 0;
+
+
+/**
+ * vars_set() - Sets a shell variable.
+ *
+ * @param name The name of the variable.
+ * @param value The value, which is copied.
+ */
+void vars_set(const char *name, const char *value){
+	var **bucket;
+	var *v = find_var(name, strlen(name), &bucket);
+	char *copy = strdup(value);
+	if(copy == NULL){
+		perror("vars.c");
+		exit(errno);
+	}
+
+	if(v != NULL){
+		free(v->value);
+		v->value = copy;
+		return;
+	}
+
+	v = malloc(sizeof(*v));
+	if(v == NULL || (v->name = strdup(name)) == NULL){
+		perror("vars.c");
+		exit(errno);
+	}
+	v->value = copy;
+	v->next = *bucket;
+	*bucket = v;
+}
+
+/**
+ * vars_get() - Gets the value of a shell variable or of the environment.
+ *
+ * @param name The name of the variable.
+ * @return The value or NULL if it is not set.
+ */
+const char *vars_get(const char *name){
+	return lookup(name, strlen(name));
+}
+
+/**
+ * vars_each() - Calls a function with every shell variable, in no order.
+ *
+ * @param visit The function, which must not set variables.
+ * @param arg Given to the function.
+ */
+void vars_each(void (*visit)(const char *name, const char *value, void *arg), \
+		void *arg){
+	for(int i = 0; i < VARS_BUCKETS; i++){
+		for(var *v = buckets[i]; v != NULL; v = v->next){
+			visit(v->name, v->value, arg);
+		}
+	}
+}
+
+/**
+ * vars_home() - Gets the home directory which "~" or "~user" is replaced by.
+ * The home directory of the user of the shell is $HOME if it is set and not
+ * empty, else it is looked up like the ones of other users, see users.h.
+ *
+ * @param user The name of the user, or NULL for the user of the shell.
+ * @return The home directory or NULL if it is not known.
+ */
+const char *vars_home(const char *user){
+	if(user == NULL){
+		const char *home = lookup("HOME", 4);
+		if(home != NULL && *home != '\0'){
+			return home;
+		}
+	}
+	return users_home(user);
+}
+
+/**
+ * vars_set_status() - Sets the exit status which "$?" is replaced by.
+ *
+ * @param status The exit status of the last pipeline.
+ */
+void vars_set_status(int status){
+	snprintf(last_status, STATUS_LEN, "%d", status);
+}
+
+/**
+ * vars_set_substitute() - Sets the function which runs the command lines of
+ * command substitutions.
+ *
+ * @param run The function.
+ */
+void vars_set_substitute(vars_substitute run){
+	substitute_run = run;
+}
+
+/**
+ * vars_mark() - Marks the outputs of command substitutions which are kept.
+ *
+ * @return The mark, to give to vars_release().
+ */
+size_t vars_mark(void){
+	return number_of_outputs;
+}
+
+/**
+ * vars_release() - Frees the outputs of the command substitutions done after
+ * the mark. The words of the expanded commands may point into them.
+ *
+ * @param mark The mark from vars_mark().
+ */
+void vars_release(size_t mark){
+	while(number_of_outputs > mark){
+		free(outputs[--number_of_outputs]);
+	}
+}
+
+/**
+ * vars_is_name() - Checks if a word is a valid variable name.
+ *
+ * @param word The word.
+ * @return 1 if it is a name, else 0.
+ */
+int vars_is_name(const char *word){
+	size_t len = name_length(word);
+	return len > 0 && word[len] == '\0';
+}
+
+/**
+ * vars_is_assignment() - Checks if a word is like "name=value".
+ *
+ * @param word The word.
+ * @return 1 if the word is an assignment, else 0.
+ */
+int vars_is_assignment(const char *word){
+	size_t len = name_length(word);
+	return len > 0 && word[len] == '=';
+}
+
+/**
+ * vars_assign() - Runs a word like "name=value" as an assignment.
+ *
+ * @param word The word.
+ * @return 1 if the word was an assignment, else 0.
+ */
+int vars_assign(const char *word){
+	if(!vars_is_assignment(word)){
+		return 0;
+	}
+	size_t len = name_length(word);
+
+	char name[len + 1];
+	memcpy(name, word, len);
+	name[len] = '\0';
+	vars_set(name, word + len + 1);
+	return 1;
+}
+
+/**
+ * vars_expand() - Substitutes the variables and commands in the words of a
+ * pipeline and removes their quotes. The commands are copied, words without a
+ * "$" or quotes are shared with the originals. Command substitutions are not
+ * done in redirections.
+ *
+ * @param commands The commands of the pipeline.
+ * @param number_of_commands The number of commands.
+ * @param expanded The array for the copied commands.
+ * @param words The array for the argv pointers, MAXWORDS long.
+ * @param text The buffer for the substituted words, VARS_TEXT_MAX long.
+ * @return 0 on success or -1 if the words do not fit or a command
+ * substitution failed.
+ */
+int vars_expand(command *commands, int number_of_commands, \
+		command *expanded, char **words, char *text){
+	char *end = text + VARS_TEXT_MAX;
+	int used = 0;
+
+	for(int i = 0; i < number_of_commands; i++){
+		expanded[i] = commands[i];
+		expanded[i].argv = words + used;
+		expanded[i].argc = 0;
+
+		int first = used;
+		for(int j = 0; j < commands[i].argc; j++){
+			//The value of a lone assignment is not split.
+			const char *word = commands[i].argv[j];
+			int split = commands[i].argc > 1 || name_length(word) == 0 || \
+					word[name_length(word)] != '=';
+			word = expand_tilde(word, !split, &text, end);
+			if(word == NULL || \
+					expand_fields(word, split, words, &used, &text, end) < 0){
+				return -1;
+			}
+		}
+		expanded[i].argc = used - first;
+		words[used++] = NULL;
+
+		if(commands[i].infile != NULL){
+			const char *infile = expand_tilde(commands[i].infile, 0, &text, \
+					end);
+			expanded[i].infile = infile == NULL ? NULL : \
+					expand_word(infile, &text, end);
+		}
+		if(commands[i].outfile != NULL){
+			const char *outfile = expand_tilde(commands[i].outfile, 0, &text, \
+					end);
+			expanded[i].outfile = outfile == NULL ? NULL : \
+					expand_word(outfile, &text, end);
+		}
+		if((commands[i].infile != NULL && expanded[i].infile == NULL) || \
+				(commands[i].outfile != NULL && expanded[i].outfile == NULL)){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * find_var() - Finds a shell variable in the table.
+ *
+ * @param name The name, which does not have to be terminated.
+ * @param len The length of the name.
+ * @param bucket Set to the bucket the variable belongs in.
+ * @return The variable or NULL if it is not set.
+ */
+static var *find_var(const char *name, size_t len, var ***bucket){
+	*bucket = &buckets[hash_bytes(name, len, HASH_SEED) & (VARS_BUCKETS - 1)];
+	for(var *v = **bucket; v != NULL; v = v->next){
+		if(strncmp(v->name, name, len) == 0 && v->name[len] == '\0'){
+			return v;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * lookup() - Gets the value of a shell variable or of the environment.
+ *
+ * @param name The name, which does not have to be terminated.
+ * @param len The length of the name.
+ * @return The value or NULL if it is not set.
+ */
+static const char *lookup(const char *name, size_t len){
+	var **bucket;
+	var *v = find_var(name, len, &bucket);
+	if(v != NULL){
+		return v->value;
+	}
+
+	char terminated[len + 1];
+	memcpy(terminated, name, len);
+	terminated[len] = '\0';
+	return getenv(terminated);
+}
+
+/**
+ * expand_word() - Substitutes the variables in one word and removes its
+ * quotes. A word without a "$" or quotes is returned as it is.
+ *
+ * @param word The word.
+ * @param text The buffer to write the result to, moved past the result.
+ * @param end The end of the buffer.
+ * @return The word with the substitutions or NULL if it does not fit.
+ */
+static char *expand_word(const char *word, char **text, char *end){
+	if(strpbrk(word, "$" QUOTE_BYTES) == NULL){
+		return (char *)word;
+	}
+
+	char *result = *text;
+	char *out = *text;
+	char quote = '\0';
+	if(append_expanded(word, strlen(word), &quote, &out, end) < 0 || \
+			out >= end){
+		fprintf(stderr, "Substituted words are too long.\n");
+		return NULL;
+	}
+	*out++ = '\0';
+	*text = out;
+	return result;
+}
+
+/**
+ * expand_tilde() - Replaces a "~" or "~user" at the start of a word, up to
+ * the first "/", with the home directory, see vars_home(). In a lone
+ * assignment the "~" is the one at the start of the value. A quoted or
+ * escaped "~" or user is not replaced, and neither is a word whose home
+ * directory is not known. The home directory is put in single quotes, so it
+ * is not substituted again.
+ *
+ * @param word The word.
+ * @param assignment 1 if the word is a lone assignment, else 0.
+ * @param text The buffer to write the result to, moved past the result.
+ * @param end The end of the buffer.
+ * @return The word with the home directory or NULL if it does not fit.
+ */
+static const char *expand_tilde(const char *word, int assignment, \
+		char **text, char *end){
+	const char *tilde = assignment ? word + name_length(word) + 1 : word;
+	if(*tilde != '~'){
+		return word;
+	}
+
+	size_t user_len = strcspn(tilde + 1, "/");
+	if(user_len >= USER_NAME_MAX || \
+			strcspn(tilde + 1, "$" QUOTE_BYTES) < user_len){
+		return word;
+	}
+	char user[USER_NAME_MAX];
+	memcpy(user, tilde + 1, user_len);
+	user[user_len] = '\0';
+	const char *home = vars_home(user_len == 0 ? NULL : user);
+	if(home == NULL){
+		return word;
+	}
+
+	const char *rest = tilde + 1 + user_len;
+	size_t before = tilde - word;
+	size_t home_len = strlen(home);
+	size_t rest_len = strlen(rest);
+	if(end - *text <= (ptrdiff_t)(before + home_len + rest_len + 2)){
+		fprintf(stderr, "Substituted words are too long.\n");
+		return NULL;
+	}
+	char *result = *text;
+	char *out = result;
+	memcpy(out, word, before);
+	out += before;
+	*out++ = QUOTE_SINGLE;
+	memcpy(out, home, home_len);
+	out += home_len;
+	*out++ = QUOTE_SINGLE;
+	memcpy(out, rest, rest_len + 1);
+	*text = out + rest_len + 1;
+	return result;
+}
+
+/**
+ * append_expanded() - Writes a part of a word with its variables substituted
+ * and its quotes removed. Nothing is substituted in single quotes or after an
+ * escape, see parser.h.
+ *
+ * @param p The part of the word.
+ * @param len The length of the part.
+ * @param quote The quote the part starts in, QUOTE_SINGLE, QUOTE_DOUBLE or
+ * '\0', set to the quote it ends in.
+ * @param out Where to write, moved past what was written.
+ * @param end The end of the buffer.
+ * @return 0 on success or -1 if it does not fit.
+ */
+static int append_expanded(const char *p, size_t len, char *quote, \
+		char **out, char *end){
+	const char *stop = p + len;
+
+	while(p < stop){
+		const char *value = NULL;
+		size_t value_len = 1;
+
+		if(*p == QUOTE_SINGLE || *p == QUOTE_DOUBLE){
+			*quote = *quote == *p ? '\0' : *p;
+			p++;
+			continue;
+		}
+		else if(*p == QUOTE_ESCAPE && p + 1 < stop){
+			value = p + 1;
+			p += 2;
+		}
+		else if(*quote == QUOTE_SINGLE){
+			value = p++;
+		}
+		else if(p[0] == '$' && p + 1 < stop && p[1] == '?'){
+			value = last_status;
+			value_len = strlen(value);
+			p += 2;
+		}
+		else if(p[0] == '$' && p + 1 < stop && p[1] == '{' && \
+				name_length(p + 2) > 0 && p[2 + name_length(p + 2)] == '}'){
+			size_t name_len = name_length(p + 2);
+			value = lookup(p + 2, name_len);
+			value_len = value != NULL ? strlen(value) : 0;
+			p += name_len + 3;
+		}
+		else if(p[0] == '$' && p + 1 < stop && name_length(p + 1) > 0){
+			size_t name_len = name_length(p + 1);
+			value = lookup(p + 1, name_len);
+			value_len = value != NULL ? strlen(value) : 0;
+			p += name_len + 1;
+		}
+		else{ //Not a substitution, copy the character.
+			value = p++;
+		}
+
+		if(end - *out <= (ptrdiff_t)value_len){
+			return -1;
+		}
+		if(value_len > 0){
+			memcpy(*out, value, value_len);
+			*out += value_len;
+		}
+	}
+	return 0;
+}
+
+/**
+ * expand_fields() - Substitutes the variables and commands in one word and
+ * adds the resulting words. The output of a command substitution is split
+ * into words, the first is joined with the text before it and the last with
+ * the text after it. The output of one in double quotes is not split. A word
+ * without quotes which was only substitutions and became empty is not added.
+ *
+ * @param word The word.
+ * @param split 1 if the output is split into words, 0 if the words of the
+ * output are joined with single spaces.
+ * @param words The array to add the words to.
+ * @param used The number of words in the array, updated.
+ * @param text The buffer for words which are built, moved past them.
+ * @param end The end of the buffer.
+ * @return 0 on success or -1 on failure.
+ */
+static int expand_fields(const char *word, int split, char **words, \
+		int *used, char **text, char *end){
+	const char *sub = next_substitution(word, '\0');
+	int quoted = strpbrk(word, quotes) != NULL;
+
+	if(sub == NULL){
+		char *expanded = expand_word(word, text, end);
+		if(expanded == NULL){
+			return -1;
+		}
+		if(*expanded == '\0' && !quoted){
+			return 0;
+		}
+		if(*used >= MAXWORDS - 1){
+			fprintf(stderr, "Too many words in command.\n");
+			return -1;
+		}
+		words[(*used)++] = expanded;
+		return 0;
+	}
+
+	//A word which is one substitution is split in place in the output.
+	const char *after;
+	if(sub == word && matching_paren(word + 1) != NULL && \
+			matching_paren(word + 1)[1] == '\0'){
+		char *output = substitute(word, &after);
+		if(output == NULL){
+			return -1;
+		}
+		char *field = strtok(output, " \t\n");
+		while(field != NULL){
+			if(*used >= MAXWORDS - 1){
+				fprintf(stderr, "Too many words in command.\n");
+				return -1;
+			}
+			words[(*used)++] = field;
+			field = strtok(NULL, " \t\n");
+		}
+		return 0;
+	}
+
+	//Else the words are built in the text buffer.
+	char *current = *text;
+	char *out = *text;
+	char quote = '\0';
+	const char *p = word;
+	while(1){
+		size_t part = sub != NULL ? (size_t)(sub - p) : strlen(p);
+		if(append_expanded(p, part, &quote, &out, end) < 0){
+			fprintf(stderr, "Substituted words are too long.\n");
+			return -1;
+		}
+		if(sub == NULL){
+			break;
+		}
+
+		char *output = substitute(sub, &after);
+		if(output == NULL){
+			return -1;
+		}
+		if(quote == QUOTE_DOUBLE){ //Copied as it is.
+			size_t output_len = strlen(output);
+			if(end - out <= (ptrdiff_t)output_len){
+				fprintf(stderr, "Substituted words are too long.\n");
+				return -1;
+			}
+			memcpy(out, output, output_len);
+			out += output_len;
+		}
+		int first_field = 1;
+		for(char *field = quote == QUOTE_DOUBLE ? NULL : \
+				strtok(output, " \t\n"); field != NULL; \
+				field = strtok(NULL, " \t\n")){
+			size_t field_len = strlen(field);
+			if(end - out <= (ptrdiff_t)field_len + 1 || \
+					*used >= MAXWORDS - 1){
+				fprintf(stderr, "Substituted words are too long.\n");
+				return -1;
+			}
+			if(!first_field && !split){
+				*out++ = ' ';
+			}
+			else if(!first_field){ //End the word before the field.
+				*out++ = '\0';
+				words[(*used)++] = current;
+				current = out;
+			}
+			memcpy(out, field, field_len);
+			out += field_len;
+			first_field = 0;
+		}
+		p = after;
+		sub = next_substitution(p, quote);
+	}
+
+	if(out >= end || *used >= MAXWORDS - 1){
+		fprintf(stderr, "Substituted words are too long.\n");
+		return -1;
+	}
+	*out++ = '\0';
+	*text = out;
+	if(*current != '\0' || quoted){
+		words[(*used)++] = current;
+	}
+	return 0;
+}
+
+/**
+ * next_substitution() - Finds the next "$(" of a word which is not in single
+ * quotes or escaped.
+ *
+ * @param p Where to start in the word.
+ * @param quote The quote the word is in at p.
+ * @return The "$(" or NULL if there is none.
+ */
+static const char *next_substitution(const char *p, char quote){
+	for(; *p != '\0'; p++){
+		if(*p == QUOTE_SINGLE || *p == QUOTE_DOUBLE){
+			quote = quote == *p ? '\0' : *p;
+		}
+		else if(*p == QUOTE_ESCAPE && p[1] != '\0'){
+			p++;
+		}
+		else if(quote != QUOTE_SINGLE && p[0] == '$' && p[1] == '('){
+			return p;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * substitute() - Runs the command line of a command substitution and keeps
+ * its output.
+ *
+ * @param start The "$(" which starts the substitution.
+ * @param after Set to the character after the closing ")".
+ * @return The output, which is kept until vars_release(), or NULL on
+ * failure.
+ */
+static char *substitute(const char *start, const char **after){
+	const char *close = matching_paren(start + 1);
+	if(close == NULL){
+		fprintf(stderr, "Missing ) in command substitution.\n");
+		return NULL;
+	}
+	if(substitute_run == NULL){
+		fprintf(stderr, "Command substitution is not available.\n");
+		return NULL;
+	}
+
+	size_t line_len = close - (start + 2);
+	char line[line_len + 1];
+	memcpy(line, start + 2, line_len);
+	line[line_len] = '\0';
+
+	size_t len;
+	char *output = substitute_run(line, &len);
+	if(output == NULL){
+		return NULL;
+	}
+
+	if(number_of_outputs == outputs_size){
+		size_t size = outputs_size > 0 ? outputs_size * 2 : 8;
+		char **grown = realloc(outputs, size * sizeof(char *));
+		if(grown == NULL){
+			perror("vars.c");
+			exit(errno);
+		}
+		outputs = grown;
+		outputs_size = size;
+	}
+	outputs[number_of_outputs++] = output;
+
+	*after = close + 1;
+	return output;
+}
+
+/**
+ * matching_paren() - Finds the ")" which closes a "(", counting the nested
+ * parentheses. Parentheses in quotes or escaped are not counted.
+ *
+ * @param open The "(".
+ * @return The closing ")" or NULL if there is none.
+ */
+static const char *matching_paren(const char *open){
+	int depth = 0;
+	char quote = '\0';
+	for(const char *p = open; *p != '\0'; p++){
+		if(quote != '\0'){ //The parser has kept the quotes of the line.
+			if(*p == '\\' && quote == '"' && p[1] != '\0'){
+				p++;
+			}
+			else if(*p == quote){
+				quote = '\0';
+			}
+		}
+		else if(*p == '\'' || *p == '"'){
+			quote = *p;
+		}
+		else if(*p == '\\' && p[1] != '\0'){
+			p++;
+		}
+		else if(*p == '('){
+			depth++;
+		}
+		else if(*p == ')' && --depth == 0){
+			return p;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * name_length() - Gets the length of the variable name at the start of a
+ * string.
+ *
+ * @param str The string.
+ * @return The length of the name, 0 if the string does not start with one.
+ */
+static size_t name_length(const char *str){
+	if(!isalpha((unsigned char)*str) && *str != '_'){
+		return 0;
+	}
+	size_t len = 1;
+	while(isalnum((unsigned char)str[len]) || str[len] == '_'){
+		len++;
+	}
+	return len;
+}
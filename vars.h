@@ -0,0 +1,154 @@
+/*
+ * vars.h Is the header file for the shell variables of mish. A variable is
+ * set with a command like "name=value" or by a for loop, and "$name" or
+ * "${name}" in a word is replaced by its value when the command is run. If
+ * no shell variable has the name, the environment is used. "$?" is the exit
+ * status of the last pipeline.
+ *
+ * Substitution works on the words which the parser has already split, so a
+ * value is never split into more words. A word which was only a substitution
+ * and became empty is removed, unless it has quotes.
+ *
+ * The words keep the quotes of the line, see PARSE_KEEP_QUOTES in parser.h,
+ * which are removed when they are substituted. Nothing is substituted in
+ * single quotes or in an escaped character. In double quotes "$" is, but the
+ * output of a command substitution is not split.
+ *
+ * An unquoted "~" at the start of a word, or of the value of a lone
+ * assignment, is replaced by $HOME and "~user" by the home directory of the
+ * user, up to the first "/". The user database is asked once per user, see
+ * users.h.
+ *
+ * "$(line)" is replaced by the output of the command line, without the
+ * trailing newlines. The output is split into words at whitespace. The shell
+ * registers the function which runs the line, see vars_set_substitute().
+ * When the whole word is one command substitution, the words are split in
+ * place in the output and are not copied. The outputs are kept until
+ * vars_release() is called.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef VARS_H_
+#define VARS_H_
+
+#include "parser.h"
+
+#include <stddef.h>
+
+/*The room for the text of the substituted words of one pipeline.*/
+#define VARS_TEXT_MAX 8192
+
+/*Runs a command line for a command substitution and returns its output as
+ *a string which vars takes over and frees, with the length in len, or NULL
+ *on failure.*/
+typedef char *(*vars_substitute)(const char *line, size_t *len);
+
+/**
+ * vars_set_substitute() - Sets the function which runs the command lines of
+ * command substitutions.
+ *
+ * @param run The function.
+ */
+void vars_set_substitute(vars_substitute run);
+
+/**
+ * vars_mark() - Marks the outputs of command substitutions which are kept.
+ *
+ * @return The mark, to give to vars_release().
+ */
+size_t vars_mark(void);
+
+/**
+ * vars_release() - Frees the outputs of the command substitutions done after
+ * the mark. The words of the expanded commands may point into them.
+ *
+ * @param mark The mark from vars_mark().
+ */
+void vars_release(size_t mark);
+
+/**
+ * vars_set() - Sets a shell variable.
+ *
+ * @param name The name of the variable.
+ * @param value The value, which is copied.
+ */
+void vars_set(const char *name, const char *value);
+
+/**
+ * vars_get() - Gets the value of a shell variable or of the environment.
+ *
+ * @param name The name of the variable.
+ * @return The value or NULL if it is not set.
+ */
+const char *vars_get(const char *name);
+
+/**
+ * vars_each() - Calls a function with every shell variable, in no order.
+ *
+ * @param visit The function, which must not set variables.
+ * @param arg Given to the function.
+ */
+void vars_each(void (*visit)(const char *name, const char *value, void *arg), \
+		void *arg);
+
+/**
+ * vars_home() - Gets the home directory which "~" or "~user" is replaced by.
+ * The home directory of the user of the shell is $HOME if it is set and not
+ * empty, else it is looked up like the ones of other users, see users.h.
+ *
+ * @param user The name of the user, or NULL for the user of the shell.
+ * @return The home directory or NULL if it is not known.
+ */
+const char *vars_home(const char *user);
+
+/**
+ * vars_set_status() - Sets the exit status which "$?" is replaced by.
+ *
+ * @param status The exit status of the last pipeline.
+ */
+void vars_set_status(int status);
+
+/**
+ * vars_is_name() - Checks if a word is a valid variable name.
+ *
+ * @param word The word.
+ * @return 1 if it is a name, else 0.
+ */
+int vars_is_name(const char *word);
+
+/**
+ * vars_is_assignment() - Checks if a word is like "name=value".
+ *
+ * @param word The word.
+ * @return 1 if the word is an assignment, else 0.
+ */
+int vars_is_assignment(const char *word);
+
+/**
+ * vars_assign() - Runs a word like "name=value" as an assignment.
+ *
+ * @param word The word.
+ * @return 1 if the word was an assignment, else 0.
+ */
+int vars_assign(const char *word);
+
+/**
+ * vars_expand() - Substitutes the variables and commands in the words of a
+ * pipeline and removes their quotes. The commands are copied, words without a
+ * "$" or quotes are shared with the originals. Command substitutions are not
+ * done in redirections.
+ *
+ * @param commands The commands of the pipeline.
+ * @param number_of_commands The number of commands.
+ * @param expanded The array for the copied commands.
+ * @param words The array for the argv pointers, MAXWORDS long.
+ * @param text The buffer for the substituted words, VARS_TEXT_MAX long.
+ * @return 0 on success or -1 if the words do not fit or a command
+ * substitution failed.
+ */
+int vars_expand(command *commands, int number_of_commands, \
+		command *expanded, char **words, char *text);
+
+#endif /* VARS_H_ */
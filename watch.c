@@ -0,0 +1,276 @@
+/*
+ * watch.c Is the source code for the watch prefix of mish. See the header
+ * file for more information.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+/* Include own header */
+#include "watch.h"
+#include "timeout.h"
+
+/*Include default libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/timerfd.h>
+
+/* Defines */
+#define WATCH_EVENTS (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM | \
+		IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF)
+#define WATCH_READ_SIZE 4096
+
+/*A watched path and its watch descriptor, -1 while the path is missing.*/
+typedef struct watched_path{
+	const char *path;
+	int wd;
+}watched_path;
+
+struct watcher{
+	int inotify_fd;
+	int timer_fd;
+	int due;	//The debounce window after a change has passed.
+	struct timespec debounce;
+	watched_path paths[WATCH_MAX_PATHS];
+	int number_of_paths;
+};
+
+/*Function prototypes.*/
+static int add_to_loop(int epoll_fd, int fd);
+static void add_missing_watches(watcher *w);
+static void read_changes(watcher *w);
+
+
+/**
+ * watch_parse() - Parses the options and paths of the watch prefix.
+ *
+ * @param spec The options to fill in.
+ * @param argc The number of words, starting with "watch".
+ * @param argv The words.
+ * @return The number of words used by the prefix, up to and with "--", or -1
+ * on a bad option or a missing "--".
+ */
+int watch_parse(watch_spec *spec, int argc, char **argv){
+	memset(spec, 0, sizeof(*spec));
+	spec->debounce.tv_nsec = WATCH_DEFAULT_DEBOUNCE_MS * 1000000L;
+
+	int opt;
+	optind = 0;
+	while((opt = getopt(argc, argv, "+d:")) != -1){
+		switch(opt){
+		case 'd':
+			if(parse_duration(optarg, &spec->debounce) < 0){
+				fprintf(stderr, "watch: bad debounce: %s\n", optarg);
+				return -1;
+			}
+			break;
+		default:
+			fprintf(stderr, "Usage: watch [-d DEBOUNCE] PATH... -- "
+					"pipeline\n");
+			return -1;
+		}
+	}
+
+	int i = optind;
+	for(; i < argc && strcmp(argv[i], "--") != 0; i++){
+		if(spec->number_of_paths == WATCH_MAX_PATHS){
+			fprintf(stderr, "watch: more than %d paths\n", WATCH_MAX_PATHS);
+			return -1;
+		}
+		spec->paths[spec->number_of_paths++] = argv[i];
+	}
+	if(spec->number_of_paths == 0 || i == argc){
+		fprintf(stderr, "Usage: watch [-d DEBOUNCE] PATH... -- pipeline\n");
+		return -1;
+	}
+	return i + 1;
+}
+
+/**
+ * watch_start() - Starts watching the paths and adds the watcher to the wait
+ * loop.
+ *
+ * @param spec The options of the prefix.
+ * @param epoll_fd The epoll file descriptor of the wait loop.
+ * @return The watcher or NULL on failure.
+ */
+watcher *watch_start(const watch_spec *spec, int epoll_fd){
+	watcher *w = malloc(sizeof(*w));
+	if(w == NULL){
+		perror("watch.c");
+		exit(errno);
+	}
+	w->due = 0;
+	w->debounce = spec->debounce;
+	w->number_of_paths = spec->number_of_paths;
+	w->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	w->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(w->inotify_fd < 0 || w->timer_fd < 0){
+		perror("watch");
+		watch_stop(w);
+		return NULL;
+	}
+
+	for(int i = 0; i < spec->number_of_paths; i++){
+		w->paths[i].path = spec->paths[i];
+		w->paths[i].wd = inotify_add_watch(w->inotify_fd, spec->paths[i], \
+				WATCH_EVENTS);
+		if(w->paths[i].wd < 0){
+			perror(spec->paths[i]);
+			watch_stop(w);
+			return NULL;
+		}
+	}
+
+	if(add_to_loop(epoll_fd, w->inotify_fd) < 0 || \
+			add_to_loop(epoll_fd, w->timer_fd) < 0){
+		watch_stop(w);
+		return NULL;
+	}
+	return w;
+}
+
+/**
+ * watch_handle() - Handles a file descriptor which the wait loop found ready,
+ * if it belongs to the watcher.
+ *
+ * @param w The watcher.
+ * @param fd The ready file descriptor.
+ * @return 1 if the file descriptor belongs to the watcher, else 0.
+ */
+int watch_handle(watcher *w, int fd){
+	if(fd == w->inotify_fd){
+		read_changes(w);
+		return 1;
+	}
+	else if(fd == w->timer_fd){
+		uint64_t expirations;
+		if(read(fd, &expirations, sizeof(expirations)) > 0){
+			w->due = 1;
+			add_missing_watches(w);
+		}
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * watch_is_due() - Checks if changes have arrived and the debounce window
+ * after the last one has passed.
+ *
+ * @param w The watcher.
+ * @return 1 if a run is due, else 0.
+ */
+int watch_is_due(watcher *w){
+	return w->due;
+}
+
+/**
+ * watch_clear() - Marks the changes which are due as run.
+ *
+ * @param w The watcher.
+ */
+void watch_clear(watcher *w){
+	w->due = 0;
+}
+
+/**
+ * watch_stop() - Stops watching and frees the watcher. Closing its file
+ * descriptors also removes them from the wait loop.
+ *
+ * @param w The watcher.
+ */
+void watch_stop(watcher *w){
+	if(w->inotify_fd >= 0){
+		close(w->inotify_fd);
+	}
+	if(w->timer_fd >= 0){
+		close(w->timer_fd);
+	}
+	free(w);
+}
+
+/**
+ * add_to_loop() - Adds a file descriptor to the wait loop.
+ *
+ * @param epoll_fd The epoll file descriptor of the wait loop.
+ * @param fd The file descriptor.
+ * @return 0 on success or -1 on failure.
+ */
+static int add_to_loop(int epoll_fd, int fd){
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = fd;
+	if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0){
+		perror("watch epoll_ctl");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * add_missing_watches() - Watches the paths again whose file was removed or
+ * replaced, if they exist now.
+ *
+ * @param w The watcher.
+ */
+static void add_missing_watches(watcher *w){
+	for(int i = 0; i < w->number_of_paths; i++){
+		if(w->paths[i].wd < 0){
+			w->paths[i].wd = inotify_add_watch(w->inotify_fd, \
+					w->paths[i].path, WATCH_EVENTS);
+		}
+	}
+}
+
+/**
+ * read_changes() - Reads the events of the watched paths and starts the
+ * debounce window again. A path whose watch was removed by the kernel is
+ * watched again.
+ *
+ * @param w The watcher.
+ */
+static void read_changes(watcher *w){
+	char buf[WATCH_READ_SIZE] \
+			__attribute__((aligned(__alignof__(struct inotify_event))));
+	int changed = 0;
+	ssize_t len;
+
+	while((len = read(w->inotify_fd, buf, sizeof(buf))) > 0){
+		for(char *next = buf; next < buf + len; ){
+			const struct inotify_event *event = (void *)next;
+			next += sizeof(*event) + event->len;
+			changed = 1;
+			if(!(event->mask & IN_IGNORED)){
+				continue;
+			}
+			for(int i = 0; i < w->number_of_paths; i++){
+				if(w->paths[i].wd == event->wd){
+					w->paths[i].wd = -1;
+				}
+			}
+		}
+	}
+	if(!changed){
+		return;
+	}
+	add_missing_watches(w);
+
+	//Every change moves the end of the window.
+	struct itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	spec.it_value = w->debounce;
+	if(spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0){
+		spec.it_value.tv_nsec = 1; //A zero time would disarm the timer.
+	}
+	if(timerfd_settime(w->timer_fd, 0, &spec, NULL) < 0){
+		perror("watch timerfd_settime");
+	}
+}
@@ -0,0 +1,100 @@
+/*
+ * watch.h Is the header file for the watch prefix of mish, which runs a
+ * pipeline again every time one of the given paths changes:
+ *
+ *   watch [-d DEBOUNCE] PATH... -- pipeline
+ *
+ * The paths are watched with inotify. A watched directory reports changes to
+ * the files in it, but not in its subdirectories. A file which is replaced,
+ * like editors do when they save, is watched again under its path.
+ *
+ * A burst of changes gives one run. The pipeline is run when no change has
+ * arrived for DEBOUNCE, a duration like "200ms", see parse_duration() in
+ * timeout.h, 100ms if -d is not given. If the pipeline is still running when
+ * a change is due, SIGTERM is sent to its process group, which it has also
+ * in a script without job control, and it is started again when it has
+ * ended. The pipeline is run once when the prefix starts.
+ *
+ * The inotify and timer file descriptors are waited on in the wait loop of
+ * the shell, so the shell reaps the pipeline while it waits for changes.
+ * Watching ends when the shell is interrupted or the pipeline is stopped.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: Bram Coenen (tfy15bcn)
+ */
+
+#ifndef WATCH_H_
+#define WATCH_H_
+
+#include <time.h>
+
+/*The most paths one prefix may watch.*/
+#define WATCH_MAX_PATHS 32
+
+/*The debounce window if -d is not given.*/
+#define WATCH_DEFAULT_DEBOUNCE_MS 100
+
+typedef struct watch_spec{
+	char *paths[WATCH_MAX_PATHS];
+	int number_of_paths;
+	struct timespec debounce;
+}watch_spec;
+
+typedef struct watcher watcher;
+
+/**
+ * watch_parse() - Parses the options and paths of the watch prefix.
+ *
+ * @param spec The options to fill in.
+ * @param argc The number of words, starting with "watch".
+ * @param argv The words.
+ * @return The number of words used by the prefix, up to and with "--", or -1
+ * on a bad option or a missing "--".
+ */
+int watch_parse(watch_spec *spec, int argc, char **argv);
+
+/**
+ * watch_start() - Starts watching the paths and adds the watcher to the wait
+ * loop.
+ *
+ * @param spec The options of the prefix.
+ * @param epoll_fd The epoll file descriptor of the wait loop.
+ * @return The watcher or NULL on failure.
+ */
+watcher *watch_start(const watch_spec *spec, int epoll_fd);
+
+/**
+ * watch_handle() - Handles a file descriptor which the wait loop found ready,
+ * if it belongs to the watcher.
+ *
+ * @param w The watcher.
+ * @param fd The ready file descriptor.
+ * @return 1 if the file descriptor belongs to the watcher, else 0.
+ */
+int watch_handle(watcher *w, int fd);
+
+/**
+ * watch_is_due() - Checks if changes have arrived and the debounce window
+ * after the last one has passed.
+ *
+ * @param w The watcher.
+ * @return 1 if a run is due, else 0.
+ */
+int watch_is_due(watcher *w);
+
+/**
+ * watch_clear() - Marks the changes which are due as run.
+ *
+ * @param w The watcher.
+ */
+void watch_clear(watcher *w);
+
+/**
+ * watch_stop() - Stops watching and frees the watcher. Closing its file
+ * descriptors also removes them from the wait loop.
+ *
+ * @param w The watcher.
+ */
+void watch_stop(watcher *w);
+
+#endif /* WATCH_H_ */